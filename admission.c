@@ -0,0 +1,131 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Controle de admissão. Fila: no estilo CoDel, o que conta é quanto os
+// pedidos esperaram, não quantos há. Se a espera medida ao tirar da fila
+// fica acima do alvo por um intervalo inteiro o servidor entra em
+// sobrecarga, e a partir daí todo pedido que esperou mais que o alvo recebe
+// 503 na hora em vez de ser atendido atrasado; a primeira espera abaixo do
+// alvo encerra a sobrecarga. Fila cheia é 503 imediato, sem esperar vaga.
+//
+// Taxa por cliente: token bucket por IPv4 numa tabela de tamanho fixo,
+// associativa em conjuntos de RATE_WAYS (um conjunto = uma linha de cache);
+// cliente novo num conjunto cheio ocupa o lugar do mais antigo.
+
+#define RATE_SETS 1024          // potência de 2: RATE_SETS * RATE_WAYS clientes
+#define RATE_WAYS 4
+#define RATE_LOCKS 64           // locks por faixa de conjuntos
+
+typedef struct {
+    uint32_t addr;              // IPv4 (ordem de rede)
+    float tokens;
+    long long last_us;          // última recarga (0 = livre)
+} rate_entry_t;
+
+static struct {
+    long long target_us;        // 0 = sem descarte por espera
+    long long interval_us;
+    _Atomic long long above_until_us; // espera acima do alvo desde então + intervalo (0 = abaixo)
+    _Atomic int overloaded;
+} codel;
+
+static struct {
+    double rate;                // tokens por segundo (0 = sem limite)
+    double burst;
+    _Alignas(CACHE_LINE) rate_entry_t table[RATE_SETS][RATE_WAYS];
+    pthread_mutex_t locks[RATE_LOCKS];
+} limiter;
+
+static const char *shed_names[SHED_COUNT] = {
+    [SHED_QUEUE_FULL] = "queue_full",
+    [SHED_QUEUE_DELAY] = "queue_delay",
+    [SHED_RATE_LIMIT] = "rate_limit",
+};
+
+const char *shed_name(shed_reason_t reason) {
+    return shed_names[reason];
+}
+
+void admission_init(const admission_config_t *cfg) {
+    codel.target_us = cfg->target_ms * 1000LL;
+    codel.interval_us = cfg->interval_ms * 1000LL;
+    limiter.rate = cfg->rate;
+    limiter.burst = cfg->burst > 0 ? cfg->burst : cfg->rate;
+    if (limiter.burst < 1) limiter.burst = 1;
+    for (int i = 0; i < RATE_LOCKS; i++) pthread_mutex_init(&limiter.locks[i], NULL);
+}
+
+int admission_dequeue(long long wait_us) {
+    if (!codel.target_us) return 0;
+    if (wait_us <= codel.target_us) {
+        atomic_store_explicit(&codel.above_until_us, 0, memory_order_relaxed);
+        if (atomic_exchange_explicit(&codel.overloaded, 0, memory_order_relaxed)) {
+            tslog_infof(server.logger, "[ADMISSAO] Fila normalizada (espera %lldms)", wait_us / 1000);
+        }
+        return 0;
+    }
+
+    long long now = stats_now_ns() / 1000;
+    long long until = atomic_load_explicit(&codel.above_until_us, memory_order_relaxed);
+    if (!until) {
+        // Primeira espera acima do alvo: a sobrecarga só vale se durar o intervalo
+        long long expected = 0;
+        atomic_compare_exchange_strong_explicit(&codel.above_until_us, &expected, now + codel.interval_us,
+                                                memory_order_relaxed, memory_order_relaxed);
+    } else if (now >= until && !atomic_exchange_explicit(&codel.overloaded, 1, memory_order_relaxed)) {
+        tslog_warnf(server.logger, "[ADMISSAO] Sobrecarga: espera na fila acima de %lldms por %lldms",
+                    codel.target_us / 1000, codel.interval_us / 1000);
+    }
+    return atomic_load_explicit(&codel.overloaded, memory_order_relaxed);
+}
+
+int admission_overloaded(void) {
+    return atomic_load_explicit(&codel.overloaded, memory_order_relaxed);
+}
+
+uint32_t client_address(int fd) {
+    if (limiter.rate <= 0) return 0;
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(fd, (struct sockaddr *)&addr, &len) < 0 || addr.sin_family != AF_INET) return 0;
+    return addr.sin_addr.s_addr;
+}
+
+int rate_limit_allow(uint32_t addr) {
+    if (limiter.rate <= 0 || !addr) return 1;
+    uint32_t h = addr * 2654435761u; // Knuth: espalha endereços vizinhos
+    unsigned set = (h >> 16) & (RATE_SETS - 1);
+    rate_entry_t *ways = limiter.table[set];
+    long long now = stats_now_ns() / 1000;
+
+    pthread_mutex_t *lock = &limiter.locks[set & (RATE_LOCKS - 1)];
+    pthread_mutex_lock(lock);
+    rate_entry_t *e = NULL, *oldest = &ways[0];
+    for (int i = 0; i < RATE_WAYS; i++) {
+        if (ways[i].last_us && ways[i].addr == addr) {
+            e = &ways[i];
+            break;
+        }
+        if (ways[i].last_us < oldest->last_us) oldest = &ways[i];
+    }
+    if (!e) {
+        // Cliente novo (ou descartado da tabela): começa com a rajada cheia
+        e = oldest;
+        e->addr = addr;
+        e->tokens = limiter.burst;
+    } else {
+        e->tokens += (now - e->last_us) * limiter.rate / 1e6;
+        if (e->tokens > limiter.burst) e->tokens = limiter.burst;
+    }
+    e->last_us = now;
+    int allowed = e->tokens >= 1;
+    if (allowed) e->tokens -= 1;
+    pthread_mutex_unlock(lock);
+    return allowed;
+}
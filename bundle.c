@@ -0,0 +1,614 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+// Bundle: a árvore de www/ empacotada num único arquivo que o servidor
+// mapeia com mmap. Cada entrada traz o MIME, os validadores, as variantes
+// (original, gzip, br) e o cabeçalho pronto de cada uma (200 e 304), então
+// servir não faz stat, open nem read. A busca é por hash perfeito
+// (hash-and-displace): o caminho cai num balde, a semente do balde leva a um
+// slot só dele e uma comparação confirma o caminho.
+//
+// Deploy: --pack escreve o arquivo novo ao lado e troca com rename; SIGHUP
+// faz o servidor mapear o novo. Respostas em andamento seguram uma
+// referência ao mapeamento antigo, desfeito quando a última termina.
+
+#define BUNDLE_MAGIC "WSBUNDLE"
+#define BUNDLE_VERSION 1
+#define BUNDLE_BUCKET_KEYS 4        // chaves por balde, em média
+#define BUNDLE_SEED_TRIES (1 << 20) // por balde, antes de aumentar a tabela
+#define BUNDLE_GROW_TRIES 32        // aumentos da tabela antes de desistir
+#define BUNDLE_ALIGN 16
+
+// Formato (ordem de bytes do host): cabeçalho, sementes dos baldes, slots
+// com as entradas e depois textos e corpos. Deslocamentos contam do início
+// do arquivo
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;             // arquivos
+    uint32_t buckets;
+    uint32_t slots;             // >= count; slot com path.len 0 está vazio
+    uint64_t seeds_offset;      // uint32_t[buckets]
+    uint64_t entries_offset;    // bundle_entry_t[slots]
+    uint64_t size;              // do arquivo inteiro: pega bundle truncado
+} bundle_header_t;
+
+typedef struct {
+    uint64_t offset;
+    uint64_t len;
+} bundle_span_t;
+
+typedef struct {
+    bundle_span_t body;
+    bundle_span_t header;       // 200 pronto, sem Cache-Control nem Connection
+    bundle_span_t header_304;
+} bundle_variant_t;
+
+typedef struct {
+    bundle_span_t path;         // "/dir/arquivo", com '\0' depois de len
+    bundle_span_t mime;         // com '\0' depois de len
+    bundle_variant_t variants[ENC_COUNT];
+    uint32_t present;           // 1 << enc das variantes guardadas
+    uint32_t vary;
+    int64_t mtime;
+    char etag[64];
+    char last_modified[32];
+} bundle_entry_t;
+
+struct bundle {
+    _Atomic int refs;           // 1 do servidor + 1 por resposta em andamento
+    const char *base;
+    size_t size;
+    const bundle_header_t *head;
+    const uint32_t *seeds;
+    const bundle_entry_t *entries;
+};
+
+static struct {
+    const char *path;           // NULL = servindo do disco
+    struct bundle *current;
+    pthread_rwlock_t lock;      // só para pegar a referência do atual
+    _Atomic int reload;
+} bundles = { .lock = PTHREAD_RWLOCK_INITIALIZER };
+
+// FNV-1a com semente e mistura final (os bits baixos do FNV variam pouco
+// com a semente)
+static uint64_t bundle_hash(const char *key, size_t len, uint32_t seed) {
+    uint64_t h = 1469598103934665603ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char)key[i];
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// ======================== EMPACOTAMENTO ========================
+
+typedef struct {
+    char *path;                 // relativo à raiz, com '/' inicial
+    const char *mime;
+    file_variants_t v;
+    char header[ENC_COUNT][2][RESPONSE_HEADER_MAX]; // [enc][0] = 200, [enc][1] = 304
+    size_t header_len[ENC_COUNT][2];
+    uint32_t slot;
+} pack_item_t;
+
+typedef struct {
+    char **paths;
+    size_t count, cap;
+} path_list_t;
+
+// x.gz/x.br ao lado de x vira variante de x, não arquivo próprio
+static int is_sibling(const char *full) {
+    size_t len = strlen(full);
+    for (int i = 1; i < ENC_COUNT; i++) {
+        size_t suffix = strlen(compress_suffix(i));
+        if (len <= suffix || strcmp(full + len - suffix, compress_suffix(i)) != 0) continue;
+        char original[1024];
+        snprintf(original, sizeof(original), "%.*s", (int)(len - suffix), full);
+        struct stat st;
+        if (stat(original, &st) == 0 && S_ISREG(st.st_mode)) return 1;
+    }
+    return 0;
+}
+
+static int collect(const char *root, const char *rel, path_list_t *list) {
+    char dir[1024];
+    snprintf(dir, sizeof(dir), "%s%s", root, rel);
+    DIR *d = opendir(dir);
+    if (!d) return -1;
+    struct dirent *ent;
+    int result = 0;
+    while (result == 0 && (ent = readdir(d)) != NULL) {
+        if (ent->d_name[0] == '.') continue; // ocultos, "." e ".."
+        char sub[1024], full[1024];
+        snprintf(sub, sizeof(sub), "%s/%s", rel, ent->d_name);
+        snprintf(full, sizeof(full), "%s%s", root, sub);
+        struct stat st;
+        if (stat(full, &st) != 0) continue;
+        if (S_ISDIR(st.st_mode)) {
+            result = collect(root, sub, list);
+            continue;
+        }
+        if (!S_ISREG(st.st_mode) || is_sibling(full)) continue;
+        if (list->count == list->cap) {
+            size_t cap = list->cap ? list->cap * 2 : 64;
+            char **grown = realloc(list->paths, cap * sizeof(char *));
+            if (!grown) {
+                result = -1;
+                break;
+            }
+            list->paths = grown;
+            list->cap = cap;
+        }
+        if (!(list->paths[list->count] = strdup(sub))) result = -1;
+        else list->count++;
+    }
+    closedir(d);
+    return result;
+}
+
+static int compare_paths(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int load_item(const char *root, pack_item_t *item) {
+    char full[1024];
+    snprintf(full, sizeof(full), "%s%s", root, item->path);
+    struct stat st;
+    long size;
+    if (stat(full, &st) != 0 || !(item->v.body[ENC_IDENTITY] = read_file(full, &size))) return -1;
+    item->v.len[ENC_IDENTITY] = size;
+    item->mime = get_mime_type(full);
+    file_meta_init(&item->v.meta, &st);
+    file_variants_load(full, item->mime, 1, &item->v);
+    // Cache-Control fica de fora: vem das regras do servidor na hora de servir
+    for (int i = 0; i < ENC_COUNT; i++) {
+        if (!item->v.body[i]) continue;
+        for (int nm = 0; nm < 2; nm++) {
+            item->header_len[i][nm] = format_ready_header(item->header[i][nm], RESPONSE_HEADER_MAX, nm,
+                                                          item->mime, item->v.len[i], i, item->v.vary,
+                                                          &item->v.meta, NULL);
+        }
+    }
+    return 0;
+}
+
+typedef struct {
+    uint32_t bucket, size;
+} bucket_order_t;
+
+static int compare_buckets(const void *a, const void *b) {
+    const bucket_order_t *x = a, *y = b;
+    return x->size != y->size ? (x->size < y->size ? 1 : -1) : (x->bucket > y->bucket) - (x->bucket < y->bucket);
+}
+
+// Hash-and-displace: baldes do maior para o menor; cada um fica com a
+// primeira semente que leva todas as suas chaves a slots ainda livres.
+// Retorna 1 se algum balde ficou sem semente (tabela pequena), -1 sem memória
+static int build_index(pack_item_t *items, uint32_t count, uint32_t buckets, uint32_t slots, uint32_t *seeds) {
+    uint32_t *start = calloc(buckets + 1, sizeof(uint32_t));
+    uint32_t *cursor = malloc(buckets * sizeof(uint32_t));
+    uint32_t *members = malloc((count ? count : 1) * sizeof(uint32_t));
+    uint32_t *bucket_of = malloc((count ? count : 1) * sizeof(uint32_t));
+    uint32_t *tried = malloc((count ? count : 1) * sizeof(uint32_t));
+    bucket_order_t *order = malloc(buckets * sizeof(bucket_order_t));
+    char *taken = calloc(slots ? slots : 1, 1);
+    int result = -1;
+    if (!start || !cursor || !members || !bucket_of || !tried || !order || !taken) goto done;
+    result = 1;
+
+    // Chaves agrupadas por balde (contagem + posições)
+    for (uint32_t i = 0; i < count; i++) {
+        bucket_of[i] = bundle_hash(items[i].path, strlen(items[i].path), 0) % buckets;
+        start[bucket_of[i] + 1]++;
+    }
+    for (uint32_t b = 0; b < buckets; b++) {
+        order[b].bucket = b;
+        order[b].size = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    memcpy(cursor, start, buckets * sizeof(uint32_t));
+    for (uint32_t i = 0; i < count; i++) members[cursor[bucket_of[i]]++] = i;
+    qsort(order, buckets, sizeof(bucket_order_t), compare_buckets);
+
+    for (uint32_t o = 0; o < buckets; o++) {
+        uint32_t b = order[o].bucket, n = order[o].size;
+        seeds[b] = 0;
+        if (n == 0) continue;
+        uint32_t seed;
+        for (seed = 1; seed < BUNDLE_SEED_TRIES; seed++) {
+            uint32_t k;
+            for (k = 0; k < n; k++) {
+                const char *path = items[members[start[b] + k]].path;
+                uint32_t slot = bundle_hash(path, strlen(path), seed) % slots;
+                if (taken[slot]) break;
+                taken[slot] = 1; // marca já: duas chaves do balde não podem cair juntas
+                tried[k] = slot;
+            }
+            if (k == n) break;
+            while (k > 0) taken[tried[--k]] = 0;
+        }
+        if (seed == BUNDLE_SEED_TRIES) goto done;
+        seeds[b] = seed;
+        for (uint32_t k = 0; k < n; k++) items[members[start[b] + k]].slot = tried[k];
+    }
+    result = 0;
+
+done:
+    free(start);
+    free(cursor);
+    free(members);
+    free(bucket_of);
+    free(tried);
+    free(order);
+    free(taken);
+    return result;
+}
+
+// Pedaços do arquivo na ordem em que são escritos
+typedef struct {
+    const void *data;
+    uint64_t offset, len;
+} piece_t;
+
+typedef struct {
+    piece_t *pieces;
+    size_t count, cap;
+    uint64_t size;
+    int failed;                 // sem memória para a lista
+} layout_t;
+
+static bundle_span_t place(layout_t *layout, const void *data, uint64_t len, uint64_t align) {
+    bundle_span_t span = { (layout->size + align - 1) / align * align, len };
+    if (layout->count == layout->cap) {
+        size_t cap = layout->cap ? layout->cap * 2 : 256;
+        piece_t *grown = realloc(layout->pieces, cap * sizeof(piece_t));
+        if (!grown) {
+            layout->failed = 1;
+            return span;
+        }
+        layout->pieces = grown;
+        layout->cap = cap;
+    }
+    layout->pieces[layout->count++] = (piece_t){ data, span.offset, len };
+    layout->size = span.offset + len;
+    return span;
+}
+
+static int write_layout(const layout_t *layout, const char *path) {
+    static const char zeros[BUNDLE_ALIGN];
+    FILE *f = fopen(path, "wb");
+    if (!f) return -1;
+    uint64_t pos = 0;
+    for (size_t i = 0; i < layout->count; i++) {
+        const piece_t *p = &layout->pieces[i];
+        if (fwrite(zeros, 1, p->offset - pos, f) != p->offset - pos ||
+            fwrite(p->data, 1, p->len, f) != p->len) {
+            fclose(f);
+            return -1;
+        }
+        pos = p->offset + p->len;
+    }
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) {
+        fclose(f);
+        return -1;
+    }
+    return fclose(f);
+}
+
+int bundle_pack(const char *root, const char *out_path) {
+    path_list_t list = { 0 };
+    if (collect(root, "", &list) < 0) {
+        fprintf(stderr, "Erro ao ler %s: %s\n", root, strerror(errno));
+        for (size_t i = 0; i < list.count; i++) free(list.paths[i]);
+        free(list.paths);
+        return -1;
+    }
+    qsort(list.paths, list.count, sizeof(char *), compare_paths); // bundle reprodutível
+
+    uint32_t count = (uint32_t)list.count;
+    uint32_t buckets = count / BUNDLE_BUCKET_KEYS + 1;
+    uint32_t slots = count ? count : 1;
+    pack_item_t *items = calloc(count ? count : 1, sizeof(pack_item_t));
+    uint32_t *seeds = calloc(buckets, sizeof(uint32_t));
+    bundle_entry_t *entries = NULL;
+    layout_t layout = { 0 };
+    bundle_header_t head = { .version = BUNDLE_VERSION, .count = count, .buckets = buckets };
+    char tmp_path[1024];
+    int result = -1;
+    if (!items || !seeds) goto done;
+
+    for (uint32_t i = 0; i < count; i++) {
+        items[i].path = list.paths[i];
+        if (load_item(root, &items[i]) < 0) {
+            fprintf(stderr, "Erro ao ler %s%s: %s\n", root, items[i].path, strerror(errno));
+            goto done;
+        }
+    }
+    // Sem semente para algum balde: tabela um pouco maior e de novo
+    int indexed, grown = 0;
+    while ((indexed = build_index(items, count, buckets, slots, seeds)) > 0 && grown++ < BUNDLE_GROW_TRIES) {
+        slots += slots / 8 + 1;
+    }
+    if (indexed != 0) {
+        fprintf(stderr, "Erro ao montar o indice de %s: %s\n", root,
+                indexed < 0 ? "sem memoria" : "nenhuma semente serviu");
+        goto done;
+    }
+
+    memcpy(head.magic, BUNDLE_MAGIC, sizeof(head.magic));
+    head.slots = slots;
+    entries = calloc(slots, sizeof(bundle_entry_t));
+    if (!entries) goto done;
+    place(&layout, &head, sizeof(head), 8);
+    head.seeds_offset = place(&layout, seeds, buckets * sizeof(uint32_t), 8).offset;
+    head.entries_offset = place(&layout, entries, slots * sizeof(bundle_entry_t), 8).offset;
+    for (uint32_t i = 0; i < count; i++) {
+        pack_item_t *item = &items[i];
+        bundle_entry_t *e = &entries[item->slot];
+        e->path = place(&layout, item->path, strlen(item->path) + 1, 1);
+        e->path.len--;
+        e->mime = place(&layout, item->mime, strlen(item->mime) + 1, 1);
+        e->mime.len--;
+        for (int v = 0; v < ENC_COUNT; v++) {
+            if (!item->v.body[v]) continue;
+            e->present |= 1u << v;
+            e->variants[v].header = place(&layout, item->header[v][0], item->header_len[v][0], 1);
+            e->variants[v].header_304 = place(&layout, item->header[v][1], item->header_len[v][1], 1);
+        }
+        e->vary = item->v.vary;
+        e->mtime = item->v.meta.mtime;
+        memcpy(e->etag, item->v.meta.etag, sizeof(e->etag));
+        memcpy(e->last_modified, item->v.meta.last_modified, sizeof(e->last_modified));
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        for (int v = 0; v < ENC_COUNT; v++) {
+            if (!items[i].v.body[v]) continue;
+            entries[items[i].slot].variants[v].body = place(&layout, items[i].v.body[v], items[i].v.len[v],
+                                                            BUNDLE_ALIGN);
+        }
+    }
+    if (layout.failed) goto done;
+    head.size = layout.size;
+
+    // Escreve ao lado e troca de uma vez: quem abrir o caminho vê o antigo ou o novo inteiro
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path);
+    if (write_layout(&layout, tmp_path) < 0 || rename(tmp_path, out_path) < 0) {
+        fprintf(stderr, "Erro ao escrever %s: %s\n", out_path, strerror(errno));
+        unlink(tmp_path);
+        goto done;
+    }
+    printf("Bundle %s: %u arquivos de %s/, %llu bytes (%u slots, %u baldes)\n",
+           out_path, count, root, (unsigned long long)head.size, slots, buckets);
+    result = 0;
+
+done:
+    for (uint32_t i = 0; items && i < count; i++) {
+        for (int v = 0; v < ENC_COUNT; v++) free(items[i].v.body[v]);
+    }
+    for (size_t i = 0; i < list.count; i++) free(list.paths[i]);
+    free(list.paths);
+    free(items);
+    free(seeds);
+    free(entries);
+    free(layout.pieces);
+    return result;
+}
+
+// ======================== SERVIÇO ========================
+
+static int span_ok(const struct bundle *b, bundle_span_t span) {
+    return span.offset <= b->size && span.len <= b->size - span.offset;
+}
+
+// Texto com '\0' logo depois de len, dentro do arquivo
+static int string_ok(const struct bundle *b, bundle_span_t span) {
+    return span.len < b->size && span_ok(b, (bundle_span_t){ span.offset, span.len + 1 }) &&
+           b->base[span.offset + span.len] == '\0';
+}
+
+// Confere o índice inteiro uma vez: depois disso os pedidos só seguem
+// deslocamentos já validados
+static int bundle_valid(const struct bundle *b) {
+    const bundle_header_t *h = b->head;
+    if (memcmp(h->magic, BUNDLE_MAGIC, sizeof(h->magic)) != 0 || h->version != BUNDLE_VERSION ||
+        h->size != b->size || h->buckets == 0 || h->slots < h->count || h->slots == 0 ||
+        h->seeds_offset % 4 || h->entries_offset % 8 ||
+        !span_ok(b, (bundle_span_t){ h->seeds_offset, (uint64_t)h->buckets * sizeof(uint32_t) }) ||
+        !span_ok(b, (bundle_span_t){ h->entries_offset, (uint64_t)h->slots * sizeof(bundle_entry_t) })) {
+        return 0;
+    }
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < h->slots; i++) {
+        const bundle_entry_t *e = &b->entries[i];
+        if (e->path.len == 0) continue;
+        used++;
+        if (!string_ok(b, e->path) || !string_ok(b, e->mime) || !(e->present & 1) ||
+            !memchr(e->etag, '\0', sizeof(e->etag)) || !memchr(e->last_modified, '\0', sizeof(e->last_modified))) {
+            return 0;
+        }
+        for (int v = 0; v < ENC_COUNT; v++) {
+            const bundle_variant_t *var = &e->variants[v];
+            if ((e->present & (1u << v)) &&
+                (!span_ok(b, var->body) || !span_ok(b, var->header) || !span_ok(b, var->header_304))) {
+                return 0;
+            }
+        }
+    }
+    return used == h->count;
+}
+
+static struct bundle *bundle_map(const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(bundle_header_t)) {
+        close(fd);
+        errno = EINVAL;
+        return NULL;
+    }
+    // O mapeamento segura o inode: um rename por cima não afeta quem já mapeou
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return NULL;
+
+    struct bundle *b = calloc(1, sizeof(*b));
+    if (!b) {
+        munmap(base, st.st_size);
+        errno = ENOMEM;
+        return NULL;
+    }
+    b->base = base;
+    b->size = st.st_size;
+    b->head = base;
+    b->seeds = (const uint32_t *)(b->base + b->head->seeds_offset);
+    b->entries = (const bundle_entry_t *)(b->base + b->head->entries_offset);
+    if (!bundle_valid(b)) {
+        munmap(base, st.st_size);
+        free(b);
+        errno = EINVAL;
+        return NULL;
+    }
+    atomic_init(&b->refs, 1);
+    return b;
+}
+
+int bundle_open(const char *path) {
+    struct bundle *b = bundle_map(path);
+    if (!b) return -1;
+    bundles.path = path;
+    bundles.current = b;
+    tslog_infof(server.logger, "[BUNDLE] %s: %u arquivos, %zu bytes", path, b->head->count, b->size);
+    return 0;
+}
+
+void bundle_close(void) {
+    bundle_release(bundles.current);
+    bundles.current = NULL;
+    bundles.path = NULL;
+}
+
+void bundle_request_reload(void) {
+    atomic_store_explicit(&bundles.reload, 1, memory_order_relaxed);
+}
+
+void bundle_release(struct bundle *b) {
+    if (b && atomic_fetch_sub_explicit(&b->refs, 1, memory_order_acq_rel) == 1) {
+        munmap((void *)b->base, b->size);
+        free(b);
+    }
+}
+
+// Deploy: mapeia o arquivo que está agora no caminho; se não abrir ou não
+// validar, segue com o anterior
+static void bundle_reload(void) {
+    struct bundle *fresh = bundle_map(bundles.path);
+    if (!fresh) {
+        tslog_errorf(server.logger, "[BUNDLE] %s: %s, mantendo o anterior", bundles.path, strerror(errno));
+        return;
+    }
+    pthread_rwlock_wrlock(&bundles.lock);
+    struct bundle *old = bundles.current;
+    bundles.current = fresh;
+    pthread_rwlock_unlock(&bundles.lock);
+    bundle_release(old);
+    tslog_infof(server.logger, "[BUNDLE] %s remapeado: %u arquivos, %zu bytes",
+                bundles.path, fresh->head->count, fresh->size);
+}
+
+static const bundle_entry_t *bundle_lookup(const struct bundle *b, const char *path, size_t len) {
+    const bundle_header_t *h = b->head;
+    if (h->count == 0 || len == 0) return NULL;
+    uint32_t seed = b->seeds[bundle_hash(path, len, 0) % h->buckets];
+    const bundle_entry_t *e = &b->entries[bundle_hash(path, len, seed) % h->slots];
+    if (e->path.len != len || memcmp(b->base + e->path.offset, path, len) != 0) return NULL;
+    return e;
+}
+
+int bundle_serve(request_t *req, response_t *res) {
+    if (!bundles.path) return 0;
+    if (atomic_load_explicit(&bundles.reload, memory_order_relaxed) &&
+        atomic_exchange_explicit(&bundles.reload, 0, memory_order_acq_rel)) {
+        bundle_reload();
+    }
+    pthread_rwlock_rdlock(&bundles.lock);
+    struct bundle *b = bundles.current;
+    atomic_fetch_add_explicit(&b->refs, 1, memory_order_relaxed);
+    pthread_rwlock_unlock(&bundles.lock);
+
+    // Alvo pela rota: "/" vira "/index.html", "/about" tenta "/about.html"
+    char path[512] = "";
+    const bundle_entry_t *e = NULL;
+    for (int attempt = 0; !e; attempt++) {
+        char candidate[512];
+        if (!route_target(req, attempt, candidate, sizeof(candidate))) break;
+        e = bundle_lookup(b, candidate, strlen(candidate));
+        if (e || attempt == 0) memcpy(path, candidate, sizeof(path));
+    }
+    if (!e) {
+        bundle_release(b);
+        set_error_response(res, HTTP_404);
+        tslog_infof(server.logger, "[RES #%d] 404 Not Found - bundle:%s", req->id, path);
+        return 1;
+    }
+
+    file_meta_t meta;
+    memcpy(meta.etag, e->etag, sizeof(meta.etag));
+    memcpy(meta.last_modified, e->last_modified, sizeof(meta.last_modified));
+    meta.mtime = e->mtime;
+    // Menor variante aceita
+    int accepted = compress_accepted(req->http.headers[HTTP_HDR_ACCEPT_ENCODING]);
+    content_encoding_t enc = ENC_IDENTITY;
+    for (int i = 1; i < ENC_COUNT; i++) {
+        if ((e->present & (1u << i)) && (accepted & (1 << i)) &&
+            e->variants[i].body.len < e->variants[enc].body.len) enc = i;
+    }
+    const bundle_variant_t *v = &e->variants[enc];
+    const char *file = b->base + e->path.offset;
+    int not_modified = http_not_modified(&req->http, &meta, enc);
+
+    res->status = not_modified ? "304 Not Modified" : "200 OK";
+    res->mime_type = b->base + e->mime.offset;
+    res->body = not_modified ? NULL : b->base + v->body.offset;
+    res->body_len = not_modified ? 0 : (long)v->body.len;
+    res->owned = NULL;
+    res->header = b->base + (not_modified ? v->header_304.offset : v->header.offset);
+    res->header_len = not_modified ? v->header_304.len : v->header.len;
+    res->cached = NULL;
+    res->bundle = b;
+    res->file_fd = -1;
+    res->file_offset = 0;
+    res->multipart = NULL;
+    res->encoding = compress_name(enc);
+    res->vary = 0; // já no cabeçalho pronto
+    res->extra[0] = '\0';
+    const char *cache_control = cache_control_rule(file);
+    int ranged = !not_modified && req->http.headers[HTTP_HDR_RANGE].len > 0;
+    if (cache_control || ranged) {
+        // Cache-Control das regras do servidor ou 206/416: cabeçalho montado por response_prepare
+        res->header = NULL;
+        res->vary = e->vary;
+        file_meta_headers(res->extra, sizeof(res->extra), &meta, enc, cache_control);
+        if (ranged) response_apply_range(&req->http, &meta, enc, res);
+    }
+    tslog_infof(server.logger, "[RES #%d] %s - bundle:%s%s%s%s", req->id, res->status, file,
+                res->encoding ? " (" : "", res->encoding ? res->encoding : "", res->encoding ? ")" : "");
+    return 1;
+}
@@ -0,0 +1,148 @@
+#include "web_server.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+#ifdef HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+// Negociação de Content-Encoding e compressão dos corpos guardados no cache.
+// Cada arquivo é comprimido uma vez ao entrar no cache (ou vem pronto de um
+// irmão .gz/.br em www/); as requisições só escolhem a variante.
+
+#define GZIP_LEVEL 6
+#define BROTLI_QUALITY 9        // comprime uma vez só: vale gastar mais CPU
+
+static const struct {
+    const char *name;
+    const char *suffix;
+} encodings[ENC_COUNT] = {
+    [ENC_IDENTITY] = { NULL, NULL },
+    [ENC_GZIP] = { "gzip", ".gz" },
+    [ENC_BR] = { "br", ".br" },
+};
+
+const char *compress_name(content_encoding_t enc) {
+    return encodings[enc].name;
+}
+
+const char *compress_suffix(content_encoding_t enc) {
+    return encodings[enc].suffix;
+}
+
+static int token_is(const char *tok, size_t len, const char *name) {
+    return strlen(name) == len && strncasecmp(tok, name, len) == 0;
+}
+
+// "q=0", "q=0.0", "q=0.000" recusam; qualquer outro valor aceita
+static int q_is_zero(const char *p, const char *end) {
+    if (p >= end || *p != '0') return 0;
+    for (p++; p < end && *p == '.'; p++) {}
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (*p != '0') return 0;
+    }
+    return 1;
+}
+
+int compress_accepted(http_slice_t accept) {
+    int listed = 0, refused = 0, star = 0;
+    const char *p = accept.ptr, *end = accept.ptr + accept.len;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        const char *tok = p;
+        while (p < end && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') p++;
+        size_t tok_len = p - tok;
+
+        int zero = 0;
+        while (p < end && *p != ',') {
+            if (*p == ';') {
+                for (p++; p < end && (*p == ' ' || *p == '\t'); p++) {}
+                if (end - p >= 2 && (*p == 'q' || *p == 'Q') && p[1] == '=') zero = q_is_zero(p + 2, end);
+                continue;
+            }
+            p++;
+        }
+        if (tok_len == 0) continue;
+
+        int bit = 0;
+        if (token_is(tok, tok_len, "gzip") || token_is(tok, tok_len, "x-gzip")) bit = 1 << ENC_GZIP;
+        else if (token_is(tok, tok_len, "br")) bit = 1 << ENC_BR;
+        else if (token_is(tok, tok_len, "*")) star = !zero;
+        listed |= bit;
+        if (zero) refused |= bit;
+    }
+
+    int mask = (1 << ENC_IDENTITY) | (listed & ~refused);
+    if (star) mask |= ~listed & ((1 << ENC_COUNT) - 1); // "*" vale para o que não foi citado
+    return mask;
+}
+
+int compress_mime(const char *mime) {
+    return strncmp(mime, "text/", 5) == 0 ||
+           strcmp(mime, "application/javascript") == 0 ||
+           strcmp(mime, "application/json") == 0 ||
+           strcmp(mime, "image/svg+xml") == 0;
+}
+
+static char *gzip_body(const char *data, size_t len, size_t *out_len) {
+    z_stream zs = {0};
+    // windowBits 15 + 16: cabeçalho e rodapé gzip em vez de zlib
+    if (deflateInit2(&zs, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) return NULL;
+    size_t cap = deflateBound(&zs, len);
+    char *out = malloc(cap);
+    if (!out) {
+        deflateEnd(&zs);
+        return NULL;
+    }
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = len;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = cap;
+    int r = deflate(&zs, Z_FINISH);
+    *out_len = zs.total_out;
+    deflateEnd(&zs);
+    if (r != Z_STREAM_END) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+
+#ifdef HAVE_BROTLI
+static char *brotli_body(const char *data, size_t len, size_t *out_len) {
+    size_t cap = BrotliEncoderMaxCompressedSize(len);
+    char *out = cap ? malloc(cap) : NULL;
+    if (!out) return NULL;
+    *out_len = cap;
+    if (!BrotliEncoderCompress(BROTLI_QUALITY, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                               len, (const uint8_t *)data, out_len, (uint8_t *)out)) {
+        free(out);
+        return NULL;
+    }
+    return out;
+}
+#endif
+
+char *compress_body(content_encoding_t enc, const char *data, size_t len, size_t *out_len) {
+    char *out = NULL;
+    if (enc == ENC_GZIP) out = gzip_body(data, len, out_len);
+#ifdef HAVE_BROTLI
+    if (enc == ENC_BR) out = brotli_body(data, len, out_len);
+#endif
+    // Só vale guardar se diminuiu
+    if (out && *out_len >= len) {
+        free(out);
+        out = NULL;
+    }
+    return out;
+}
+
+int compress_available(content_encoding_t enc) {
+#ifdef HAVE_BROTLI
+    return enc == ENC_GZIP || enc == ENC_BR;
+#else
+    return enc == ENC_GZIP;
+#endif
+}
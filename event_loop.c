@@ -0,0 +1,632 @@
+#define _GNU_SOURCE
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// Modo epoll: cada loop é dono das conexões que aceita e nunca bloqueia.
+// Leitura e parse são incrementais; só o que bloqueia (stat/leitura do
+// arquivo) vai para o pool de workers, que devolve a conexão pelo eventfd.
+// Os prazos (cabeçalho, keep-alive, escrita) ficam numa roda de
+// temporizadores por loop, sem lock.
+//
+// Com --mode uring o mesmo loop troca o epoll por um io_uring: accept
+// multishot, recv em buffers fornecidos pelo anel, envio por sendmsg e
+// arquivos grandes por leitura encadeada ao envio. Cada operação conclui
+// com a conexão em user_data e retoma a mesma máquina de estados; todas as
+// SQEs de uma volta saem num único io_uring_enter.
+
+#define MAX_EVENTS 256
+#define EPOLL_TIMEOUT_MS 500    // para perceber o fim de g_running
+#define RETRY_TIMEOUT_MS 10     // com pedidos esperando vaga na fila
+#define WHEEL_SLOTS 1024
+#define WHEEL_TICK_MS 100
+#define URING_ENTRIES 1024
+#define URING_BUFFERS 1024      // buffers fornecidos para recv, por loop
+#define URING_FILE_CHUNK (256 * 1024) // leitura do arquivo por envio encadeado
+
+// Operação no user_data do io_uring: bits baixos da conexão (ou sozinha,
+// para as do loop)
+enum { OP_ACCEPT = 1, OP_WAKE, OP_RECV, OP_SEND, OP_READ };
+#define OP_MASK 7
+
+typedef enum {
+    CONN_READING = 0,
+    CONN_PROCESSING,            // nas mãos de um worker
+    CONN_WRITING
+} conn_state_t;
+
+typedef struct event_loop event_loop_t;
+
+typedef struct conn {
+    timer_node_t timer;         // primeiro membro: o nó vencido é a conexão
+    deadline_kind_t deadline;   // prazo armado em timer
+    int fd;
+    conn_state_t state;
+    event_loop_t *loop;
+    struct conn *next;          // lista de concluídos ou de espera por vaga
+    struct conn *prev_all, *next_all; // todas as conexões do loop
+    request_t req;
+    char header[RESPONSE_HEADER_MAX]; // cabeçalho montado quando não vem pronto
+    size_t sent;                // bytes já enviados (cabeçalho + corpo)
+    int served;                 // pedidos atendidos nesta conexão
+    int pending;                // io_uring: operações em voo; só libera com zero
+    int closing;                // io_uring: fechada, esperando as operações em voo
+    response_chunk_t chunk;     // io_uring: trecho em envio
+    struct msghdr msg;
+    char *file_buf;             // io_uring: pedaço do arquivo lido para envio (só durante a resposta)
+    size_t in_len;
+    char in[BUFFER_SIZE];
+} conn_t;
+
+struct event_loop {
+    int id;
+    int epfd;
+    int listen_fd;
+    int wake_fd;                // eventfd sinalizado pelos workers
+    pthread_t thread;
+    pthread_mutex_t done_mutex;
+    conn_t *done;               // conexões devolvidas pelos workers
+    conn_t *wait_head, *wait_tail; // pedidos aguardando vaga na fila
+    conn_t *all;
+    timer_wheel_t wheel;        // prazos das conexões deste loop
+    uring_t *ring;              // backend io_uring (NULL = epoll)
+    uint64_t wake_value;        // destino da leitura do eventfd pelo io_uring
+    unsigned long accepted;
+};
+
+static event_loop_t *loops;
+static int loop_count;
+static slab_t *conn_slab;
+static slab_t *chunk_slab;      // pedaços de arquivo do io_uring
+
+// Marcadores em epoll_data para os descritores que não são conexões
+static char listen_tag, wake_tag;
+
+static void conn_read(conn_t *conn);
+
+// Arma (ou rearma) o prazo da conexão; duração 0 = sem prazo
+static void conn_deadline(conn_t *conn, deadline_kind_t kind) {
+    long ms = deadline_ms(kind);
+    conn->deadline = kind;
+    if (ms > 0) timer_wheel_arm(&conn->loop->wheel, &conn->timer, timer_now_ms() + ms);
+    else timer_wheel_cancel(&conn->timer);
+}
+
+static unsigned long long op_data(conn_t *conn, int op) {
+    return (uintptr_t)conn | op;
+}
+
+// Pedaço de leitura do arquivo: volta ao slab no fim da resposta, então
+// conexões paradas no keep-alive não seguram memória
+static void release_file_buf(conn_t *conn) {
+    slab_free(chunk_slab, conn->file_buf);
+    conn->file_buf = NULL;
+}
+
+static void conn_free(conn_t *conn) {
+    event_loop_t *loop = conn->loop;
+    timer_wheel_cancel(&conn->timer);
+    if (conn->prev_all) conn->prev_all->next_all = conn->next_all;
+    else loop->all = conn->next_all;
+    if (conn->next_all) conn->next_all->prev_all = conn->prev_all;
+    response_free(&conn->req.res);
+    close(conn->fd); // também remove o fd do epoll
+    release_file_buf(conn);
+    slab_free(conn_slab, conn);
+}
+
+static void conn_close(conn_t *conn) {
+    timer_wheel_cancel(&conn->timer);
+    if (conn->pending) {
+        // io_uring: o kernel ainda usa a conexão. O shutdown conclui o que
+        // está em voo e a última conclusão libera
+        if (!conn->closing) shutdown(conn->fd, SHUT_RDWR);
+        conn->closing = 1;
+        return;
+    }
+    conn_free(conn);
+}
+
+// io_uring: submete o próximo trecho da resposta; 1 = em voo, 0 = terminou
+static int uring_send_next(conn_t *conn) {
+    uring_t *ring = conn->loop->ring;
+    response_chunk_t *chunk = &conn->chunk;
+    if (!response_chunk(&conn->req.res, conn->sent, chunk)) return 0;
+    int flags = chunk->more ? MSG_MORE : 0;
+    if (chunk->iov_count) {
+        conn->msg = (struct msghdr){ .msg_iov = chunk->iov, .msg_iovlen = chunk->iov_count };
+        if (uring_sendmsg(ring, conn->fd, &conn->msg, flags, op_data(conn, OP_SEND)) < 0) return -1;
+        conn->pending++;
+        return 1;
+    }
+    // Sem sendfile no io_uring: um pedaço do arquivo lido e enviado em cadeia
+    if (!conn->file_buf && !(conn->file_buf = slab_alloc(chunk_slab))) return -1;
+    if (chunk->file_len > URING_FILE_CHUNK) {
+        chunk->file_len = URING_FILE_CHUNK;
+        flags |= MSG_MORE;
+    }
+    if (uring_read_send(ring, chunk->file_fd, chunk->file_offset, conn->fd, conn->file_buf,
+                        chunk->file_len, flags, op_data(conn, OP_READ), op_data(conn, OP_SEND)) < 0) {
+        return -1;
+    }
+    conn->pending += 2;
+    return 1;
+}
+
+static void conn_write(conn_t *conn) {
+    response_t *res = &conn->req.res;
+    size_t before = conn->sent;
+    long long started = stats_now_ns();
+    int result = conn->loop->ring ? uring_send_next(conn) : response_send(conn->fd, res, &conn->sent);
+    conn->req.send_ns += stats_now_ns() - started;
+    if (result == 1) {
+        // Espera EPOLLOUT (ou a conclusão do envio); o prazo conta desde o último byte aceito
+        if (conn->sent != before || !timer_armed(&conn->timer)) conn_deadline(conn, DEADLINE_WRITE);
+        return;
+    }
+
+    stats_time(STAT_SEND, conn->req.send_ns);
+    stats_response(res->status, conn->sent);
+    conn->req.send_ns = 0;
+    release_file_buf(conn);
+
+    if (result < 0 || !res->keep_alive) {
+        conn_close(conn);
+        return;
+    }
+
+    // Keep-alive: descarta o pedido atendido; o resto do buffer pode já
+    // conter o próximo (pipelining), senão espera mais dados
+    response_free(res);
+    memmove(conn->in, conn->in + conn->req.length, conn->in_len - conn->req.length);
+    conn->in_len -= conn->req.length;
+    http_parser_init(&conn->req.http, sizeof(conn->in));
+    conn->state = CONN_READING;
+    conn->req.id = get_next_request_id();
+    conn_deadline(conn, conn->in_len ? DEADLINE_HEADER : DEADLINE_IDLE);
+    conn_read(conn);
+}
+
+static void conn_respond(conn_t *conn) {
+    conn->served++;
+    conn->req.res.keep_alive = conn->req.keep_alive &&
+        (server.max_requests == 0 || conn->served < server.max_requests);
+    conn->state = CONN_WRITING;
+    timer_wheel_cancel(&conn->timer);
+    response_prepare(&conn->req.res, conn->header, sizeof(conn->header));
+    conn->sent = 0;
+    conn_write(conn);
+}
+
+// Entrega o pedido aos workers; se a fila estiver cheia ele espera no loop,
+// a não ser em sobrecarga: aí leva 503 na hora
+static void conn_offload(conn_t *conn) {
+    event_loop_t *loop = conn->loop;
+    conn->state = CONN_PROCESSING;
+    if (!loop->wait_head && work_queue_try_push(server.work_queue, &conn->req) == 0) return;
+    if (admission_overloaded()) {
+        stats_shed(SHED_QUEUE_FULL);
+        set_error_response(&conn->req.res, HTTP_503);
+        conn->req.keep_alive = 0;
+        conn_respond(conn);
+        return;
+    }
+    conn->next = NULL;
+    if (loop->wait_tail) loop->wait_tail->next = conn;
+    else loop->wait_head = conn;
+    loop->wait_tail = conn;
+}
+
+static void retry_waiting(event_loop_t *loop) {
+    while (loop->wait_head) {
+        conn_t *conn = loop->wait_head;
+        conn_t *next = conn->next; // após o push o worker pode reusar conn->next
+        if (work_queue_try_push(server.work_queue, &conn->req) < 0) return;
+        loop->wait_head = next;
+        if (!next) loop->wait_tail = NULL;
+    }
+}
+
+static void conn_received(conn_t *conn, size_t len) {
+    // Primeiro byte do próximo pedido: o prazo passa a ser o do cabeçalho,
+    // contado daqui e sem renovar a cada byte (slowloris)
+    if (conn->in_len == 0 && conn->deadline == DEADLINE_IDLE) conn_deadline(conn, DEADLINE_HEADER);
+    conn->in_len += len;
+}
+
+static void conn_read(conn_t *conn) {
+    http_parse_result_t result;
+    for (;;) {
+        long long started = stats_now_ns();
+        result = http_parse(&conn->req.http, conn->in, conn->in_len);
+        conn->req.parse_ns += stats_now_ns() - started;
+        if (result != HTTP_PARSE_AGAIN) break;
+
+        if (conn->loop->ring) {
+            // io_uring: o recv volta como conclusão e retoma aqui
+            if (uring_recv(conn->loop->ring, conn->fd, sizeof(conn->in) - conn->in_len,
+                           op_data(conn, OP_RECV)) < 0) {
+                conn_close(conn);
+                return;
+            }
+            conn->pending++;
+            return;
+        }
+        ssize_t r = recv(conn->fd, conn->in + conn->in_len, sizeof(conn->in) - conn->in_len, 0);
+        if (r > 0) {
+            conn_received(conn, r);
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return; // ainda incompleto
+        conn_close(conn); // EOF ou erro antes do fim do cabeçalho
+        return;
+    }
+
+    // Pedido completo: nas mãos do worker não há prazo
+    timer_wheel_cancel(&conn->timer);
+
+    // As fatias apontam para conn->in, que só muda depois da resposta
+    int ready = begin_request(&conn->req, result, conn->in_len, &conn->req.res);
+
+    // Acerto no cache responde aqui mesmo; só a falta vai para o disco
+    if (ready == 0 && !serve_cached(&conn->req, &conn->req.res)) {
+        conn_offload(conn);
+    } else {
+        conn_respond(conn);
+    }
+}
+
+// Fecha as conexões cujo prazo venceu (só as em leitura ou escrita têm prazo)
+static void expire_deadlines(event_loop_t *loop) {
+    timer_node_t *t = timer_wheel_expire(&loop->wheel, timer_now_ms());
+    while (t) {
+        timer_node_t *next = t->next;
+        conn_t *conn = (conn_t *)t;
+        stats_timeout(conn->deadline);
+        tslog_debugf(server.logger, "[LOOP %d] prazo %s vencido, fechando conexao",
+                     loop->id, deadline_name(conn->deadline));
+        // Escrita parada: RST em vez de FIN, senão o kernel segue tentando
+        // entregar o resto. Nos demais o FIN ainda entrega o que já foi enviado
+        if (conn->deadline == DEADLINE_WRITE) {
+            struct linger reset = { 1, 0 };
+            setsockopt(conn->fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        }
+        conn_close(conn);
+        t = next;
+    }
+}
+
+static conn_t *conn_open(event_loop_t *loop, int fd) {
+    conn_t *conn = slab_alloc(conn_slab);
+    if (!conn) {
+        close(fd);
+        return NULL;
+    }
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = fd;
+    conn->loop = loop;
+    conn->req.socket = fd;
+    conn->req.id = get_next_request_id();
+    conn->req.client = client_address(fd);
+    conn->req.conn = conn;
+    conn->req.res.arena = &conn->req.arena;
+    http_parser_init(&conn->req.http, sizeof(conn->in));
+    conn_deadline(conn, DEADLINE_HEADER);
+    conn->next_all = loop->all;
+    if (loop->all) loop->all->prev_all = conn;
+    loop->all = conn;
+    loop->accepted++;
+    return conn;
+}
+
+static void accept_all(event_loop_t *loop) {
+    for (;;) {
+        int fd = accept4(loop->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EMFILE || errno == ENFILE) {
+                tslog_warnf(server.logger, "[LOOP %d] Limite de descritores atingido", loop->id);
+            }
+            return; // EAGAIN: outro loop pegou ou não há mais conexões
+        }
+
+        conn_t *conn = conn_open(loop, fd);
+        if (!conn) continue;
+
+        // Edge-triggered: EPOLLOUT só dispara de novo quando o buffer esvazia
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLET, .data.ptr = conn };
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            conn_close(conn);
+        }
+    }
+}
+
+static void drain_done(event_loop_t *loop) {
+    uint64_t value;
+    // No io_uring a leitura do eventfd foi a própria operação concluída
+    while (!loop->ring && read(loop->wake_fd, &value, sizeof(value)) < 0 && errno == EINTR) {}
+
+    pthread_mutex_lock(&loop->done_mutex);
+    conn_t *conn = loop->done;
+    loop->done = NULL;
+    pthread_mutex_unlock(&loop->done_mutex);
+
+    while (conn) {
+        conn_t *next = conn->next;
+        conn_respond(conn);
+        conn = next;
+    }
+    retry_waiting(loop);
+}
+
+static void conn_event(conn_t *conn, uint32_t events) {
+    if (conn->state == CONN_PROCESSING) return; // o worker devolve depois
+    if (events & EPOLLERR) {
+        conn_close(conn);
+    } else if (conn->state == CONN_READING && (events & (EPOLLIN | EPOLLHUP))) {
+        conn_read(conn);
+    } else if (conn->state == CONN_WRITING && (events & (EPOLLOUT | EPOLLHUP))) {
+        conn_write(conn);
+    }
+}
+
+static void* event_loop_thread(void *arg) {
+    event_loop_t *loop = arg;
+    struct epoll_event events[MAX_EVENTS];
+
+    tslog_debugf(server.logger, "Event loop #%d iniciado", loop->id);
+
+    while (g_running) {
+        int timeout = loop->wait_head ? RETRY_TIMEOUT_MS : EPOLL_TIMEOUT_MS;
+        int n = epoll_wait(loop->epfd, events, MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            tslog_errorf(server.logger, "[LOOP %d] epoll_wait: %s", loop->id, strerror(errno));
+            break;
+        }
+        int woken = 0;
+        for (int i = 0; i < n; i++) {
+            void *ptr = events[i].data.ptr;
+            if (ptr == &listen_tag) {
+                accept_all(loop);
+            } else if (ptr == &wake_tag) {
+                woken = 1;
+            } else {
+                conn_event(ptr, events[i].events);
+            }
+        }
+        // Depois do lote: uma conexão devolvida pode fechar, e ela ainda
+        // poderia ter um evento pendente neste mesmo lote
+        if (woken) drain_done(loop);
+        else if (loop->wait_head) retry_waiting(loop);
+        expire_deadlines(loop);
+    }
+
+    tslog_debugf(server.logger, "Event loop #%d finalizando (%lu conexoes aceitas)",
+                 loop->id, loop->accepted);
+    return NULL;
+}
+
+// ======================== BACKEND IO_URING ========================
+
+static void uring_arm_accept(event_loop_t *loop) {
+    if (uring_accept_multishot(loop->ring, loop->listen_fd, OP_ACCEPT) < 0) {
+        tslog_errorf(server.logger, "[LOOP %d] accept no io_uring: %s", loop->id, strerror(errno));
+    }
+}
+
+static void uring_arm_wake(event_loop_t *loop) {
+    if (uring_read(loop->ring, loop->wake_fd, &loop->wake_value, sizeof(loop->wake_value), 0, OP_WAKE) < 0) {
+        tslog_errorf(server.logger, "[LOOP %d] eventfd no io_uring: %s", loop->id, strerror(errno));
+    }
+}
+
+static void uring_accepted(event_loop_t *loop, const uring_cqe_t *cqe) {
+    if (cqe->res >= 0) {
+        if (!g_running) {
+            close(cqe->res);
+            return;
+        }
+        conn_t *conn = conn_open(loop, cqe->res);
+        if (conn) conn_read(conn); // arma o primeiro recv
+    } else if (cqe->res == -EMFILE || cqe->res == -ENFILE) {
+        tslog_warnf(server.logger, "[LOOP %d] Limite de descritores atingido", loop->id);
+    }
+    // Multishot desarmado (erro ou fila de conclusões cheia): arma de novo
+    if (!cqe->more && g_running) uring_arm_accept(loop);
+}
+
+static void uring_received(conn_t *conn, const uring_cqe_t *cqe) {
+    uring_t *ring = conn->loop->ring;
+    if (cqe->res > 0) {
+        // O parser precisa do pedido contíguo: o buffer do anel volta logo
+        memcpy(conn->in + conn->in_len, uring_buffer(ring, cqe->buffer), cqe->res);
+        uring_buffer_recycle(ring, cqe->buffer);
+        conn_received(conn, cqe->res);
+        conn_read(conn);
+    } else if (cqe->res == -ENOBUFS || cqe->res == -EINTR) {
+        conn_read(conn); // anel de buffers vazio: tenta de novo na próxima volta
+    } else {
+        conn_close(conn); // EOF ou erro antes do fim do cabeçalho
+    }
+}
+
+static void uring_sent(conn_t *conn, const uring_cqe_t *cqe) {
+    if (cqe->res <= 0) {
+        conn_close(conn); // inclui o envio cancelado por leitura curta do arquivo
+        return;
+    }
+    conn->sent += cqe->res;
+    conn_deadline(conn, DEADLINE_WRITE); // byte aceito: o prazo de escrita recomeça
+    conn_write(conn);
+}
+
+static void uring_complete(event_loop_t *loop, const uring_cqe_t *cqe) {
+    int op = cqe->data & OP_MASK;
+    if (op == OP_ACCEPT) {
+        uring_accepted(loop, cqe);
+        return;
+    }
+    conn_t *conn = (conn_t *)(uintptr_t)(cqe->data & ~(unsigned long long)OP_MASK);
+    conn->pending--;
+    if (conn->closing) {
+        if (cqe->buffer >= 0) uring_buffer_recycle(loop->ring, cqe->buffer);
+        if (conn->pending == 0) conn_free(conn);
+        return;
+    }
+    switch (op) {
+    case OP_RECV:
+        uring_received(conn, cqe);
+        break;
+    case OP_SEND:
+        uring_sent(conn, cqe);
+        break;
+    case OP_READ:
+        // O envio encadeado segue sozinho; o arquivo encolheu se leu menos
+        if (cqe->res != (int)conn->chunk.file_len) conn_close(conn);
+        break;
+    }
+}
+
+static void* uring_loop_thread(void *arg) {
+    event_loop_t *loop = arg;
+
+    tslog_debugf(server.logger, "Event loop #%d iniciado (io_uring)", loop->id);
+
+    while (g_running) {
+        int timeout = loop->wait_head ? RETRY_TIMEOUT_MS : EPOLL_TIMEOUT_MS;
+        if (uring_wait(loop->ring, timeout) < 0) {
+            tslog_errorf(server.logger, "[LOOP %d] io_uring_enter: %s", loop->id, strerror(errno));
+            break;
+        }
+        int woken = 0;
+        uring_cqe_t cqe;
+        while (uring_next(loop->ring, &cqe)) {
+            if (cqe.data == OP_WAKE) woken = 1;
+            else uring_complete(loop, &cqe);
+        }
+        if (woken) {
+            drain_done(loop);
+            uring_arm_wake(loop);
+        } else if (loop->wait_head) {
+            retry_waiting(loop);
+        }
+        expire_deadlines(loop);
+    }
+
+    tslog_debugf(server.logger, "Event loop #%d finalizando (%lu conexoes aceitas)",
+                 loop->id, loop->accepted);
+    return NULL;
+}
+
+void event_loop_complete(struct conn *conn) {
+    event_loop_t *loop = conn->loop;
+    uint64_t one = 1;
+
+    pthread_mutex_lock(&loop->done_mutex);
+    conn->next = loop->done;
+    loop->done = conn;
+    pthread_mutex_unlock(&loop->done_mutex);
+
+    while (write(loop->wake_fd, &one, sizeof(one)) < 0 && errno == EINTR) {}
+}
+
+int event_loop_start(int listen_fd, int count, int use_uring) {
+    // O io_uring espera pelo accept ele mesmo; com O_NONBLOCK devolveria EAGAIN
+    int flags = fcntl(listen_fd, F_GETFL, 0);
+    if (!use_uring && (flags < 0 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) < 0)) return -1;
+
+    if (!conn_slab) conn_slab = slab_create("conn", sizeof(conn_t));
+    if (use_uring && !chunk_slab) chunk_slab = slab_create("file_chunk", URING_FILE_CHUNK);
+    if (!conn_slab || (use_uring && !chunk_slab)) return -1;
+
+    loops = calloc(count, sizeof(event_loop_t));
+    if (!loops) return -1;
+
+    for (int i = 0; i < count; i++) {
+        event_loop_t *loop = &loops[i];
+        loop->id = i + 1;
+        loop->listen_fd = listen_fd;
+        loop->epfd = -1;
+        loop->wake_fd = eventfd(0, EFD_CLOEXEC | (use_uring ? 0 : EFD_NONBLOCK));
+        pthread_mutex_init(&loop->done_mutex, NULL);
+        if (loop->wake_fd < 0) goto fail;
+        if (timer_wheel_init(&loop->wheel, WHEEL_SLOTS, WHEEL_TICK_MS) < 0) goto fail;
+
+        if (use_uring) {
+            loop->ring = uring_create(URING_ENTRIES, URING_BUFFERS, BUFFER_SIZE);
+            if (!loop->ring) goto fail;
+            // Armados agora, vão no primeiro io_uring_enter do loop
+            uring_arm_accept(loop);
+            uring_arm_wake(loop);
+            if (pthread_create(&loop->thread, NULL, uring_loop_thread, loop) != 0) goto fail;
+            loop_count++;
+            continue;
+        }
+
+        loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (loop->epfd < 0) goto fail;
+
+        // EPOLLEXCLUSIVE: uma conexão nova acorda só um dos loops
+        struct epoll_event ev = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = &listen_tag };
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, listen_fd, &ev) < 0) goto fail;
+        ev.events = EPOLLIN;
+        ev.data.ptr = &wake_tag;
+        if (epoll_ctl(loop->epfd, EPOLL_CTL_ADD, loop->wake_fd, &ev) < 0) goto fail;
+
+        if (pthread_create(&loop->thread, NULL, event_loop_thread, loop) != 0) goto fail;
+        loop_count++;
+    }
+
+    tslog_infof(server.logger, "Modo %s: %d event loops", use_uring ? "io_uring" : "epoll", count);
+    return 0;
+
+fail:
+    tslog_errorf(server.logger, "Erro ao criar event loop: %s", strerror(errno));
+    return -1;
+}
+
+void event_loop_join(void) {
+    for (int i = 0; i < loop_count; i++) {
+        pthread_join(loops[i].thread, NULL);
+    }
+}
+
+void event_loop_destroy(void) {
+    if (!loops) return;
+    for (int i = 0; i < loop_count; i++) {
+        event_loop_t *loop = &loops[i];
+        if (loop->ring) {
+            // Encerra o que está em voo antes de soltar buffers e conexões
+            for (conn_t *conn = loop->all, *next; conn; conn = next) {
+                next = conn->next_all;
+                conn_close(conn);
+            }
+            uring_cqe_t cqe;
+            for (int tries = 0; loop->all && tries < 20; tries++) {
+                uring_wait(loop->ring, 50);
+                while (uring_next(loop->ring, &cqe)) {
+                    if (cqe.data != OP_WAKE) uring_complete(loop, &cqe);
+                }
+            }
+        }
+        while (loop->all) conn_free(loop->all);
+        uring_destroy(loop->ring);
+        timer_wheel_destroy(&loop->wheel);
+        if (loop->epfd >= 0) close(loop->epfd);
+        close(loop->wake_fd);
+        pthread_mutex_destroy(&loop->done_mutex);
+    }
+    free(loops);
+    loops = NULL;
+    loop_count = 0;
+}
@@ -0,0 +1,453 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <dirent.h>
+#include <stdatomic.h>
+#include <sys/inotify.h>
+
+// Cache de arquivos de www/ em memória, compartilhado por todas as threads.
+// Chave: caminho resolvido (ex. "www/index.html"). Cada entrada guarda o
+// corpo em cada codificação disponível (original, gzip, br), o MIME e o
+// bloco de cabeçalho já montado de cada variante (o do 200 e o do 304), então
+// um acerto, inclusive condicional, não faz nenhuma syscall nem comprime
+// nada. Leitores usam o rwlock só para a busca; a entrada é protegida por
+// contagem de referências enquanto a resposta é enviada.
+// O inotify sobre a árvore de www/ invalida as entradas alteradas.
+
+#define CACHE_BUCKETS 4096
+#define CACHE_HEADER_MAX 512
+#define WATCH_POLL_MS 500       // para perceber o fim de g_running
+
+struct cache_variant {
+    char *body;                 // NULL = codificação ausente
+    size_t body_len;
+    char header[CACHE_HEADER_MAX]; // status + Content-Type + Content-Length (+ Encoding, Vary, validadores)
+    size_t header_len;
+    char header_304[CACHE_HEADER_MAX]; // 304 Not Modified: validadores + Vary
+    size_t header_304_len;
+};
+
+struct cache_entry {
+    char *path;
+    const char *mime_type;
+    file_meta_t meta;           // ETag e Last-Modified do stat ao ler
+    const char *cache_control;  // para montar o cabeçalho de um 206/416
+    int vary;
+    struct cache_variant variants[ENC_COUNT]; // [ENC_IDENTITY] sempre presente
+    size_t cost;                // bytes contados no limite do cache
+    _Atomic int refs;           // 1 do cache + 1 por resposta em andamento
+    _Atomic int referenced;     // CLOCK: usada desde a última passagem do ponteiro
+    struct cache_entry *clock_prev, *clock_next; // anel do CLOCK (muda só com o lock de escrita)
+    struct cache_entry *next;   // cadeia do bucket
+};
+
+typedef struct {
+    int wd;
+    char *dir;
+} watch_t;
+
+static struct {
+    int enabled;
+    size_t max_bytes;
+    size_t max_file;            // arquivos maiores não entram no cache
+    size_t used;
+    unsigned long entries;
+    struct cache_entry *buckets[CACHE_BUCKETS];
+    pthread_rwlock_t lock;
+    struct cache_entry *hand;         // ponteiro do CLOCK (NULL = cache vazio)
+    _Atomic unsigned long generation; // muda a cada invalidação
+    _Atomic unsigned long hits, misses;
+
+    int inotify_fd;
+    watch_t *watches;
+    int watch_count, watch_cap;
+    pthread_t watcher;
+} cache;
+
+static unsigned long hash_path(const char *path) {
+    unsigned long h = 1469598103934665603UL; // FNV-1a
+    while (*path) {
+        h ^= (unsigned char)*path++;
+        h *= 1099511628211UL;
+    }
+    return h;
+}
+
+static void entry_release(struct cache_entry *e) {
+    if (atomic_fetch_sub_explicit(&e->refs, 1, memory_order_acq_rel) == 1) {
+        for (int i = 0; i < ENC_COUNT; i++) free(e->variants[i].body);
+        free(e->path);
+        free(e);
+    }
+}
+
+void file_cache_release(struct cache_entry *e) {
+    if (e) entry_release(e);
+}
+
+// Menor variante presente entre as aceitas
+static content_encoding_t pick_variant(char *const body[], const size_t len[], int accepted) {
+    content_encoding_t best = ENC_IDENTITY;
+    for (int i = 1; i < ENC_COUNT; i++) {
+        if (body[i] && (accepted & (1 << i)) && len[i] < len[best]) best = i;
+    }
+    return best;
+}
+
+static void fill_response(struct cache_entry *e, const http_parser_t *http, response_t *res) {
+    char *body[ENC_COUNT];
+    size_t len[ENC_COUNT];
+    for (int i = 0; i < ENC_COUNT; i++) {
+        body[i] = e->variants[i].body;
+        len[i] = e->variants[i].body_len;
+    }
+    content_encoding_t enc = pick_variant(body, len, compress_accepted(http->headers[HTTP_HDR_ACCEPT_ENCODING]));
+    struct cache_variant *v = &e->variants[enc];
+    int not_modified = http_not_modified(http, &e->meta, enc);
+    res->status = not_modified ? "304 Not Modified" : "200 OK";
+    res->mime_type = e->mime_type;
+    res->body = not_modified ? NULL : v->body;
+    res->body_len = not_modified ? 0 : (long)v->body_len;
+    res->owned = NULL;
+    res->header = not_modified ? v->header_304 : v->header;
+    res->header_len = not_modified ? v->header_304_len : v->header_len;
+    res->cached = e;
+    res->bundle = NULL;
+    res->file_fd = -1;
+    res->file_offset = 0;
+    res->multipart = NULL;
+    res->encoding = compress_name(enc);
+    res->vary = 0; // já no cabeçalho pronto
+    res->extra[0] = '\0';
+    if (!not_modified && http->headers[HTTP_HDR_RANGE].len > 0) {
+        // 206/416 não usam o cabeçalho pronto: a faixa sai direto do corpo guardado
+        res->vary = e->vary;
+        file_meta_headers(res->extra, sizeof(res->extra), &e->meta, enc, e->cache_control);
+        response_apply_range(http, &e->meta, enc, res);
+    }
+}
+
+// Fora do cache: 304 ou faixa sobre a variante que ficou com a resposta
+static void finish_uncached(const http_parser_t *http, const file_meta_t *meta,
+                            content_encoding_t enc, response_t *res) {
+    if (http_not_modified(http, meta, enc)) set_not_modified(res);
+    else response_apply_range(http, meta, enc, res);
+}
+
+// Tira a entrada da tabela (com o lock de escrita); a memória some quando
+// a última resposta que a usa terminar
+static void unlink_entry(struct cache_entry **link) {
+    struct cache_entry *e = *link;
+    *link = e->next;
+    if (e->clock_next == e) {
+        cache.hand = NULL;
+    } else {
+        e->clock_prev->clock_next = e->clock_next;
+        e->clock_next->clock_prev = e->clock_prev;
+        if (cache.hand == e) cache.hand = e->clock_next;
+    }
+    cache.used -= e->cost;
+    cache.entries--;
+    entry_release(e);
+}
+
+// Descarte aproximado de LRU (CLOCK): o ponteiro percorre o anel dando uma
+// segunda chance a quem foi usado desde a última passagem e tira a primeira
+// entrada sem uso. Cada passagem zera o bit, então o custo amortizado é O(1)
+// e nunca passa de uma volta
+static void evict_one(void) {
+    struct cache_entry *e = cache.hand;
+    while (atomic_exchange_explicit(&e->referenced, 0, memory_order_relaxed)) e = e->clock_next;
+    struct cache_entry **link = &cache.buckets[hash_path(e->path) % CACHE_BUCKETS];
+    while (*link != e) link = &(*link)->next;
+    cache.hand = e;
+    unlink_entry(link); // o ponteiro segue para a próxima
+}
+
+int file_cache_get(const char *path, const http_parser_t *http, response_t *res) {
+    if (!cache.enabled) return 0;
+    unsigned long b = hash_path(path) % CACHE_BUCKETS;
+
+    pthread_rwlock_rdlock(&cache.lock);
+    struct cache_entry *e = cache.buckets[b];
+    while (e && strcmp(e->path, path) != 0) e = e->next;
+    if (e) {
+        atomic_fetch_add_explicit(&e->refs, 1, memory_order_relaxed);
+        // Só escreve se mudou: o acerto comum não suja a linha da entrada
+        if (!atomic_load_explicit(&e->referenced, memory_order_relaxed)) {
+            atomic_store_explicit(&e->referenced, 1, memory_order_relaxed);
+        }
+    }
+    pthread_rwlock_unlock(&cache.lock);
+
+    if (!e) {
+        atomic_fetch_add_explicit(&cache.misses, 1, memory_order_relaxed);
+        return 0;
+    }
+    atomic_fetch_add_explicit(&cache.hits, 1, memory_order_relaxed);
+    fill_response(e, http, res);
+    return 1;
+}
+
+unsigned long file_cache_generation(void) {
+    return atomic_load_explicit(&cache.generation, memory_order_acquire);
+}
+
+int file_cache_accepts(const char *path, size_t size) {
+    return cache.enabled && size <= cache.max_file;
+}
+
+void file_cache_put(const char *path, file_variants_t *variants, const char *mime_type,
+                    unsigned long generation, const http_parser_t *http, response_t *res) {
+    int accepted = compress_accepted(http->headers[HTTP_HDR_ACCEPT_ENCODING]);
+    content_encoding_t chosen = pick_variant(variants->body, variants->len, accepted);
+    res->status = "200 OK";
+    res->mime_type = mime_type;
+    res->body = variants->body[chosen];
+    res->body_len = variants->len[chosen];
+    res->owned = variants->body[chosen];
+    res->header = NULL;
+    res->cached = NULL;
+    res->bundle = NULL;
+    res->file_fd = -1;
+    res->file_offset = 0;
+    res->multipart = NULL;
+    res->encoding = compress_name(chosen);
+    res->vary = variants->vary;
+    file_meta_headers(res->extra, sizeof(res->extra), &variants->meta, chosen, variants->cache_control);
+
+    size_t total = 0;
+    for (int i = 0; i < ENC_COUNT; i++) total += variants->body[i] ? variants->len[i] : 0;
+    struct cache_entry *e = NULL;
+    if (file_cache_accepts(path, variants->len[ENC_IDENTITY])) {
+        e = calloc(1, sizeof(*e));
+        if (e && !(e->path = strdup(path))) {
+            free(e);
+            e = NULL;
+        }
+    }
+    if (!e) {
+        // Fora do cache: a resposta fica só com a variante escolhida
+        for (int i = 0; i < ENC_COUNT; i++) {
+            if (i != (int)chosen) free(variants->body[i]);
+        }
+        finish_uncached(http, &variants->meta, chosen, res);
+        return;
+    }
+    e->mime_type = mime_type;
+    e->meta = variants->meta;
+    e->cache_control = variants->cache_control;
+    e->vary = variants->vary;
+    for (int i = 0; i < ENC_COUNT; i++) {
+        struct cache_variant *v = &e->variants[i];
+        if (!variants->body[i]) continue;
+        v->body = variants->body[i];
+        v->body_len = variants->len[i];
+        v->header_len = format_ready_header(v->header, sizeof(v->header), 0, mime_type, v->body_len, i,
+                                            variants->vary, &e->meta, variants->cache_control);
+        v->header_304_len = format_ready_header(v->header_304, sizeof(v->header_304), 1, mime_type, 0, i,
+                                                variants->vary, &e->meta, variants->cache_control);
+    }
+    e->cost = sizeof(*e) + strlen(path) + 1 + total;
+    atomic_init(&e->refs, 2); // cache + esta resposta
+    atomic_init(&e->referenced, 0);
+
+    unsigned long b = hash_path(path) % CACHE_BUCKETS;
+    pthread_rwlock_wrlock(&cache.lock);
+    // O arquivo pode ter mudado entre a leitura e agora: não guarda conteúdo velho
+    int stale = atomic_load_explicit(&cache.generation, memory_order_relaxed) != generation;
+    struct cache_entry **link = &cache.buckets[b];
+    while (*link && strcmp((*link)->path, path) != 0) link = &(*link)->next;
+    if (stale || *link) {
+        pthread_rwlock_unlock(&cache.lock);
+        for (int i = 0; i < ENC_COUNT; i++) {
+            if (i != (int)chosen) free(variants->body[i]);
+        }
+        free(e->path);
+        free(e);
+        finish_uncached(http, &variants->meta, chosen, res);
+        return; // resposta continua dona da variante escolhida
+    }
+    while (cache.used + e->cost > cache.max_bytes && cache.entries > 0) {
+        evict_one();
+    }
+    e->next = cache.buckets[b];
+    cache.buckets[b] = e;
+    // Entra logo atrás do ponteiro: é a última que ele visita
+    if (cache.hand) {
+        e->clock_next = cache.hand;
+        e->clock_prev = cache.hand->clock_prev;
+        e->clock_prev->clock_next = e;
+        cache.hand->clock_prev = e;
+    } else {
+        e->clock_next = e->clock_prev = e;
+        cache.hand = e;
+    }
+    cache.used += e->cost;
+    cache.entries++;
+    pthread_rwlock_unlock(&cache.lock);
+
+    fill_response(e, http, res);
+}
+
+// Invalida um caminho; NULL esvazia o cache inteiro
+static void invalidate(const char *path) {
+    pthread_rwlock_wrlock(&cache.lock);
+    atomic_fetch_add_explicit(&cache.generation, 1, memory_order_release);
+    int first = path ? (int)(hash_path(path) % CACHE_BUCKETS) : 0;
+    int last = path ? first + 1 : CACHE_BUCKETS;
+    for (int b = first; b < last; b++) {
+        struct cache_entry **link = &cache.buckets[b];
+        while (*link) {
+            if (!path || strcmp((*link)->path, path) == 0) unlink_entry(link);
+            else link = &(*link)->next;
+        }
+    }
+    pthread_rwlock_unlock(&cache.lock);
+}
+
+// ======================== INOTIFY ========================
+
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE | IN_DELETE | \
+                    IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+static const char* watch_dir(int wd) {
+    for (int i = 0; i < cache.watch_count; i++) {
+        if (cache.watches[i].wd == wd) return cache.watches[i].dir;
+    }
+    return NULL;
+}
+
+// Observa dir e todos os subdiretórios
+static void watch_tree(const char *dir) {
+    int wd = inotify_add_watch(cache.inotify_fd, dir, WATCH_MASK | IN_ONLYDIR);
+    if (wd < 0) {
+        tslog_warnf(server.logger, "[CACHE] inotify em %s: %s", dir, strerror(errno));
+        return;
+    }
+    if (!watch_dir(wd)) {
+        if (cache.watch_count == cache.watch_cap) {
+            int cap = cache.watch_cap ? cache.watch_cap * 2 : 16;
+            watch_t *w = realloc(cache.watches, cap * sizeof(watch_t));
+            if (!w) return;
+            cache.watches = w;
+            cache.watch_cap = cap;
+        }
+        cache.watches[cache.watch_count].wd = wd;
+        cache.watches[cache.watch_count].dir = strdup(dir);
+        cache.watch_count++;
+    }
+
+    DIR *d = opendir(dir);
+    if (!d) return;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        if (ent->d_type != DT_DIR || ent->d_name[0] == '.') continue;
+        char sub[512];
+        snprintf(sub, sizeof(sub), "%s/%s", dir, ent->d_name);
+        watch_tree(sub);
+    }
+    closedir(d);
+}
+
+static void* watcher_thread(void *arg) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    struct pollfd pfd = { .fd = cache.inotify_fd, .events = POLLIN };
+
+    while (g_running) {
+        if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) continue;
+        ssize_t len = read(cache.inotify_fd, buf, sizeof(buf));
+        if (len <= 0) continue;
+
+        for (char *p = buf; p < buf + len; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+
+            const char *dir = watch_dir(ev->wd);
+            if ((ev->mask & IN_Q_OVERFLOW) || !dir || (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF))) {
+                invalidate(NULL); // perdemos eventos ou a árvore mudou: recomeça
+                continue;
+            }
+            if (ev->len == 0) continue;
+
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s", dir, ev->name);
+            if (ev->mask & IN_ISDIR) {
+                // Diretório novo passa a ser observado; movido/removido esvazia o cache
+                if (ev->mask & (IN_CREATE | IN_MOVED_TO)) watch_tree(path);
+                if (ev->mask & (IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)) invalidate(NULL);
+                continue;
+            }
+            tslog_debugf(server.logger, "[CACHE] invalidado %s", path);
+            invalidate(path);
+            // Irmão pré-comprimido (x.html.gz): a entrada é a do original
+            for (int i = 1; i < ENC_COUNT; i++) {
+                size_t len = strlen(path), suffix = strlen(compress_suffix(i));
+                if (len > suffix && strcmp(path + len - suffix, compress_suffix(i)) == 0) {
+                    path[len - suffix] = '\0';
+                    invalidate(path);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+int file_cache_init(size_t max_bytes, const char *root) {
+    if (max_bytes == 0) return 0;
+    pthread_rwlock_init(&cache.lock, NULL);
+    cache.max_bytes = max_bytes;
+    cache.max_file = max_bytes / 8;
+
+    cache.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (cache.inotify_fd < 0) {
+        // Sem invalidação não dá para confiar no conteúdo guardado
+        tslog_warnf(server.logger, "[CACHE] inotify indisponivel (%s): cache desligado", strerror(errno));
+        return -1;
+    }
+    watch_tree(root);
+    if (pthread_create(&cache.watcher, NULL, watcher_thread, NULL) != 0) {
+        close(cache.inotify_fd);
+        return -1;
+    }
+    cache.enabled = 1;
+    tslog_infof(server.logger, "[CACHE] %zu bytes, arquivos ate %zu bytes, %d diretorios observados",
+                cache.max_bytes, cache.max_file, cache.watch_count);
+    return 0;
+}
+
+void file_cache_stats(unsigned long *hits, unsigned long *misses, size_t *bytes, unsigned long *entries) {
+    if (!cache.enabled) {
+        *hits = *misses = *entries = 0;
+        *bytes = 0;
+        return;
+    }
+    *hits = atomic_load_explicit(&cache.hits, memory_order_relaxed);
+    *misses = atomic_load_explicit(&cache.misses, memory_order_relaxed);
+    pthread_rwlock_rdlock(&cache.lock);
+    *bytes = cache.used;
+    *entries = cache.entries;
+    pthread_rwlock_unlock(&cache.lock);
+}
+
+void file_cache_destroy(void) {
+    if (!cache.enabled) return;
+    pthread_join(cache.watcher, NULL);
+    close(cache.inotify_fd);
+
+    unsigned long hits, misses, entries;
+    size_t bytes;
+    file_cache_stats(&hits, &misses, &bytes, &entries);
+    tslog_infof(server.logger, "[CACHE] %lu acertos, %lu faltas, %lu entradas (%zu bytes)",
+                hits, misses, entries, bytes);
+
+    invalidate(NULL);
+    for (int i = 0; i < cache.watch_count; i++) free(cache.watches[i].dir);
+    free(cache.watches);
+    pthread_rwlock_destroy(&cache.lock);
+    cache.enabled = 0;
+}
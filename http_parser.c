@@ -0,0 +1,263 @@
+#include "http_parser.h"
+#include <string.h>
+#include <strings.h>
+
+enum {
+    S_START = 0,        // pula linhas vazias antes da requisição
+    S_METHOD,
+    S_PATH_START,
+    S_PATH,
+    S_VERSION,
+    S_REQUEST_LF,
+    S_NAME_START,
+    S_NAME,
+    S_VALUE_START,
+    S_VALUE,
+    S_HEADER_LF,
+    S_END_LF
+};
+
+// Índices extras em spans (depois dos cabeçalhos)
+#define SPAN_METHOD  (HTTP_HDR_COUNT + 0)
+#define SPAN_PATH    (HTTP_HDR_COUNT + 1)
+#define SPAN_VERSION (HTTP_HDR_COUNT + 2)
+
+static const char *const header_names[HTTP_HDR_COUNT] = {
+    [HTTP_HDR_HOST] = "Host",
+    [HTTP_HDR_CONNECTION] = "Connection",
+    [HTTP_HDR_IF_NONE_MATCH] = "If-None-Match",
+    [HTTP_HDR_IF_MODIFIED_SINCE] = "If-Modified-Since",
+    [HTTP_HDR_RANGE] = "Range",
+    [HTTP_HDR_IF_RANGE] = "If-Range",
+    [HTTP_HDR_ACCEPT_ENCODING] = "Accept-Encoding",
+    [HTTP_HDR_CONTENT_LENGTH] = "Content-Length",
+    [HTTP_HDR_TRANSFER_ENCODING] = "Transfer-Encoding",
+};
+
+static const unsigned char header_name_len[HTTP_HDR_COUNT] = {
+    [HTTP_HDR_HOST] = 4,
+    [HTTP_HDR_CONNECTION] = 10,
+    [HTTP_HDR_IF_NONE_MATCH] = 13,
+    [HTTP_HDR_IF_MODIFIED_SINCE] = 17,
+    [HTTP_HDR_RANGE] = 5,
+    [HTTP_HDR_IF_RANGE] = 8,
+    [HTTP_HDR_ACCEPT_ENCODING] = 15,
+    [HTTP_HDR_CONTENT_LENGTH] = 14,
+    [HTTP_HDR_TRANSFER_ENCODING] = 17,
+};
+
+// tchar da RFC 9110: letras, dígitos e !#$%&'*+-.^_`|~
+static const unsigned char token_chars[256] = {
+    ['!'] = 1, ['#'] = 1, ['$'] = 1, ['%'] = 1, ['&'] = 1, ['\''] = 1, ['*'] = 1,
+    ['+'] = 1, ['-'] = 1, ['.'] = 1, ['^'] = 1, ['_'] = 1, ['`'] = 1, ['|'] = 1, ['~'] = 1,
+    ['0'] = 1, ['1'] = 1, ['2'] = 1, ['3'] = 1, ['4'] = 1, ['5'] = 1, ['6'] = 1, ['7'] = 1,
+    ['8'] = 1, ['9'] = 1,
+    ['A'] = 1, ['B'] = 1, ['C'] = 1, ['D'] = 1, ['E'] = 1, ['F'] = 1, ['G'] = 1, ['H'] = 1,
+    ['I'] = 1, ['J'] = 1, ['K'] = 1, ['L'] = 1, ['M'] = 1, ['N'] = 1, ['O'] = 1, ['P'] = 1,
+    ['Q'] = 1, ['R'] = 1, ['S'] = 1, ['T'] = 1, ['U'] = 1, ['V'] = 1, ['W'] = 1, ['X'] = 1,
+    ['Y'] = 1, ['Z'] = 1,
+    ['a'] = 1, ['b'] = 1, ['c'] = 1, ['d'] = 1, ['e'] = 1, ['f'] = 1, ['g'] = 1, ['h'] = 1,
+    ['i'] = 1, ['j'] = 1, ['k'] = 1, ['l'] = 1, ['m'] = 1, ['n'] = 1, ['o'] = 1, ['p'] = 1,
+    ['q'] = 1, ['r'] = 1, ['s'] = 1, ['t'] = 1, ['u'] = 1, ['v'] = 1, ['w'] = 1, ['x'] = 1,
+    ['y'] = 1, ['z'] = 1,
+};
+
+void http_parser_init(http_parser_t *p, size_t max_header) {
+    memset(p, 0, sizeof(*p));
+    p->max_header = max_header;
+    p->content_length = -1;
+}
+
+static http_slice_t make_slice(const char *buf, http_span_t span) {
+    http_slice_t s = { span.len ? buf + span.off : "", span.len };
+    return s;
+}
+
+// Guarda o valor se o nome for um dos cabeçalhos conhecidos
+static int store_header(http_parser_t *p, const char *buf) {
+    const char *name = buf + p->name_off;
+    size_t value_off = p->mark, value_len = p->value_end - p->mark;
+
+    for (int i = 0; i < HTTP_HDR_COUNT; i++) {
+        if (header_name_len[i] != p->name_len ||
+            strncasecmp(name, header_names[i], p->name_len) != 0) continue;
+
+        if (i == HTTP_HDR_CONTENT_LENGTH) {
+            // Só dígitos; repetido com valor diferente é ambíguo (request smuggling)
+            long long v = 0;
+            if (value_len == 0 || value_len > 18) return -1;
+            for (size_t k = 0; k < value_len; k++) {
+                char c = buf[value_off + k];
+                if (c < '0' || c > '9') return -1;
+                v = v * 10 + (c - '0');
+            }
+            if (p->content_length >= 0 && p->content_length != v) return -1;
+            p->content_length = v;
+        } else if (i == HTTP_HDR_TRANSFER_ENCODING && value_len == 0) {
+            // Vazio passaria por ausente aqui e não num proxy à frente
+            return -1;
+        }
+        p->spans[i].off = value_off;
+        p->spans[i].len = value_len;
+        return 0;
+    }
+    return 0;
+}
+
+static int check_version(http_parser_t *p, const char *buf) {
+    http_span_t v = p->spans[SPAN_VERSION];
+    const char *s = buf + v.off;
+    if (v.len != 8 || memcmp(s, "HTTP/1.", 7) != 0 || s[7] < '0' || s[7] > '9') return -1;
+    p->version_minor = s[7] - '0';
+    return 0;
+}
+
+static void finish(http_parser_t *p, const char *buf) {
+    p->header_len = p->pos + 1;
+    p->method = make_slice(buf, p->spans[SPAN_METHOD]);
+    p->path = make_slice(buf, p->spans[SPAN_PATH]);
+    for (int i = 0; i < HTTP_HDR_COUNT; i++) {
+        p->headers[i] = make_slice(buf, p->spans[i]);
+    }
+}
+
+// Caracteres que encerram um trecho de caminho ou de valor (controle, espaço, DEL)
+static inline int plain_char(unsigned char c) {
+    return c > ' ' && c != 0x7f;
+}
+
+http_parse_result_t http_parse(http_parser_t *p, const char *buf, size_t len) {
+    size_t end = len < p->max_header ? len : p->max_header;
+    for (; p->pos < end; p->pos++) {
+        unsigned char c = (unsigned char)buf[p->pos];
+
+        switch (p->state) {
+        case S_START:
+            if (c == '\r' || c == '\n') break;
+            if (!token_chars[c]) return HTTP_PARSE_ERROR;
+            p->mark = p->pos;
+            p->state = S_METHOD;
+            break;
+
+        case S_METHOD:
+            if (c == ' ') {
+                p->spans[SPAN_METHOD].off = p->mark;
+                p->spans[SPAN_METHOD].len = p->pos - p->mark;
+                p->state = S_PATH_START;
+            } else if (!token_chars[c]) {
+                return HTTP_PARSE_ERROR;
+            }
+            break;
+
+        case S_PATH_START:
+            if (c <= ' ' || c == 0x7f) return HTTP_PARSE_ERROR;
+            p->mark = p->pos;
+            p->state = S_PATH;
+            break;
+
+        case S_PATH:
+            // Laço interno: a maior parte dos bytes não muda o estado
+            while (plain_char(c) && p->pos + 1 < end) c = (unsigned char)buf[++p->pos];
+            if (plain_char(c)) break;
+            if (c == ' ') {
+                p->spans[SPAN_PATH].off = p->mark;
+                p->spans[SPAN_PATH].len = p->pos - p->mark;
+                p->mark = p->pos + 1;
+                p->state = S_VERSION;
+            } else if (c < ' ' || c == 0x7f) {
+                return HTTP_PARSE_ERROR;
+            }
+            break;
+
+        case S_VERSION:
+            if (c == '\r' || c == '\n') {
+                p->spans[SPAN_VERSION].off = p->mark;
+                p->spans[SPAN_VERSION].len = p->pos - p->mark;
+                if (check_version(p, buf) < 0) return HTTP_PARSE_ERROR;
+                p->state = c == '\r' ? S_REQUEST_LF : S_NAME_START;
+            } else if (c <= ' ' || c == 0x7f) {
+                return HTTP_PARSE_ERROR;
+            }
+            break;
+
+        case S_REQUEST_LF:
+        case S_HEADER_LF:
+            if (c != '\n') return HTTP_PARSE_ERROR;
+            if (p->state == S_HEADER_LF && store_header(p, buf) < 0) return HTTP_PARSE_ERROR;
+            p->state = S_NAME_START;
+            break;
+
+        case S_NAME_START:
+            if (c == '\r') {
+                p->state = S_END_LF;
+            } else if (c == '\n') {
+                finish(p, buf);
+                return HTTP_PARSE_DONE;
+            } else if (token_chars[c]) {
+                // Linha começando com espaço (obs-fold) cai no erro abaixo
+                p->name_off = p->pos;
+                p->state = S_NAME;
+            } else {
+                return HTTP_PARSE_ERROR;
+            }
+            break;
+
+        case S_NAME:
+            while (token_chars[c] && p->pos + 1 < end) c = (unsigned char)buf[++p->pos];
+            if (token_chars[c]) break;
+            if (c == ':') {
+                p->name_len = p->pos - p->name_off;
+                p->state = S_VALUE_START;
+            } else if (!token_chars[c]) {
+                return HTTP_PARSE_ERROR;
+            }
+            break;
+
+        case S_VALUE_START:
+            if (c == ' ' || c == '\t') break;
+            p->mark = p->value_end = p->pos;
+            p->state = S_VALUE;
+            /* fall through */
+        case S_VALUE:
+            while (plain_char(c) && p->pos + 1 < end) {
+                p->value_end = p->pos + 1;
+                c = (unsigned char)buf[++p->pos];
+            }
+            if (c == '\r') {
+                p->state = S_HEADER_LF;
+            } else if (c == '\n') {
+                if (store_header(p, buf) < 0) return HTTP_PARSE_ERROR;
+                p->state = S_NAME_START;
+            } else if ((c < ' ' && c != '\t') || c == 0x7f) {
+                return HTTP_PARSE_ERROR;
+            } else if (c != ' ' && c != '\t') {
+                p->value_end = p->pos + 1; // espaços finais não entram no valor
+            }
+            break;
+
+        case S_END_LF:
+            if (c != '\n') return HTTP_PARSE_ERROR;
+            finish(p, buf);
+            return HTTP_PARSE_DONE;
+        }
+    }
+    return p->pos >= p->max_header ? HTTP_PARSE_TOO_LARGE : HTTP_PARSE_AGAIN;
+}
+
+int http_slice_eq(http_slice_t s, const char *literal) {
+    size_t n = strlen(literal);
+    return s.len == n && strncasecmp(s.ptr, literal, n) == 0;
+}
+
+int http_slice_has_token(http_slice_t s, const char *token) {
+    size_t n = strlen(token);
+    size_t i = 0;
+    while (i < s.len) {
+        while (i < s.len && (s.ptr[i] == ' ' || s.ptr[i] == '\t' || s.ptr[i] == ',')) i++;
+        size_t start = i;
+        while (i < s.len && s.ptr[i] != ',' && s.ptr[i] != ';' && s.ptr[i] != ' ' && s.ptr[i] != '\t') i++;
+        if (i - start == n && strncasecmp(s.ptr + start, token, n) == 0) return 1;
+        while (i < s.len && s.ptr[i] != ',') i++; // pula parâmetros
+    }
+    return 0;
+}
@@ -0,0 +1,70 @@
+#ifndef HTTP_PARSER_H
+#define HTTP_PARSER_H
+
+#include <stddef.h>
+
+// Parser incremental de requisições HTTP/1.x (só o cabeçalho).
+// Pode ser chamado de novo a cada recv com o buffer maior: continua de onde
+// parou, sem reexaminar bytes. Nada é copiado; os campos são fatias do
+// buffer de recepção, válidas enquanto ele não for alterado.
+
+// Pedaço do buffer de recepção (não termina em '\0')
+typedef struct {
+    const char *ptr;
+    size_t len;
+} http_slice_t;
+
+typedef enum {
+    HTTP_PARSE_DONE = 0,    // cabeçalho completo em header_len bytes
+    HTTP_PARSE_AGAIN,       // faltam dados: chamar de novo com mais bytes
+    HTTP_PARSE_ERROR,       // requisição malformada (400)
+    HTTP_PARSE_TOO_LARGE    // cabeçalho maior que max_header (431)
+} http_parse_result_t;
+
+// Cabeçalhos que o servidor usa
+typedef enum {
+    HTTP_HDR_HOST = 0,
+    HTTP_HDR_CONNECTION,
+    HTTP_HDR_IF_NONE_MATCH,
+    HTTP_HDR_IF_MODIFIED_SINCE,
+    HTTP_HDR_RANGE,
+    HTTP_HDR_IF_RANGE,
+    HTTP_HDR_ACCEPT_ENCODING,
+    HTTP_HDR_CONTENT_LENGTH,
+    HTTP_HDR_TRANSFER_ENCODING,
+    HTTP_HDR_COUNT
+} http_header_id_t;
+
+typedef struct {
+    size_t off, len;
+} http_span_t;
+
+typedef struct {
+    // Resultado, preenchido em HTTP_PARSE_DONE
+    http_slice_t method;
+    http_slice_t path;
+    int version_minor;              // HTTP/1.x
+    http_slice_t headers[HTTP_HDR_COUNT]; // len 0 = ausente
+    long long content_length;       // -1 = ausente
+    size_t header_len;              // bytes até o fim da linha em branco
+
+    // Estado interno (offsets, para sobreviver a um buffer realocado)
+    int state;
+    size_t pos;
+    size_t max_header;
+    size_t mark;
+    size_t name_off, name_len;
+    size_t value_end;
+    http_span_t spans[HTTP_HDR_COUNT + 3]; // cabeçalhos + método, caminho, versão
+} http_parser_t;
+
+void http_parser_init(http_parser_t *p, size_t max_header);
+http_parse_result_t http_parse(http_parser_t *p, const char *buf, size_t len);
+
+// Comparação sem diferenciar maiúsculas
+int http_slice_eq(http_slice_t s, const char *literal);
+// Procura token numa lista separada por vírgulas ("gzip, br;q=0.5"),
+// ignorando parâmetros depois de ';'
+int http_slice_has_token(http_slice_t s, const char *token);
+
+#endif // HTTP_PARSER_H
@@ -0,0 +1,152 @@
+#include "http_parser.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Alvo de fuzzing do parser. Invariantes verificadas para qualquer entrada:
+// - o resultado não depende de como os bytes chegam (inteiro x em pedaços);
+// - todas as fatias ficam dentro do buffer e header_len <= tamanho.
+// A entrada é copiada para um bloco do tamanho exato, então o AddressSanitizer
+// acusa qualquer leitura além do fim.
+// Com -DHTTP_FUZZ_LIBFUZZER só a função LLVMFuzzerTestOneInput é compilada
+// (clang -fsanitize=fuzzer); sem ela há um gerador de mutações próprio.
+
+#define MAX_HEADER 1024
+
+static void check_slice(http_slice_t s, const char *buf, size_t len) {
+    if (s.len == 0) return;
+    if (s.ptr < buf || s.ptr + s.len > buf + len) abort();
+}
+
+static http_parse_result_t parse_split(http_parser_t *p, const char *buf, size_t len,
+                                       uint32_t seed) {
+    http_parse_result_t r = HTTP_PARSE_AGAIN;
+    size_t have = 0;
+    http_parser_init(p, MAX_HEADER);
+    while (r == HTTP_PARSE_AGAIN && have < len) {
+        seed = seed * 1103515245 + 12345;
+        have += 1 + (seed >> 16) % 7;
+        if (have > len) have = len;
+        r = http_parse(p, buf, have);
+    }
+    return r;
+}
+
+static int same_slice(http_slice_t a, http_slice_t b) {
+    return a.len == b.len && (a.len == 0 || a.ptr == b.ptr);
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    char *buf = malloc(size ? size : 1);
+    if (!buf) return 0;
+    memcpy(buf, data, size);
+
+    http_parser_t whole, split;
+    http_parser_init(&whole, MAX_HEADER);
+    http_parse_result_t r1 = size ? http_parse(&whole, buf, size) : HTTP_PARSE_AGAIN;
+    http_parse_result_t r2 = parse_split(&split, buf, size, (uint32_t)size);
+
+    if (r1 != r2) abort();
+    if (r1 == HTTP_PARSE_DONE) {
+        if (whole.header_len > size || whole.header_len != split.header_len) abort();
+        if (whole.content_length != split.content_length) abort();
+        if (whole.version_minor != split.version_minor) abort();
+        check_slice(whole.method, buf, size);
+        check_slice(whole.path, buf, size);
+        if (!same_slice(whole.method, split.method) || !same_slice(whole.path, split.path)) abort();
+        for (int i = 0; i < HTTP_HDR_COUNT; i++) {
+            check_slice(whole.headers[i], buf, size);
+            if (!same_slice(whole.headers[i], split.headers[i])) abort();
+            http_slice_has_token(whole.headers[i], "keep-alive");
+        }
+    }
+    free(buf);
+    return 0;
+}
+
+#ifndef HTTP_FUZZ_LIBFUZZER
+
+static const char *seeds[] = {
+    "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n",
+    "GET /about.html HTTP/1.0\r\nConnection: keep-alive\r\n\r\n",
+    "POST /form HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 5\r\n\r\nabcde",
+    "GET /x?a=1 HTTP/1.1\nAccept-Encoding: gzip, br;q=0.5\nRange: bytes=0-10\n\n",
+    "\r\n\r\nGET /index.html HTTP/1.1\r\nIf-None-Match: \"abc\"  \r\nHost:\t x \r\n\r\n",
+};
+
+// Bytes que mais mexem com a máquina de estados
+static const char interesting[] = "\r\n :\t\0/,;HTTP1.0123456789";
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ULL;
+
+static uint32_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)rng_state;
+}
+
+static size_t mutate(uint8_t *buf, size_t len, size_t cap) {
+    int rounds = 1 + rng() % 4;
+    for (int k = 0; k < rounds; k++) {
+        size_t pos = len ? rng() % len : 0;
+        switch (rng() % 5) {
+        case 0: // troca um byte
+            if (len) buf[pos] = rng();
+            break;
+        case 1: // troca por um byte interessante
+            if (len) buf[pos] = interesting[rng() % (sizeof(interesting) - 1)];
+            break;
+        case 2: // insere
+            if (len < cap) {
+                memmove(buf + pos + 1, buf + pos, len - pos);
+                buf[pos] = interesting[rng() % (sizeof(interesting) - 1)];
+                len++;
+            }
+            break;
+        case 3: // remove
+            if (len) {
+                memmove(buf + pos, buf + pos + 1, len - pos - 1);
+                len--;
+            }
+            break;
+        case 4: // trunca
+            len = pos;
+            break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char *argv[]) {
+    long runs = 100000;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "-runs=", 6) == 0) runs = atol(argv[i] + 6);
+        else if (strncmp(argv[i], "-seed=", 6) == 0) rng_state = strtoull(argv[i] + 6, NULL, 10) | 1;
+    }
+
+    uint8_t buf[MAX_HEADER * 2];
+    size_t nseeds = sizeof(seeds) / sizeof(seeds[0]);
+    for (long n = 0; n < runs; n++) {
+        const char *seed = n % 16 ? seeds[rng() % nseeds] : "GET / HTTP/1.1\r\n";
+        size_t len = strlen(seed);
+        memcpy(buf, seed, len);
+        if (n % 16 == 0) {
+            // De vez em quando um cabeçalho enorme, para o limite de tamanho
+            while (len + 12 < sizeof(buf) && rng() % 128) {
+                memcpy(buf + len, "X-Pad: y\r\n", 10);
+                len += 10;
+            }
+            memcpy(buf + len, "\r\n", 2);
+            len += 2;
+        } else {
+            len = mutate(buf, len, sizeof(buf));
+        }
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+    printf("http_parser_fuzz: %ld entradas sem falhas\n", runs);
+    return 0;
+}
+
+#endif
@@ -1,65 +1,1174 @@
-#include "libtslog.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <string.h>
-
-logger_t* tslog_init(const char *filename) {
-    logger_t *logger = malloc(sizeof(logger_t));
-    if (!logger) return NULL;
-    
-    // Inicializa mutex
-    if (pthread_mutex_init(&logger->mutex, NULL) != 0) {
-        free(logger);
-        return NULL;
-    }
-    
-    // Abre arquivo (cria se não existir no WSL)
-    logger->file = fopen(filename, "a");
-    if (!logger->file) {
-        pthread_mutex_destroy(&logger->mutex);
-        free(logger);
-        return NULL;
-    }
-    
-    return logger;
-}
-
-void tslog_destroy(logger_t *logger) {
-    if (!logger) return;
-    
-    pthread_mutex_lock(&logger->mutex);
-    if (logger->file) {
-        fclose(logger->file);
-    }
-    pthread_mutex_unlock(&logger->mutex);
-    
-    pthread_mutex_destroy(&logger->mutex);
-    free(logger);
-}
-
-static void write_log(logger_t *logger, const char *level, const char *message) {
-    if (!logger || !message) return;
-    
-    pthread_mutex_lock(&logger->mutex);
-    
-    // Timestamp simples
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char timestamp[32];
-    strftime(timestamp, sizeof(timestamp), "%H:%M:%S", tm_info);
-    
-    // Escreve: [timestamp] LEVEL: message
-    fprintf(logger->file, "[%s] %s: %s\n", timestamp, level, message);
-    fflush(logger->file);
-    
-    pthread_mutex_unlock(&logger->mutex);
-}
-
-void tslog_info(logger_t *logger, const char *message) {
-    write_log(logger, "INFO", message);
-}
-
-void tslog_error(logger_t *logger, const char *message) {
-    write_log(logger, "ERROR", message);
-}
\ No newline at end of file
+#include "libtslog.h"
+#include "tslog_binary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <string.h>
+#include <strings.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <spawn.h>
+
+extern char **environ;
+
+#define CACHE_LINE 64
+#define TSLOG_DEFAULT_QUEUE 4096
+#define TSLOG_DEFAULT_FLUSH_MS 50
+#define TSLOG_FILE_BUFFER (64 * 1024)
+#define TSLOG_MAX_FORMATS 1024
+
+// Um registro pronto para ser gravado (texto ou binário)
+typedef struct {
+    time_t timestamp;           // formato texto
+    uint64_t mono_ns;           // formato binário
+    uint32_t tid;
+    int fmt_id;
+    int level;
+    unsigned short len;
+    char message[TSLOG_MSG_MAX]; // texto ou argumentos codificados
+} tslog_record_t;
+
+// Cache do timestamp textual: localtime/strftime só uma vez por segundo
+typedef struct {
+    time_t sec;
+    char text[32];
+} tslog_clock_t;
+
+// ======================== RING MPSC ========================
+
+// Slot do ring: seq controla a posse (protocolo de Vyukov)
+typedef struct {
+    _Atomic size_t seq;
+    tslog_record_t rec;
+} tslog_slot_t;
+
+struct tslog_async {
+    // Posição de escrita disputada pelos produtores
+    _Alignas(CACHE_LINE) _Atomic size_t tail;
+    // Posição de leitura, só o flusher altera
+    _Alignas(CACHE_LINE) size_t head;
+    _Alignas(CACHE_LINE) _Atomic int sleeping;
+    _Atomic unsigned long dropped;
+
+    tslog_slot_t *slots;
+    size_t mask;
+    tslog_overflow_t overflow;
+    int flush_interval_ms;
+
+    // Estado protegido por logger->mutex
+    pthread_cond_t wake;        // acorda o flusher
+    pthread_cond_t space;       // produtores bloqueados aguardando espaço
+    pthread_cond_t flushed;     // tslog_flush aguardando o flusher
+    size_t flushed_pos;
+    int blocked;
+    int stopping;
+    unsigned long reported;
+
+    pthread_t thread;
+};
+
+static tslog_slot_t* ring_reserve(struct tslog_async *a, size_t *out_pos) {
+    size_t pos = atomic_load_explicit(&a->tail, memory_order_relaxed);
+    for (;;) {
+        tslog_slot_t *slot = &a->slots[pos & a->mask];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&a->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *out_pos = pos;
+                return slot;
+            }
+        } else if (dif < 0) {
+            return NULL; // cheio
+        } else {
+            pos = atomic_load_explicit(&a->tail, memory_order_relaxed);
+        }
+    }
+}
+
+static void wake_flusher(logger_t *logger) {
+    pthread_mutex_lock(&logger->mutex);
+    pthread_cond_signal(&logger->async->wake);
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+// Reserva um slot respeitando a política de estouro; NULL se a mensagem foi descartada
+static tslog_slot_t* reserve_slot(logger_t *logger, size_t *pos) {
+    struct tslog_async *a = logger->async;
+    tslog_slot_t *slot;
+
+    while (!(slot = ring_reserve(a, pos))) {
+        if (a->overflow != TSLOG_OVERFLOW_BLOCK) {
+            atomic_fetch_add_explicit(&a->dropped, 1, memory_order_relaxed);
+            return NULL;
+        }
+        // Espera o flusher liberar espaço (timeout curto para não perder sinal)
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_nsec += 10 * 1000000L;
+        if (timeout.tv_nsec >= 1000000000L) {
+            timeout.tv_sec++;
+            timeout.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&logger->mutex);
+        a->blocked++;
+        pthread_cond_signal(&a->wake);
+        pthread_cond_timedwait(&a->space, &logger->mutex, &timeout);
+        a->blocked--;
+        pthread_mutex_unlock(&logger->mutex);
+    }
+    return slot;
+}
+
+static void publish_slot(logger_t *logger, tslog_slot_t *slot, size_t pos) {
+    struct tslog_async *a = logger->async;
+
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+
+    // Só paga o custo de acordar o flusher se ele estiver dormindo
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&a->sleeping, memory_order_relaxed)) {
+        wake_flusher(logger);
+    }
+}
+
+// ======================== FORMATO BINÁRIO ========================
+
+typedef struct {
+    _Atomic(const char*) key;   // ponteiro do formato (chave rápida)
+    _Atomic int ready;          // 0 = preenchendo, 1 = pronto, -1 = não suportado
+    char *text;                 // cópia da string (o ponteiro pode não ser estável)
+    int nargs;
+    unsigned char types[TSLOG_MAX_ARGS];
+    uint32_t bounded;           // bit i: o %s do argumento i tem precisão "*"
+} tslog_fmt_entry_t;
+
+struct tslog_binary {
+    tslog_fmt_entry_t formats[TSLOG_MAX_FORMATS];
+    unsigned char defined[TSLOG_MAX_FORMATS];   // já gravado no segmento (só o escritor)
+    int str_id;                                 // id do formato "%s"
+};
+
+static const char str_format[] = "%s";
+
+int tslog_next_spec(const char **cursor, tslog_spec_t *spec) {
+    const char *p = *cursor;
+
+    while (*p && *p != '%') p++;
+    if (!*p) {
+        *cursor = p;
+        return 0;
+    }
+
+    memset(spec, 0, sizeof(*spec));
+    spec->start = p++;
+
+    if (*p == '%') {
+        spec->type = TSLOG_ARG_NONE;
+        spec->end = ++p;
+        *cursor = p;
+        return 1;
+    }
+
+    // Argumentos posicionais (%1$d) não são suportados
+    const char *q = p;
+    while (*q >= '0' && *q <= '9') q++;
+    if (*q == '$') return -1;
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') {
+        spec->stars++;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->stars++;
+            spec->prec_star = 1;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+
+    spec->len_start = p;
+    int is_long = 0, is_ldouble = 0;
+    if (*p == 'h') {
+        p++;
+        if (*p == 'h') p++;
+    } else if (*p == 'l') {
+        is_long = 1;
+        p++;
+        if (*p == 'l') p++;
+    } else if (*p == 'L') {
+        is_ldouble = 1;
+        p++;
+    } else if (*p == 'j' || *p == 'z' || *p == 't' || *p == 'q') {
+        is_long = 1;
+        p++;
+    }
+    spec->len_end = p;
+
+    switch (*p) {
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        spec->type = is_long ? TSLOG_ARG_LONG : TSLOG_ARG_INT;
+        break;
+    case 'c':
+        if (is_long) return -1; // wint_t
+        spec->type = TSLOG_ARG_INT;
+        break;
+    case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+        spec->type = is_ldouble ? TSLOG_ARG_LDOUBLE : TSLOG_ARG_DOUBLE;
+        break;
+    case 's':
+        if (is_long) return -1; // wchar_t*
+        spec->type = TSLOG_ARG_STR;
+        break;
+    case 'p':
+        spec->type = TSLOG_ARG_PTR;
+        break;
+    default:
+        return -1; // %n, %m e conversões desconhecidas
+    }
+
+    spec->end = ++p;
+    *cursor = p;
+    return 1;
+}
+
+int tslog_scan_format(const char *fmt, unsigned char *types, int max_args) {
+    const char *cursor = fmt;
+    tslog_spec_t spec;
+    int nargs = 0, r;
+
+    while ((r = tslog_next_spec(&cursor, &spec)) > 0) {
+        if (spec.type == TSLOG_ARG_NONE) continue;
+        if (nargs + spec.stars + 1 > max_args) return -1;
+        for (int i = 0; i < spec.stars; i++) types[nargs++] = TSLOG_ARG_INT;
+        types[nargs++] = (unsigned char)spec.type;
+    }
+    return r < 0 ? -1 : nargs;
+}
+
+// Strings com "%.*s" podem não ter '\0' (ex. fatias de um buffer): marca
+// quais argumentos devem ser limitados pelo int de precisão anterior
+static uint32_t scan_bounded(const char *fmt) {
+    const char *cursor = fmt;
+    tslog_spec_t spec;
+    uint32_t mask = 0;
+    int nargs = 0;
+
+    while (tslog_next_spec(&cursor, &spec) > 0) {
+        if (spec.type == TSLOG_ARG_NONE) continue;
+        nargs += spec.stars;
+        if (spec.type == TSLOG_ARG_STR && spec.prec_star && nargs < 32) mask |= 1u << nargs;
+        nargs++;
+    }
+    return mask;
+}
+
+// Procura (ou registra) o formato; retorna o id ou -1 se não couber/não for suportado
+static int format_lookup(struct tslog_binary *b, const char *fmt) {
+    uint64_t h = (uint64_t)((uintptr_t)fmt >> 3) * 0x9E3779B97F4A7C15ULL;
+    size_t idx = (size_t)(h >> 32) & (TSLOG_MAX_FORMATS - 1);
+
+    for (int probe = 0; probe < TSLOG_MAX_FORMATS; probe++) {
+        tslog_fmt_entry_t *e = &b->formats[idx];
+        const char *key = atomic_load_explicit(&e->key, memory_order_acquire);
+
+        if (!key) {
+            const char *expected = NULL;
+            if (atomic_compare_exchange_strong(&e->key, &expected, fmt)) {
+                // Ganhamos a entrada: analisa o formato uma única vez
+                e->text = strdup(fmt);
+                e->nargs = e->text ? tslog_scan_format(fmt, e->types, TSLOG_MAX_ARGS) : -1;
+                if (e->nargs > 0) e->bounded = scan_bounded(fmt);
+                atomic_store_explicit(&e->ready, e->nargs >= 0 ? 1 : -1, memory_order_release);
+                return e->nargs >= 0 ? (int)idx : -1;
+            }
+            key = expected;
+        }
+
+        if (key == fmt) {
+            int ready;
+            while ((ready = atomic_load_explicit(&e->ready, memory_order_acquire)) == 0) {
+                sched_yield();
+            }
+            // Mesmo ponteiro com outro conteúdo (buffer reaproveitado): segue sondando
+            if (e->text && strcmp(e->text, fmt) == 0) return ready > 0 ? (int)idx : -1;
+        }
+        idx = (idx + 1) & (TSLOG_MAX_FORMATS - 1);
+    }
+    return -1;
+}
+
+static size_t encode_string(char *out, size_t off, size_t cap, const char *str, size_t max) {
+    if (!str) str = "(null)";
+    if (off + 2 > cap) return off;
+    size_t len = strnlen(str, max);
+    if (len > cap - off - 2) len = cap - off - 2;
+    uint16_t len16 = (uint16_t)len;
+    memcpy(out + off, &len16, 2);
+    memcpy(out + off + 2, str, len);
+    return off + 2 + len;
+}
+
+// Copia os argumentos brutos, sem formatar
+static size_t encode_args(const tslog_fmt_entry_t *e, char *out, size_t cap, va_list args) {
+    size_t off = 0;
+
+    int64_t prev = -1;          // último int lido (precisão de um "%.*s")
+    for (int i = 0; i < e->nargs; i++) {
+        int64_t iv = 0;
+        double dv;
+        switch (e->types[i]) {
+        case TSLOG_ARG_INT:
+            iv = va_arg(args, int);
+            break;
+        case TSLOG_ARG_LONG:
+            iv = va_arg(args, long long);
+            break;
+        case TSLOG_ARG_PTR:
+            iv = (int64_t)(uintptr_t)va_arg(args, void*);
+            break;
+        case TSLOG_ARG_DOUBLE:
+            dv = va_arg(args, double);
+            if (off + 8 <= cap) memcpy(out + off, &dv, 8);
+            off += 8;
+            continue;
+        case TSLOG_ARG_LDOUBLE:
+            dv = (double)va_arg(args, long double);
+            if (off + 8 <= cap) memcpy(out + off, &dv, 8);
+            off += 8;
+            continue;
+        case TSLOG_ARG_STR: {
+            // Precisão "*" negativa equivale a não ter precisão
+            size_t max = (e->bounded >> i & 1) && prev >= 0 ? (size_t)prev : SIZE_MAX;
+            off = encode_string(out, off, cap, va_arg(args, const char*), max);
+            continue;
+        }
+        default:
+            continue;
+        }
+        if (off + 8 <= cap) memcpy(out + off, &iv, 8);
+        off += 8;
+        prev = iv;
+    }
+    return off > cap ? cap : off;
+}
+
+static uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t current_tid(void) {
+    static __thread uint32_t tid;
+    if (!tid) tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+// Início de segmento: âncora de tempo e tabela de formatos zerada
+static size_t write_segment(logger_t *logger) {
+    char buf[1 + 4 + 2 + 8 + 8];
+    uint16_t version = TSLOG_BIN_VERSION;
+    uint64_t real_ns = clock_ns(CLOCK_REALTIME);
+    uint64_t mono_ns = clock_ns(CLOCK_MONOTONIC);
+
+    buf[0] = TSLOG_REC_SEGMENT;
+    memcpy(buf + 1, TSLOG_BIN_MAGIC, 4);
+    memcpy(buf + 5, &version, 2);
+    memcpy(buf + 7, &real_ns, 8);
+    memcpy(buf + 15, &mono_ns, 8);
+    memset(logger->binary->defined, 0, sizeof(logger->binary->defined));
+    return fwrite(buf, 1, sizeof(buf), logger->file);
+}
+
+static size_t write_binary(logger_t *logger, const tslog_record_t *rec) {
+    struct tslog_binary *b = logger->binary;
+    char buf[1 + 8 + 4 + 1 + 4 + 2];
+    uint32_t id = (uint32_t)rec->fmt_id;
+    size_t written = 0;
+
+    // Formato ainda não gravado neste segmento
+    if (!b->defined[id]) {
+        const char *text = b->formats[id].text;
+        uint16_t len = (uint16_t)strlen(text);
+        buf[0] = TSLOG_REC_FORMAT;
+        memcpy(buf + 1, &id, 4);
+        memcpy(buf + 5, &len, 2);
+        written += fwrite(buf, 1, 7, logger->file);
+        written += fwrite(text, 1, len, logger->file);
+        b->defined[id] = 1;
+    }
+
+    uint8_t level = (uint8_t)rec->level;
+    uint16_t len = rec->len;
+    buf[0] = TSLOG_REC_LOG;
+    memcpy(buf + 1, &rec->mono_ns, 8);
+    memcpy(buf + 9, &rec->tid, 4);
+    memcpy(buf + 13, &level, 1);
+    memcpy(buf + 14, &id, 4);
+    memcpy(buf + 18, &len, 2);
+    written += fwrite(buf, 1, sizeof(buf), logger->file);
+    written += fwrite(rec->message, 1, len, logger->file);
+    return written;
+}
+
+// ======================== ROTAÇÃO ========================
+
+// Arquivo já renomeado, aguardando fechamento/compressão na thread auxiliar
+typedef struct rotate_job {
+    struct rotate_job *next;
+    FILE *file;                 // NULL = modo síncrono, a thread ainda renomeia e troca
+    char path[];
+} rotate_job_t;
+
+struct tslog_rotate {
+    char *path;
+    size_t max_bytes;
+    int interval;
+    int keep;
+    int gzip;
+    int buffered;               // reaplica setvbuf no arquivo novo (modo assíncrono)
+
+    // Só o escritor (flusher ou dono do mutex) altera
+    size_t bytes;
+    time_t next_time;
+    unsigned seq;
+    int swapping;               // modo síncrono: troca na fila da thread auxiliar
+
+    logger_t *logger;
+
+    _Atomic int requested;      // tslog_rotate (seguro em handler de sinal)
+
+    // Thread auxiliar: fclose, gzip e retenção fora do caminho do escritor
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    rotate_job_t *jobs;
+    rotate_job_t **jobs_tail;
+    int started;
+    int stopping;
+    pthread_t thread;
+};
+
+static time_t next_boundary(time_t now, int interval) {
+    return (now / interval + 1) * interval;
+}
+
+static int compare_names(const void *a, const void *b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+// Remove os rotacionados mais antigos além de keep (nomes ordenam por data)
+static void prune_rotated(struct tslog_rotate *r) {
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", r->path);
+    char *slash = strrchr(dir, '/');
+    const char *base = slash ? slash + 1 : r->path;
+    if (slash) *slash = '\0';
+    else strcpy(dir, ".");
+    size_t base_len = strlen(base);
+
+    DIR *d = opendir(dir);
+    if (!d) return;
+
+    char **names = NULL;
+    size_t count = 0, cap = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL) {
+        // <base>.AAAAMMDD-HHMMSS.NNN[.gz]
+        if (strncmp(ent->d_name, base, base_len) != 0 || ent->d_name[base_len] != '.') continue;
+        if (ent->d_name[base_len + 1] < '0' || ent->d_name[base_len + 1] > '9') continue;
+        if (count == cap) {
+            cap = cap ? cap * 2 : 16;
+            char **grown = realloc(names, cap * sizeof(char*));
+            if (!grown) break;
+            names = grown;
+        }
+        names[count] = strdup(ent->d_name);
+        if (names[count]) count++;
+    }
+
+    qsort(names, count, sizeof(char*), compare_names);
+    for (size_t i = 0; i < count; i++) {
+        if (count - i > (size_t)r->keep) unlinkat(dirfd(d), names[i], 0);
+        free(names[i]);
+    }
+    free(names);
+    closedir(d);
+}
+
+static void gzip_file(const char *path) {
+    char *const argv[] = { "gzip", "-f", (char*)path, NULL };
+    pid_t pid;
+    if (posix_spawnp(&pid, "gzip", NULL, NULL, argv, environ) == 0) {
+        waitpid(pid, NULL, 0);
+    }
+}
+
+static FILE* open_fresh(struct tslog_rotate *r) {
+    FILE *fresh = fopen(r->path, "a");
+    if (fresh && r->buffered) setvbuf(fresh, NULL, _IOFBF, TSLOG_FILE_BUFFER);
+    return fresh;
+}
+
+// Modo síncrono: rename e fopen aqui, sem o mutex do logger; os produtores
+// seguem gravando no arquivo antigo (já com o nome rotacionado) e só esperam
+// a troca do ponteiro. Retorna 1 se o antigo ficou em job->file para fechar
+static int swap_file(struct tslog_rotate *r, rotate_job_t *job) {
+    logger_t *logger = r->logger;
+    int renamed = rename(r->path, job->path) == 0;
+    FILE *fresh = renamed ? open_fresh(r) : NULL;
+
+    pthread_mutex_lock(&logger->mutex);
+    r->swapping = 0;
+    // Sem o arquivo novo continua no antigo (agora com o nome rotacionado)
+    if (renamed) r->bytes = 0;
+    if (fresh) {
+        job->file = logger->file;
+        logger->file = fresh;
+        if (logger->binary) r->bytes += write_segment(logger);
+    }
+    pthread_mutex_unlock(&logger->mutex);
+    return fresh != NULL;
+}
+
+static void* rotate_thread(void *arg) {
+    struct tslog_rotate *r = (struct tslog_rotate*)arg;
+
+    pthread_mutex_lock(&r->mutex);
+    for (;;) {
+        while (!r->jobs && !r->stopping) {
+            pthread_cond_wait(&r->cond, &r->mutex);
+        }
+        rotate_job_t *job = r->jobs;
+        if (!job) break;
+        r->jobs = job->next;
+        if (!r->jobs) r->jobs_tail = &r->jobs;
+        pthread_mutex_unlock(&r->mutex);
+
+        // fclose pode demorar (flush final, disco lento): fica fora do escritor
+        if (job->file || swap_file(r, job)) {
+            fclose(job->file);
+            if (r->gzip && access(job->path, F_OK) == 0) gzip_file(job->path);
+        }
+        free(job);
+
+        pthread_mutex_lock(&r->mutex);
+        // Retenção depois de esvaziar a fila, para não apagar arquivo pendente
+        if (!r->jobs && r->keep > 0) {
+            pthread_mutex_unlock(&r->mutex);
+            prune_rotated(r);
+            pthread_mutex_lock(&r->mutex);
+        }
+    }
+    pthread_mutex_unlock(&r->mutex);
+    return NULL;
+}
+
+static int rotate_start(logger_t *logger, const char *filename, const tslog_options_t *opts) {
+    struct tslog_rotate *r = calloc(1, sizeof(struct tslog_rotate));
+    if (!r) return -1;
+    r->path = strdup(filename);
+    if (!r->path) {
+        free(r);
+        return -1;
+    }
+    if (opts) {
+        r->max_bytes = opts->rotate_bytes;
+        r->interval = opts->rotate_seconds;
+        r->keep = opts->rotate_keep;
+        r->gzip = opts->rotate_gzip;
+        r->buffered = opts->async;
+    }
+    if (r->interval > 0) r->next_time = next_boundary(time(NULL), r->interval);
+
+    struct stat st;
+    if (fstat(fileno(logger->file), &st) == 0) r->bytes = (size_t)st.st_size;
+
+    pthread_mutex_init(&r->mutex, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    r->jobs_tail = &r->jobs;
+    r->logger = logger;
+    logger->rotate = r;
+    return 0;
+}
+
+static void rotate_stop(logger_t *logger) {
+    struct tslog_rotate *r = logger->rotate;
+
+    pthread_mutex_lock(&r->mutex);
+    r->stopping = 1;
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->mutex);
+    if (r->started) pthread_join(r->thread, NULL);
+
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->mutex);
+    free(r->path);
+    free(r);
+    logger->rotate = NULL;
+}
+
+// Próximo nome rotacionado: <path>.AAAAMMDD-HHMMSS.NNN
+static rotate_job_t* rotate_job_new(struct tslog_rotate *r) {
+    time_t now = time(NULL);
+    struct tm tm_info;
+    char stamp[32];
+    char rotated[PATH_MAX];
+
+    if (r->interval > 0) r->next_time = next_boundary(now, r->interval);
+
+    localtime_r(&now, &tm_info);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &tm_info);
+    snprintf(rotated, sizeof(rotated), "%s.%s.%03u", r->path, stamp, r->seq++ % 1000);
+
+    rotate_job_t *job = malloc(sizeof(rotate_job_t) + strlen(rotated) + 1);
+    if (!job) return NULL;
+    job->next = NULL;
+    job->file = NULL;
+    strcpy(job->path, rotated);
+    return job;
+}
+
+// Entrega à thread auxiliar (criada na primeira rotação); -1 se não há thread
+static int rotate_enqueue(struct tslog_rotate *r, rotate_job_t *job) {
+    pthread_mutex_lock(&r->mutex);
+    if (!r->started && pthread_create(&r->thread, NULL, rotate_thread, r) == 0) {
+        r->started = 1;
+    }
+    if (r->started) {
+        *r->jobs_tail = job;
+        r->jobs_tail = &job->next;
+        pthread_cond_signal(&r->cond);
+    }
+    pthread_mutex_unlock(&r->mutex);
+    return r->started ? 0 : -1;
+}
+
+// Troca o arquivo: só rename + open no escritor; o resto vai para a thread auxiliar
+static void rotate_now(logger_t *logger, rotate_job_t *job) {
+    struct tslog_rotate *r = logger->rotate;
+
+    fflush(logger->file);
+    if (rename(r->path, job->path) != 0) {
+        free(job);
+        return;
+    }
+
+    FILE *fresh = open_fresh(r);
+    if (!fresh) {
+        // Continua no arquivo antigo (agora com o nome rotacionado)
+        r->bytes = 0;
+        free(job);
+        return;
+    }
+
+    job->file = logger->file;
+    logger->file = fresh;
+    r->bytes = 0;
+    if (logger->binary) r->bytes += write_segment(logger);
+
+    if (rotate_enqueue(r, job) != 0) {
+        fclose(job->file);
+        free(job);
+    }
+}
+
+// Chamado pelo escritor depois de gravar; retorna 1 se o arquivo foi trocado
+static int maybe_rotate(logger_t *logger) {
+    struct tslog_rotate *r = logger->rotate;
+    int due = 0;
+
+    if (r->swapping) return 0; // o pedido que chegar agora vale para a próxima
+
+    if (atomic_load_explicit(&r->requested, memory_order_relaxed)) {
+        atomic_store_explicit(&r->requested, 0, memory_order_relaxed);
+        due = 1;
+    }
+    if (r->max_bytes > 0 && r->bytes >= r->max_bytes) due = 1;
+    if (r->interval > 0 && time(NULL) >= r->next_time) due = 1;
+
+    if (!due) return 0;
+    rotate_job_t *job = rotate_job_new(r);
+    if (!job) return 0;
+    // Modo síncrono: o escritor é um produtor segurando o mutex; a troca
+    // vai inteira para a thread auxiliar (sem ela, faz aqui mesmo)
+    if (!logger->async && rotate_enqueue(r, job) == 0) {
+        r->swapping = 1;
+        return 0;
+    }
+    rotate_now(logger, job);
+    return 1;
+}
+
+// ======================== REGISTROS ========================
+
+static const char* const level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static const char* level_name(int level) {
+    if (level < LOG_DEBUG || level > LOG_ERROR) return "INFO";
+    return level_names[level];
+}
+
+static void stamp_record(logger_t *logger, tslog_record_t *rec, int level) {
+    rec->level = level;
+    if (logger->binary) {
+        rec->mono_ns = clock_ns(CLOCK_MONOTONIC);
+        rec->tid = current_tid();
+    } else {
+        rec->timestamp = time(NULL);
+    }
+}
+
+static void fill_message(logger_t *logger, tslog_record_t *rec, int level, const char *message) {
+    stamp_record(logger, rec, level);
+
+    if (logger->binary) {
+        rec->fmt_id = logger->binary->str_id;
+        rec->len = (unsigned short)encode_string(rec->message, 0, TSLOG_MSG_MAX, message, SIZE_MAX);
+        return;
+    }
+
+    size_t len = strlen(message);
+    if (len > TSLOG_MSG_MAX) len = TSLOG_MSG_MAX;
+    memcpy(rec->message, message, len);
+    rec->len = (unsigned short)len;
+}
+
+static void fill_formatted(logger_t *logger, tslog_record_t *rec, int level,
+                           const char *fmt, va_list args) {
+    if (logger->binary) {
+        int id = format_lookup(logger->binary, fmt);
+        if (id >= 0) {
+            stamp_record(logger, rec, level);
+            rec->fmt_id = id;
+            rec->len = (unsigned short)encode_args(&logger->binary->formats[id],
+                                                   rec->message, TSLOG_MSG_MAX, args);
+            return;
+        }
+        // Formato não suportado: formata aqui e grava como "%s"
+        char text[TSLOG_MSG_MAX];
+        vsnprintf(text, sizeof(text), fmt, args);
+        fill_message(logger, rec, level, text);
+        return;
+    }
+
+    // Formata direto no destino, sem buffer intermediário
+    stamp_record(logger, rec, level);
+    int len = vsnprintf(rec->message, TSLOG_MSG_MAX, fmt, args);
+    if (len < 0) len = 0;
+    if (len > TSLOG_MSG_MAX - 1) len = TSLOG_MSG_MAX - 1;
+    rec->len = (unsigned short)len;
+}
+
+// Grava um registro; chamado só pelo escritor (flusher ou dono do mutex)
+static void write_record(logger_t *logger, const tslog_record_t *rec, tslog_clock_t *clock) {
+    if (logger->binary) {
+        logger->rotate->bytes += write_binary(logger, rec);
+        return;
+    }
+
+    if (rec->timestamp != clock->sec) {
+        struct tm tm_info;
+        localtime_r(&rec->timestamp, &tm_info);
+        strftime(clock->text, sizeof(clock->text), "%H:%M:%S", &tm_info);
+        clock->sec = rec->timestamp;
+    }
+
+    // Escreve: [timestamp] LEVEL: message
+    int n = fprintf(logger->file, "[%s] %s: %.*s\n", clock->text, level_name(rec->level),
+                    (int)rec->len, rec->message);
+    if (n > 0) logger->rotate->bytes += n;
+}
+
+static void write_sync(logger_t *logger, const tslog_record_t *rec) {
+    tslog_clock_t clock = { .sec = -1 };
+
+    pthread_mutex_lock(&logger->mutex);
+    write_record(logger, rec, &clock);
+    maybe_rotate(logger);
+    fflush(logger->file);
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+// ======================== FLUSHER ========================
+
+static int ring_ready(struct tslog_async *a) {
+    tslog_slot_t *slot = &a->slots[a->head & a->mask];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) == a->head + 1;
+}
+
+// Escreve no arquivo tudo que estiver publicado no ring; retorna quantos registros
+static size_t drain_ring(logger_t *logger, tslog_clock_t *clock) {
+    struct tslog_async *a = logger->async;
+    size_t count = 0;
+
+    while (ring_ready(a)) {
+        tslog_slot_t *slot = &a->slots[a->head & a->mask];
+        write_record(logger, &slot->rec, clock);
+        atomic_store_explicit(&slot->seq, a->head + a->mask + 1, memory_order_release);
+        a->head++;
+        count++;
+    }
+    return count;
+}
+
+static void report_dropped(logger_t *logger, tslog_clock_t *clock) {
+    struct tslog_async *a = logger->async;
+    unsigned long dropped = atomic_load_explicit(&a->dropped, memory_order_relaxed);
+    if (a->overflow == TSLOG_OVERFLOW_COUNT && dropped != a->reported) {
+        char text[128];
+        tslog_record_t rec;
+        snprintf(text, sizeof(text), "tslog: %lu mensagens descartadas (buffer cheio)",
+                 dropped - a->reported);
+        fill_message(logger, &rec, LOG_ERROR, text);
+        write_record(logger, &rec, clock);
+        a->reported = dropped;
+    }
+}
+
+static void* flusher_thread(void *arg) {
+    logger_t *logger = (logger_t*)arg;
+    struct tslog_async *a = logger->async;
+    tslog_clock_t clock = { .sec = -1 };
+
+    for (;;) {
+        if (drain_ring(logger, &clock) > 0) {
+            report_dropped(logger, &clock);
+            maybe_rotate(logger);
+            fflush(logger->file);
+
+            pthread_mutex_lock(&logger->mutex);
+            a->flushed_pos = a->head;
+            pthread_cond_broadcast(&a->flushed);
+            if (a->blocked > 0) pthread_cond_broadcast(&a->space);
+            pthread_mutex_unlock(&logger->mutex);
+            continue;
+        }
+
+        // Sem tráfego: ainda pode haver rotação por tempo ou pedida por tslog_rotate
+        if (maybe_rotate(logger)) fflush(logger->file);
+
+        pthread_mutex_lock(&logger->mutex);
+        if (a->stopping) {
+            pthread_mutex_unlock(&logger->mutex);
+            break;
+        }
+
+        // Anuncia que vai dormir e confere de novo antes de esperar
+        atomic_store(&a->sleeping, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (!ring_ready(a)) {
+            struct timespec timeout;
+            clock_gettime(CLOCK_REALTIME, &timeout);
+            timeout.tv_nsec += (long)a->flush_interval_ms * 1000000L;
+            timeout.tv_sec += timeout.tv_nsec / 1000000000L;
+            timeout.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&a->wake, &logger->mutex, &timeout);
+        }
+        atomic_store(&a->sleeping, 0);
+        pthread_mutex_unlock(&logger->mutex);
+    }
+
+    // Drena o que sobrou antes de encerrar
+    drain_ring(logger, &clock);
+    report_dropped(logger, &clock);
+    fflush(logger->file);
+    return NULL;
+}
+
+static size_t round_pow2(size_t n) {
+    size_t cap = 2;
+    while (cap < n) cap <<= 1;
+    return cap;
+}
+
+static int async_start(logger_t *logger, const tslog_options_t *opts) {
+    struct tslog_async *a = aligned_alloc(CACHE_LINE, sizeof(struct tslog_async));
+    if (!a) return -1;
+    memset(a, 0, sizeof(*a));
+
+    size_t capacity = round_pow2(opts->queue_size ? opts->queue_size : TSLOG_DEFAULT_QUEUE);
+    a->slots = malloc(capacity * sizeof(tslog_slot_t));
+    if (!a->slots) {
+        free(a);
+        return -1;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        atomic_init(&a->slots[i].seq, i);
+    }
+    a->mask = capacity - 1;
+    a->overflow = opts->overflow;
+    a->flush_interval_ms = opts->flush_interval_ms > 0 ? opts->flush_interval_ms
+                                                       : TSLOG_DEFAULT_FLUSH_MS;
+    pthread_cond_init(&a->wake, NULL);
+    pthread_cond_init(&a->space, NULL);
+    pthread_cond_init(&a->flushed, NULL);
+
+    // Só o flusher escreve: buffer grande, flush por lote
+    setvbuf(logger->file, NULL, _IOFBF, TSLOG_FILE_BUFFER);
+
+    logger->async = a;
+    if (pthread_create(&a->thread, NULL, flusher_thread, logger) != 0) {
+        logger->async = NULL;
+        pthread_cond_destroy(&a->wake);
+        pthread_cond_destroy(&a->space);
+        pthread_cond_destroy(&a->flushed);
+        free(a->slots);
+        free(a);
+        return -1;
+    }
+    return 0;
+}
+
+static void async_stop(logger_t *logger) {
+    struct tslog_async *a = logger->async;
+
+    pthread_mutex_lock(&logger->mutex);
+    a->stopping = 1;
+    pthread_cond_signal(&a->wake);
+    pthread_mutex_unlock(&logger->mutex);
+    pthread_join(a->thread, NULL);
+
+    pthread_cond_destroy(&a->wake);
+    pthread_cond_destroy(&a->space);
+    pthread_cond_destroy(&a->flushed);
+    free(a->slots);
+    free(a);
+    logger->async = NULL;
+}
+
+static int binary_start(logger_t *logger) {
+    struct tslog_binary *b = calloc(1, sizeof(struct tslog_binary));
+    if (!b) return -1;
+
+    b->str_id = format_lookup(b, str_format);
+    if (b->str_id < 0) {
+        free(b);
+        return -1;
+    }
+    logger->binary = b;
+    write_segment(logger);
+    fflush(logger->file);
+    return 0;
+}
+
+static void binary_stop(logger_t *logger) {
+    struct tslog_binary *b = logger->binary;
+    for (int i = 0; i < TSLOG_MAX_FORMATS; i++) {
+        free(b->formats[i].text);
+    }
+    free(b);
+    logger->binary = NULL;
+}
+
+// ======================== API ========================
+
+void tslog_options_default(tslog_options_t *opts) {
+    opts->async = 0;
+    opts->queue_size = TSLOG_DEFAULT_QUEUE;
+    opts->overflow = TSLOG_OVERFLOW_BLOCK;
+    opts->flush_interval_ms = TSLOG_DEFAULT_FLUSH_MS;
+    opts->min_level = LOG_INFO;
+    opts->format = TSLOG_FORMAT_TEXT;
+    opts->rotate_bytes = 0;
+    opts->rotate_seconds = 0;
+    opts->rotate_keep = 0;
+    opts->rotate_gzip = 0;
+}
+
+logger_t* tslog_init_ex(const char *filename, const tslog_options_t *opts) {
+    logger_t *logger = malloc(sizeof(logger_t));
+    if (!logger) return NULL;
+    logger->async = NULL;
+    logger->binary = NULL;
+    logger->rotate = NULL;
+    atomic_init(&logger->min_level, opts ? opts->min_level : LOG_INFO);
+
+    // Inicializa mutex
+    if (pthread_mutex_init(&logger->mutex, NULL) != 0) {
+        free(logger);
+        return NULL;
+    }
+
+    // Abre arquivo (cria se não existir no WSL)
+    logger->file = fopen(filename, "a");
+    if (!logger->file) {
+        pthread_mutex_destroy(&logger->mutex);
+        free(logger);
+        return NULL;
+    }
+
+    if (rotate_start(logger, filename, opts) != 0) {
+        fclose(logger->file);
+        pthread_mutex_destroy(&logger->mutex);
+        free(logger);
+        return NULL;
+    }
+
+    if (opts && opts->format == TSLOG_FORMAT_BINARY && binary_start(logger) != 0) {
+        rotate_stop(logger);
+        fclose(logger->file);
+        pthread_mutex_destroy(&logger->mutex);
+        free(logger);
+        return NULL;
+    }
+
+    if (opts && opts->async && async_start(logger, opts) != 0) {
+        if (logger->binary) binary_stop(logger);
+        rotate_stop(logger);
+        fclose(logger->file);
+        pthread_mutex_destroy(&logger->mutex);
+        free(logger);
+        return NULL;
+    }
+
+    return logger;
+}
+
+logger_t* tslog_init(const char *filename) {
+    return tslog_init_ex(filename, NULL);
+}
+
+void tslog_destroy(logger_t *logger) {
+    if (!logger) return;
+
+    // Modo assíncrono: drena o ring e encerra o flusher antes de fechar
+    if (logger->async) {
+        async_stop(logger);
+    }
+
+    // Espera a thread auxiliar terminar trocas e compressões pendentes
+    rotate_stop(logger);
+
+    pthread_mutex_lock(&logger->mutex);
+    if (logger->file) {
+        fclose(logger->file);
+    }
+    pthread_mutex_unlock(&logger->mutex);
+
+    if (logger->binary) {
+        binary_stop(logger);
+    }
+
+    pthread_mutex_destroy(&logger->mutex);
+    free(logger);
+}
+
+void tslog_flush(logger_t *logger) {
+    if (!logger) return;
+
+    if (!logger->async) {
+        pthread_mutex_lock(&logger->mutex);
+        fflush(logger->file);
+        pthread_mutex_unlock(&logger->mutex);
+        return;
+    }
+
+    struct tslog_async *a = logger->async;
+    size_t target = atomic_load(&a->tail);
+
+    pthread_mutex_lock(&logger->mutex);
+    while (a->flushed_pos < target && !a->stopping) {
+        pthread_cond_signal(&a->wake);
+        pthread_cond_wait(&a->flushed, &logger->mutex);
+    }
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+void tslog_rotate(logger_t *logger) {
+    if (!logger || !logger->rotate) return;
+    atomic_store_explicit(&logger->rotate->requested, 1, memory_order_relaxed);
+}
+
+unsigned long tslog_dropped(logger_t *logger) {
+    if (!logger || !logger->async) return 0;
+    return atomic_load_explicit(&logger->async->dropped, memory_order_relaxed);
+}
+
+void tslog_set_level(logger_t *logger, int level) {
+    if (!logger) return;
+    atomic_store_explicit(&logger->min_level, level, memory_order_relaxed);
+}
+
+int tslog_parse_level(const char *name) {
+    static const char* const lower[] = { "debug", "info", "warn", "error" };
+    if (!name) return -1;
+    for (int i = 0; i < 4; i++) {
+        if (strcasecmp(name, lower[i]) == 0) return i;
+    }
+    if (strcasecmp(name, "off") == 0) return TSLOG_LEVEL_OFF;
+    return -1;
+}
+
+static void write_log(logger_t *logger, int level, const char *message) {
+    if (!message || !tslog_enabled(logger, level)) return;
+
+    if (logger->async) {
+        size_t pos;
+        tslog_slot_t *slot = reserve_slot(logger, &pos);
+        if (!slot) return;
+        fill_message(logger, &slot->rec, level, message);
+        publish_slot(logger, slot, pos);
+        return;
+    }
+
+    tslog_record_t rec;
+    fill_message(logger, &rec, level, message);
+    write_sync(logger, &rec);
+}
+
+void tslog_vemitf(logger_t *logger, int level, const char *fmt, va_list args) {
+    if (!fmt || !tslog_enabled(logger, level)) return;
+
+    if (logger->async) {
+        size_t pos;
+        tslog_slot_t *slot = reserve_slot(logger, &pos);
+        if (!slot) return;
+        fill_formatted(logger, &slot->rec, level, fmt, args);
+        publish_slot(logger, slot, pos);
+        return;
+    }
+
+    tslog_record_t rec;
+    fill_formatted(logger, &rec, level, fmt, args);
+    write_sync(logger, &rec);
+}
+
+void tslog_emitf(logger_t *logger, int level, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    tslog_vemitf(logger, level, fmt, args);
+    va_end(args);
+}
+
+void tslog_debug(logger_t *logger, const char *message) {
+    write_log(logger, LOG_DEBUG, message);
+}
+
+void tslog_info(logger_t *logger, const char *message) {
+    write_log(logger, LOG_INFO, message);
+}
+
+void tslog_warn(logger_t *logger, const char *message) {
+    write_log(logger, LOG_WARN, message);
+}
+
+void tslog_error(logger_t *logger, const char *message) {
+    write_log(logger, LOG_ERROR, message);
+}
@@ -1,25 +1,147 @@
-#ifndef LIBTSLOG_H
-#define LIBTSLOG_H
-
-#include <stdio.h>
-#include <pthread.h>
-
-// Níveis de log simples
-typedef enum {
-    LOG_INFO = 0,
-    LOG_ERROR = 1
-} log_level_t;
-
-// Estrutura do logger simples
-typedef struct {
-    FILE *file;
-    pthread_mutex_t mutex;
-} logger_t;
-
-// Funções principais
-logger_t* tslog_init(const char *filename);
-void tslog_destroy(logger_t *logger);
-void tslog_info(logger_t *logger, const char *message);
-void tslog_error(logger_t *logger, const char *message);
-
-#endif // LIBTSLOG_H
\ No newline at end of file
+#ifndef LIBTSLOG_H
+#define LIBTSLOG_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Valores numéricos dos níveis (usáveis em #if)
+#define TSLOG_LEVEL_DEBUG 0
+#define TSLOG_LEVEL_INFO  1
+#define TSLOG_LEVEL_WARN  2
+#define TSLOG_LEVEL_ERROR 3
+#define TSLOG_LEVEL_OFF   4
+
+// Piso em tempo de compilação: chamadas abaixo dele somem do binário.
+// Ex.: make CFLAGS+=-DTSLOG_COMPILE_LEVEL=TSLOG_LEVEL_WARN
+#ifndef TSLOG_COMPILE_LEVEL
+#define TSLOG_COMPILE_LEVEL TSLOG_LEVEL_DEBUG
+#endif
+
+// Níveis de log
+typedef enum {
+    LOG_DEBUG = TSLOG_LEVEL_DEBUG,
+    LOG_INFO = TSLOG_LEVEL_INFO,
+    LOG_WARN = TSLOG_LEVEL_WARN,
+    LOG_ERROR = TSLOG_LEVEL_ERROR
+} log_level_t;
+
+// Política quando o buffer do modo assíncrono está cheio
+typedef enum {
+    TSLOG_OVERFLOW_BLOCK = 0,   // produtor espera o flusher liberar espaço
+    TSLOG_OVERFLOW_DROP,        // descarta a mensagem mais nova
+    TSLOG_OVERFLOW_COUNT        // descarta e registra no log quantas foram perdidas
+} tslog_overflow_t;
+
+// Formato do arquivo de log
+typedef enum {
+    TSLOG_FORMAT_TEXT = 0,      // "[HH:MM:SS] LEVEL: mensagem"
+    TSLOG_FORMAT_BINARY         // registros binários (ver tslog_binary.h e tslog_decode)
+} tslog_format_t;
+
+// Tamanho máximo de uma mensagem (o resto é truncado)
+#define TSLOG_MSG_MAX 512
+
+// Opções de inicialização (preencher com tslog_options_default)
+typedef struct {
+    int async;                  // 0 = escrita síncrona, 1 = thread de flush dedicada
+    size_t queue_size;          // capacidade do ring (arredondada para potência de 2)
+    tslog_overflow_t overflow;  // política de estouro do ring
+    int flush_interval_ms;      // intervalo máximo entre flushes do arquivo
+    int min_level;              // nível mínimo inicial (padrão LOG_INFO)
+    tslog_format_t format;      // texto (padrão) ou binário
+    // Rotação: no modo síncrono o rename e o fopen rodam na thread auxiliar,
+    // fora do mutex dos produtores
+    size_t rotate_bytes;        // rotaciona ao atingir este tamanho (0 = desligado)
+    int rotate_seconds;         // rotaciona a cada N segundos, alinhado (0 = desligado)
+    int rotate_keep;            // arquivos rotacionados mantidos (0 = todos)
+    int rotate_gzip;            // comprime os rotacionados em segundo plano
+} tslog_options_t;
+
+struct tslog_async;
+struct tslog_binary;
+struct tslog_rotate;
+
+// Estrutura do logger simples
+typedef struct {
+    FILE *file;
+    pthread_mutex_t mutex;
+    struct tslog_async *async;  // NULL no modo síncrono
+    struct tslog_binary *binary; // tabela de formatos (NULL no formato texto)
+    struct tslog_rotate *rotate; // estado da rotação do arquivo
+    _Atomic int min_level;      // nível mínimo em tempo de execução
+} logger_t;
+
+// Funções principais
+logger_t* tslog_init(const char *filename);
+void tslog_destroy(logger_t *logger);
+void tslog_debug(logger_t *logger, const char *message);
+void tslog_info(logger_t *logger, const char *message);
+void tslog_warn(logger_t *logger, const char *message);
+void tslog_error(logger_t *logger, const char *message);
+
+// Nível mínimo em tempo de execução
+void tslog_set_level(logger_t *logger, int level);
+int tslog_parse_level(const char *name); // "debug", "info", "warn", "error"; -1 se inválido
+
+static inline int tslog_enabled(logger_t *logger, int level) {
+    return logger && level >= atomic_load_explicit(&logger->min_level, memory_order_relaxed);
+}
+
+// Formatação estilo printf: só acontece depois do filtro de nível.
+// No formato binário o formato não é expandido: grava-se o id do formato e os
+// argumentos brutos (o formato deve continuar válido, ex. literal de string).
+void tslog_emitf(logger_t *logger, int level, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void tslog_vemitf(logger_t *logger, int level, const char *fmt, va_list args);
+
+// Os argumentos não são avaliados quando o nível está desligado
+#define tslog_logf(logger, level, ...)                                        \
+    do {                                                                      \
+        if ((level) >= TSLOG_COMPILE_LEVEL && tslog_enabled((logger), (level))) \
+            tslog_emitf((logger), (level), __VA_ARGS__);                      \
+    } while (0)
+
+// Atalhos por nível; abaixo de TSLOG_COMPILE_LEVEL viram código morto
+// (o compilador remove a chamada, mas ainda checa o formato)
+#define TSLOG_DISCARD(logger, level, ...) \
+    do { if (0) tslog_emitf((logger), (level), __VA_ARGS__); } while (0)
+
+#if TSLOG_COMPILE_LEVEL <= TSLOG_LEVEL_DEBUG
+#define tslog_debugf(logger, ...) tslog_logf((logger), LOG_DEBUG, __VA_ARGS__)
+#else
+#define tslog_debugf(logger, ...) TSLOG_DISCARD((logger), LOG_DEBUG, __VA_ARGS__)
+#endif
+#if TSLOG_COMPILE_LEVEL <= TSLOG_LEVEL_INFO
+#define tslog_infof(logger, ...) tslog_logf((logger), LOG_INFO, __VA_ARGS__)
+#else
+#define tslog_infof(logger, ...) TSLOG_DISCARD((logger), LOG_INFO, __VA_ARGS__)
+#endif
+#if TSLOG_COMPILE_LEVEL <= TSLOG_LEVEL_WARN
+#define tslog_warnf(logger, ...) tslog_logf((logger), LOG_WARN, __VA_ARGS__)
+#else
+#define tslog_warnf(logger, ...) TSLOG_DISCARD((logger), LOG_WARN, __VA_ARGS__)
+#endif
+#if TSLOG_COMPILE_LEVEL <= TSLOG_LEVEL_ERROR
+#define tslog_errorf(logger, ...) tslog_logf((logger), LOG_ERROR, __VA_ARGS__)
+#else
+#define tslog_errorf(logger, ...) TSLOG_DISCARD((logger), LOG_ERROR, __VA_ARGS__)
+#endif
+
+// Inicialização com opções (modo assíncrono, política de estouro)
+void tslog_options_default(tslog_options_t *opts);
+logger_t* tslog_init_ex(const char *filename, const tslog_options_t *opts);
+
+// Barreira: retorna quando tudo que foi registrado antes da chamada está no arquivo
+void tslog_flush(logger_t *logger);
+
+// Pede uma rotação ao escritor (seguro em handler de sinal, ex. SIGHUP).
+// No modo assíncrono é atendida em até flush_interval_ms.
+void tslog_rotate(logger_t *logger);
+
+// Mensagens descartadas por estouro do ring (sempre 0 no modo síncrono)
+unsigned long tslog_dropped(logger_t *logger);
+
+#endif // LIBTSLOG_H
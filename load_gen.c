@@ -0,0 +1,577 @@
+#define _GNU_SOURCE
+#include "load_gen.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/timerfd.h>
+
+#define RESP_BUFFER 16384
+#define MAX_EVENTS 256
+#define TICK_MS 10              // verificação de timeouts e do fim do teste
+
+typedef enum {
+    C_IDLE = 0,                 // livre (conectada ou não)
+    C_CONNECTING,
+    C_SENDING,
+    C_READING
+} cstate_t;
+
+typedef struct {
+    int fd;                     // -1 = desconectada
+    cstate_t state;
+    int fresh;                  // conectou para este pedido (sem retry)
+    int url;
+    size_t req_sent;
+    uint64_t start_us;          // referência da latência
+    uint64_t deadline_us;
+    size_t buf_len;
+    int header_done;
+    long long body_left;        // -1 = até o servidor fechar
+    int status;
+    int server_close;
+    uint64_t bytes;
+    char buf[RESP_BUFFER];
+} lconn_t;
+
+typedef struct {
+    const lg_config_t *cfg;
+    const struct sockaddr_in *addr;
+    char **reqs;                // texto pronto de cada URL
+    size_t *req_lens;
+    int total_weight;
+    int nconns;
+    lconn_t *conns;
+    int *idle;                  // pilha de conexões livres
+    int idle_count;
+    int epfd;
+    int timer_fd;               // laço aberto: acorda no horário do próximo pedido
+    uint64_t rng;
+    long budget;                // pedidos que ainda pode iniciar (-1 = sem limite)
+    uint64_t end_us;            // fim pela duração (0 = sem)
+    double interval_us;         // laço aberto: intervalo entre pedidos
+    double next_us;             // laço aberto: horário marcado do próximo
+    int inflight;
+    lg_result_t res;
+    pthread_t thread;
+} worker_t;
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+// ======================== HISTOGRAMA ========================
+
+// Log-linear em µs: exato até 32, depois 32 sub-baldes por potência de 2 (~3%)
+static int hist_index(uint64_t v) {
+    if (v < 32) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - 5;
+    int idx = (shift + 1) * 32 + (int)((v >> shift) - 32);
+    return idx < LG_HIST_BUCKETS ? idx : LG_HIST_BUCKETS - 1;
+}
+
+// Meio do balde
+static uint64_t hist_value(int idx) {
+    if (idx < 32) return idx;
+    int shift = idx / 32 - 1;
+    uint64_t mant = idx % 32 + 32;
+    return (mant << shift) + ((1ULL << shift) >> 1);
+}
+
+static void record(lg_result_t *r, uint64_t us) {
+    r->hist[hist_index(us)]++;
+    r->lat_sum_us += us;
+    if (r->completed == 0 || us < r->lat_min_us) r->lat_min_us = us;
+    if (us > r->lat_max_us) r->lat_max_us = us;
+    r->completed++;
+}
+
+double lg_percentile_ms(const lg_result_t *r, double q) {
+    if (r->completed == 0) return 0;
+    uint64_t rank = (uint64_t)(q * r->completed + 0.999999), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int i = 0; i < LG_HIST_BUCKETS; i++) {
+        seen += r->hist[i];
+        if (seen >= rank) {
+            uint64_t v = hist_value(i);
+            if (v > r->lat_max_us) v = r->lat_max_us;
+            return v / 1000.0;
+        }
+    }
+    return r->lat_max_us / 1000.0;
+}
+
+// ======================== CONFIGURAÇÃO ========================
+
+void lg_config_default(lg_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->host = "127.0.0.1";
+    cfg->port = 8080;
+    cfg->threads = 2;
+    cfg->connections = 16;
+    cfg->keep_alive = 1;
+    cfg->duration_s = 10;
+    cfg->timeout_ms = 5000;
+}
+
+static int add_url(lg_config_t *cfg, const char *path, int weight) {
+    if (cfg->url_count >= LG_MAX_URLS || weight <= 0 || path[0] != '/') return -1;
+    char *copy = strdup(path);
+    if (!copy) return -1;
+    cfg->urls[cfg->url_count].path = copy;
+    cfg->urls[cfg->url_count].weight = weight;
+    cfg->url_count++;
+    return 0;
+}
+
+int lg_add_url(lg_config_t *cfg, const char *spec) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s", spec);
+    int weight = 1;
+    char *colon = strrchr(path, ':');
+    if (colon) {
+        char *end;
+        weight = (int)strtol(colon + 1, &end, 10);
+        if (*end) return -1;
+        *colon = '\0';
+    }
+    return add_url(cfg, path, weight);
+}
+
+int lg_load_urls(lg_config_t *cfg, const char *file) {
+    FILE *f = fopen(file, "r");
+    if (!f) return -1;
+    char line[1024];
+    int ok = 0;
+    while (ok == 0 && fgets(line, sizeof(line), f)) {
+        char path[1024];
+        int weight = 1;
+        char *p = line + strspn(line, " \t");
+        if (*p == '#' || *p == '\n' || *p == '\r' || !*p) continue;
+        int n = sscanf(p, "%1023s %d", path, &weight);
+        if (n < 1) continue;
+        ok = add_url(cfg, path, weight);
+    }
+    fclose(f);
+    return ok;
+}
+
+// ======================== CONEXÕES ========================
+
+static void conn_reset(worker_t *w, lconn_t *c) {
+    if (c->fd >= 0) close(c->fd); // também sai do epoll
+    c->fd = -1;
+}
+
+static void make_idle(worker_t *w, lconn_t *c) {
+    c->state = C_IDLE;
+    w->idle[w->idle_count++] = (int)(c - w->conns);
+    w->inflight--;
+}
+
+static void fail(worker_t *w, lconn_t *c, uint64_t *counter) {
+    (*counter)++;
+    conn_reset(w, c);
+    make_idle(w, c);
+}
+
+static void finish(worker_t *w, lconn_t *c) {
+    record(&w->res, now_us() - c->start_us);
+    int cls = c->status / 100;
+    w->res.status[cls >= 1 && cls <= 5 ? cls : 0]++;
+    w->res.bytes += c->bytes;
+    if (!w->cfg->keep_alive || c->server_close) conn_reset(w, c);
+    make_idle(w, c);
+}
+
+// Abre a conexão (não bloqueante); 0 se conectou ou está em andamento
+static int open_conn(worker_t *w, lconn_t *c) {
+    c->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (c->fd < 0) return -1;
+    int one = 1;
+    setsockopt(c->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct epoll_event ev = { .events = EPOLLIN | EPOLLOUT | EPOLLET, .data.ptr = c };
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, c->fd, &ev) < 0) return -1;
+    c->fresh = 1;
+    if (connect(c->fd, (const struct sockaddr *)w->addr, sizeof(*w->addr)) == 0) {
+        c->state = C_SENDING;
+        return 0;
+    }
+    if (errno != EINPROGRESS) return -1;
+    c->state = C_CONNECTING;
+    return 0;
+}
+
+static void progress(worker_t *w, lconn_t *c);
+
+// Conexão reaproveitada que o servidor já tinha fechado (timeout ociosa ou
+// limite de pedidos): reconecta e reenvia, mantendo o horário de início
+static int retry_stale(worker_t *w, lconn_t *c) {
+    if (c->fresh || c->bytes > 0) return 0;
+    conn_reset(w, c);
+    c->req_sent = 0;
+    if (open_conn(w, c) < 0) {
+        fail(w, c, &w->res.err_connect);
+        return 1;
+    }
+    progress(w, c);
+    return 1;
+}
+
+// Cabeçalho completo em buf: status, Content-Length e Connection
+static int parse_head(lconn_t *c, size_t head_len) {
+    if (c->buf_len < 12 || strncmp(c->buf, "HTTP/1.", 7) != 0) return -1;
+    c->status = atoi(c->buf + 9);
+    c->body_left = -1;
+    c->server_close = 0;
+    char *line = memchr(c->buf, '\n', head_len);
+    while (line && line + 1 < c->buf + head_len) {
+        line++;
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            c->body_left = atoll(line + 15);
+        } else if (strncasecmp(line, "Connection:", 11) == 0) {
+            const char *v = line + 11;
+            while (*v == ' ') v++;
+            if (strncasecmp(v, "close", 5) == 0) c->server_close = 1;
+        }
+        line = memchr(line, '\n', c->buf + head_len - line);
+    }
+    // 1xx, 204 e 304 nunca têm corpo, mesmo sem Content-Length
+    if (c->status / 100 == 1 || c->status == 204 || c->status == 304) c->body_left = 0;
+    if (c->body_left < 0) {
+        c->server_close = 1; // corpo vai até o fechamento: -1 fica até lá
+    } else {
+        // Parte do corpo já veio com o cabeçalho; bytes a mais são ignorados
+        long long buffered = (long long)(c->buf_len - head_len);
+        c->body_left = c->body_left > buffered ? c->body_left - buffered : 0;
+    }
+    c->header_done = 1;
+    c->buf_len = 0;
+    return 0;
+}
+
+static void progress(worker_t *w, lconn_t *c) {
+    if (c->state == C_CONNECTING) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        getsockopt(c->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        if (err == EINPROGRESS || err == EALREADY) return;
+        if (err != 0) {
+            fail(w, c, &w->res.err_connect);
+            return;
+        }
+        c->state = C_SENDING;
+    }
+
+    if (c->state == C_SENDING) {
+        const char *req = w->reqs[c->url];
+        size_t req_len = w->req_lens[c->url];
+        while (c->req_sent < req_len) {
+            ssize_t n = send(c->fd, req + c->req_sent, req_len - c->req_sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                if (retry_stale(w, c)) return;
+                // Conexão nova que nem chegou a enviar: o connect falhou
+                fail(w, c, c->fresh && c->req_sent == 0 ? &w->res.err_connect : &w->res.err_io);
+                return;
+            }
+            c->req_sent += n;
+        }
+        c->state = C_READING;
+        c->buf_len = 0;
+        c->header_done = 0;
+        c->bytes = 0;
+    }
+
+    if (c->state != C_READING) return;
+    for (;;) {
+        ssize_t n = recv(c->fd, c->buf + c->buf_len, sizeof(c->buf) - c->buf_len, 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+            if (!retry_stale(w, c)) fail(w, c, &w->res.err_io);
+            return;
+        }
+        if (n == 0) {
+            // Fechou: só é resposta completa se o corpo ia até o fechamento
+            if (c->header_done && c->body_left < 0 && c->server_close) {
+                conn_reset(w, c);
+                finish(w, c);
+            } else if (!retry_stale(w, c)) {
+                fail(w, c, &w->res.err_io);
+            }
+            return;
+        }
+        c->bytes += n;
+
+        if (!c->header_done) {
+            c->buf_len += n;
+            char *end = memmem(c->buf, c->buf_len, "\r\n\r\n", 4);
+            if (!end) {
+                if (c->buf_len < sizeof(c->buf)) continue;
+                fail(w, c, &w->res.err_io);
+                return;
+            }
+            if (parse_head(c, end + 4 - c->buf) < 0) {
+                fail(w, c, &w->res.err_io);
+                return;
+            }
+        } else if (c->body_left > 0) {
+            // Corpo descartado, o buffer é reusado; bytes a mais são ignorados
+            c->body_left = c->body_left > n ? c->body_left - n : 0;
+        }
+        if (c->header_done && c->body_left == 0) {
+            finish(w, c);
+            return;
+        }
+    }
+}
+
+static int pick_url(worker_t *w) {
+    if (w->cfg->url_count == 1) return 0;
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    int r = (int)(w->rng % (uint64_t)w->total_weight);
+    for (int i = 0; i < w->cfg->url_count; i++) {
+        r -= w->cfg->urls[i].weight;
+        if (r < 0) return i;
+    }
+    return 0;
+}
+
+static void start_request(worker_t *w, uint64_t start) {
+    lconn_t *c = &w->conns[w->idle[--w->idle_count]];
+    w->inflight++;
+    if (w->budget > 0) w->budget--;
+    c->url = pick_url(w);
+    c->start_us = start;
+    c->deadline_us = now_us() + (uint64_t)w->cfg->timeout_ms * 1000;
+    c->req_sent = 0;
+    c->bytes = 0;
+    if (c->fd < 0) {
+        if (open_conn(w, c) < 0) {
+            fail(w, c, &w->res.err_connect);
+            return;
+        }
+    } else {
+        c->fresh = 0;
+        c->state = C_SENDING;
+    }
+    progress(w, c);
+}
+
+// Inicia o que estiver na hora, enquanto houver conexão livre
+static void dispatch(worker_t *w, uint64_t now) {
+    while (w->idle_count > 0 && w->budget != 0) {
+        if (w->interval_us > 0) {
+            if (w->next_us > (double)now) break;
+            if (w->end_us && w->next_us >= (double)w->end_us) break;
+            uint64_t scheduled = (uint64_t)w->next_us;
+            w->next_us += w->interval_us;
+            start_request(w, scheduled); // latência desde o horário marcado
+        } else {
+            start_request(w, now);
+        }
+    }
+}
+
+static void check_timeouts(worker_t *w, uint64_t now) {
+    for (int i = 0; i < w->nconns; i++) {
+        lconn_t *c = &w->conns[i];
+        if (c->state != C_IDLE && now >= c->deadline_us) fail(w, c, &w->res.err_timeout);
+    }
+}
+
+static void* worker_main(void *arg) {
+    worker_t *w = arg;
+    struct epoll_event events[MAX_EVENTS];
+    uint64_t start = now_us(), last_tick = start;
+    if (w->cfg->duration_s > 0) w->end_us = start + (uint64_t)(w->cfg->duration_s * 1e6);
+    w->next_us = start;
+
+    for (;;) {
+        uint64_t now = now_us();
+        int stopping = (w->end_us && now >= w->end_us) || w->budget == 0;
+        if (!stopping) dispatch(w, now);
+        if (stopping && w->inflight == 0) break;
+
+        if (now - last_tick >= TICK_MS * 1000) {
+            check_timeouts(w, now);
+            last_tick = now;
+        }
+
+        // Laço aberto: o epoll só tem resolução de ms, o timerfd acorda na hora
+        // marcada sem girar a CPU
+        if (w->interval_us > 0 && w->idle_count > 0 && !stopping && w->next_us > (double)now) {
+            uint64_t at = (uint64_t)w->next_us;
+            struct itimerspec its = {0};
+            its.it_value.tv_sec = at / 1000000;
+            its.it_value.tv_nsec = (at % 1000000) * 1000;
+            timerfd_settime(w->timer_fd, TFD_TIMER_ABSTIME, &its, NULL);
+        }
+        int n = epoll_wait(w->epfd, events, MAX_EVENTS, TICK_MS);
+        for (int i = 0; i < n; i++) {
+            lconn_t *c = events[i].data.ptr;
+            if (!c) {
+                uint64_t expirations;
+                if (read(w->timer_fd, &expirations, sizeof(expirations)) < 0) {}
+                continue;
+            }
+            if (c->state != C_IDLE) progress(w, c);
+        }
+    }
+
+    w->res.elapsed_s = (now_us() - start) / 1e6;
+    for (int i = 0; i < w->nconns; i++) conn_reset(w, &w->conns[i]);
+    return NULL;
+}
+
+static void merge(lg_result_t *into, const lg_result_t *from) {
+    if (from->completed && (into->completed == 0 || from->lat_min_us < into->lat_min_us)) {
+        into->lat_min_us = from->lat_min_us;
+    }
+    if (from->lat_max_us > into->lat_max_us) into->lat_max_us = from->lat_max_us;
+    into->completed += from->completed;
+    into->bytes += from->bytes;
+    for (int i = 0; i < 6; i++) into->status[i] += from->status[i];
+    into->err_connect += from->err_connect;
+    into->err_timeout += from->err_timeout;
+    into->err_io += from->err_io;
+    into->lat_sum_us += from->lat_sum_us;
+    for (int i = 0; i < LG_HIST_BUCKETS; i++) into->hist[i] += from->hist[i];
+    if (from->elapsed_s > into->elapsed_s) into->elapsed_s = from->elapsed_s;
+}
+
+int lg_run(const lg_config_t *cfg, lg_result_t *result) {
+    memset(result, 0, sizeof(*result));
+    if (cfg->threads < 1 || cfg->connections < cfg->threads || cfg->url_count < 1) return -1;
+    if (cfg->duration_s <= 0 && cfg->requests <= 0) return -1;
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg->port);
+    if (inet_pton(AF_INET, cfg->host, &addr.sin_addr) <= 0) return -1;
+
+    // Muitas conexões: sobe o limite de descritores até o máximo
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    char *reqs[LG_MAX_URLS];
+    size_t req_lens[LG_MAX_URLS];
+    int total_weight = 0;
+    for (int i = 0; i < cfg->url_count; i++) {
+        int len = asprintf(&reqs[i], "GET %s HTTP/1.1\r\nHost: %s:%d\r\nConnection: %s\r\n\r\n",
+                           cfg->urls[i].path, cfg->host, cfg->port,
+                           cfg->keep_alive ? "keep-alive" : "close");
+        if (len < 0) return -1;
+        req_lens[i] = len;
+        total_weight += cfg->urls[i].weight;
+    }
+
+    worker_t *workers = calloc(cfg->threads, sizeof(worker_t));
+    if (!workers) return -1;
+    int started = 0;
+    for (int t = 0; t < cfg->threads; t++) {
+        worker_t *w = &workers[t];
+        w->cfg = cfg;
+        w->addr = &addr;
+        w->reqs = reqs;
+        w->req_lens = req_lens;
+        w->total_weight = total_weight;
+        w->nconns = cfg->connections / cfg->threads + (t < cfg->connections % cfg->threads);
+        w->conns = calloc(w->nconns, sizeof(lconn_t));
+        w->idle = calloc(w->nconns, sizeof(int));
+        w->epfd = epoll_create1(EPOLL_CLOEXEC);
+        w->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+        if (w->epfd >= 0 && w->timer_fd >= 0) epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->timer_fd, &ev);
+        w->rng = 0x9e3779b97f4a7c15ULL * (t + 1);
+        w->budget = cfg->requests > 0 ? cfg->requests / cfg->threads + (t < cfg->requests % cfg->threads) : -1;
+        if (cfg->rate > 0) w->interval_us = 1e6 * cfg->threads / cfg->rate;
+        if (!w->conns || !w->idle || w->epfd < 0 || w->timer_fd < 0) break;
+        for (int i = 0; i < w->nconns; i++) {
+            w->conns[i].fd = -1;
+            w->idle[i] = w->nconns - 1 - i;
+        }
+        w->idle_count = w->nconns;
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) break;
+        started++;
+    }
+
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+        merge(result, &workers[t].res);
+    }
+    for (int t = 0; t < cfg->threads; t++) {
+        free(workers[t].conns);
+        free(workers[t].idle);
+        if (workers[t].epfd > 0) close(workers[t].epfd);
+        if (workers[t].timer_fd > 0) close(workers[t].timer_fd);
+    }
+    free(workers);
+    for (int i = 0; i < cfg->url_count; i++) free(reqs[i]);
+    return started == cfg->threads ? 0 : -1;
+}
+
+// ======================== SAÍDA ========================
+
+static void json_string(FILE *out, const char *s) {
+    fputc('"', out);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', out);
+        if ((unsigned char)*s < 0x20) fprintf(out, "\\u%04x", *s);
+        else fputc(*s, out);
+    }
+    fputc('"', out);
+}
+
+void lg_print_json(FILE *out, const lg_config_t *cfg, const lg_result_t *r) {
+    double elapsed = r->elapsed_s > 0 ? r->elapsed_s : 1e-9;
+    fprintf(out, "{\n  \"config\": {\"host\": ");
+    json_string(out, cfg->host);
+    fprintf(out, ", \"port\": %d, \"threads\": %d, \"connections\": %d, \"keep_alive\": %s, "
+                 "\"rate\": %g, \"duration_s\": %g, \"requests\": %ld, \"timeout_ms\": %d, \"urls\": [",
+            cfg->port, cfg->threads, cfg->connections, cfg->keep_alive ? "true" : "false",
+            cfg->rate, cfg->duration_s, cfg->requests, cfg->timeout_ms);
+    for (int i = 0; i < cfg->url_count; i++) {
+        fprintf(out, "%s{\"path\": ", i ? ", " : "");
+        json_string(out, cfg->urls[i].path);
+        fprintf(out, ", \"weight\": %d}", cfg->urls[i].weight);
+    }
+    fprintf(out, "]},\n");
+    fprintf(out, "  \"mode\": \"%s\",\n", cfg->rate > 0 ? "open-loop" : "closed-loop");
+    fprintf(out, "  \"requests\": %llu,\n", (unsigned long long)r->completed);
+    fprintf(out, "  \"elapsed_s\": %.3f,\n", r->elapsed_s);
+    fprintf(out, "  \"throughput_rps\": %.1f,\n", r->completed / elapsed);
+    fprintf(out, "  \"bytes\": %llu,\n", (unsigned long long)r->bytes);
+    fprintf(out, "  \"transfer_mbps\": %.2f,\n", r->bytes * 8 / elapsed / 1e6);
+    fprintf(out, "  \"status\": {\"2xx\": %llu, \"3xx\": %llu, \"4xx\": %llu, \"5xx\": %llu, \"other\": %llu},\n",
+            (unsigned long long)r->status[2], (unsigned long long)r->status[3],
+            (unsigned long long)r->status[4], (unsigned long long)r->status[5],
+            (unsigned long long)(r->status[0] + r->status[1]));
+    fprintf(out, "  \"errors\": {\"connect\": %llu, \"timeout\": %llu, \"io\": %llu},\n",
+            (unsigned long long)r->err_connect, (unsigned long long)r->err_timeout,
+            (unsigned long long)r->err_io);
+    fprintf(out, "  \"latency_ms\": {\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+                 "\"p99\": %.3f, \"p999\": %.3f, \"max\": %.3f}\n}\n",
+            r->lat_min_us / 1000.0, r->completed ? r->lat_sum_us / 1000.0 / r->completed : 0.0,
+            lg_percentile_ms(r, 0.50), lg_percentile_ms(r, 0.90), lg_percentile_ms(r, 0.99),
+            lg_percentile_ms(r, 0.999), r->lat_max_us / 1000.0);
+}
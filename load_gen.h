@@ -0,0 +1,62 @@
+#ifndef LOAD_GEN_H
+#define LOAD_GEN_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Gerador de carga HTTP do web_client (modo benchmark). Cada thread tem
+// seu próprio epoll com connections/threads conexões não bloqueantes.
+//
+// - Laço fechado (rate = 0): cada conexão manda o próximo pedido assim que
+//   recebe a resposta; a latência conta a partir do envio.
+// - Laço aberto (rate > 0): os pedidos têm horário marcado (1/rate entre
+//   eles) e a latência conta a partir do horário marcado, não do envio.
+//   Se o servidor atrasa, os pedidos atrasados pagam a espera e os
+//   percentis não escondem a lentidão (coordinated omission).
+
+#define LG_MAX_URLS 64
+#define LG_HIST_BUCKETS 1280    // log-linear: 32 sub-baldes por potência de 2 (µs)
+
+typedef struct {
+    const char *path;
+    int weight;
+} lg_url_t;
+
+typedef struct {
+    const char *host;
+    int port;
+    int threads;
+    int connections;            // total, dividido entre as threads
+    int keep_alive;             // 0 = uma conexão por requisição
+    double duration_s;          // 0 = só pelo número de requisições
+    long requests;              // 0 = só pela duração
+    double rate;                // req/s no total; 0 = laço fechado
+    int timeout_ms;             // por requisição
+    lg_url_t urls[LG_MAX_URLS];
+    int url_count;
+} lg_config_t;
+
+typedef struct {
+    uint64_t completed;
+    uint64_t bytes;
+    uint64_t status[6];         // [1..5] = 1xx..5xx, [0] = outros
+    uint64_t err_connect;
+    uint64_t err_timeout;
+    uint64_t err_io;            // conexão caiu ou resposta malformada
+    uint64_t hist[LG_HIST_BUCKETS];
+    uint64_t lat_sum_us;
+    uint64_t lat_min_us;
+    uint64_t lat_max_us;
+    double elapsed_s;
+} lg_result_t;
+
+void lg_config_default(lg_config_t *cfg);
+// "caminho" ou "caminho:peso"; retorna -1 se inválido ou sem espaço
+int lg_add_url(lg_config_t *cfg, const char *spec);
+// Uma URL por linha ("caminho peso"), '#' comenta
+int lg_load_urls(lg_config_t *cfg, const char *file);
+int lg_run(const lg_config_t *cfg, lg_result_t *result);
+void lg_print_json(FILE *out, const lg_config_t *cfg, const lg_result_t *result);
+double lg_percentile_ms(const lg_result_t *result, double q);
+
+#endif // LOAD_GEN_H
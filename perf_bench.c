@@ -0,0 +1,428 @@
+#define _GNU_SOURCE
+#include "libtslog.h"
+#include "load_gen.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <sys/wait.h>
+
+// Suíte de regressão de desempenho (make bench):
+// 1. vazão do logger com 1 a 64 threads (síncrono, assíncrono e binário);
+// 2. web_server numa porta livre, com cenários do gerador de carga
+//    (acerto pequeno, 404, arquivo grande, keep-alive);
+// 3. resultado em JSON, comparado com o baseline gravado: vazão abaixo ou
+//    latência p50 acima da tolerância, ou qualquer erro, falha a suíte.
+
+#define MAX_METRICS 128
+#define LOGGER_MESSAGES 200000
+#define LOGGER_REPEAT 3             // melhor de N: rodadas curtas oscilam muito
+#define LARGE_FILE_SIZE (4 << 20)   // acima do limite do sendfile
+#define SERVER_START_MS 5000
+
+typedef enum {
+    INFO = 0,                   // só reportada (ex.: p99, ruidosa demais)
+    HIGHER,                     // maior é melhor
+    LOWER                       // menor é melhor
+} direction_t;
+
+typedef struct {
+    char name[64];
+    double value;
+    direction_t better;
+} metric_t;
+
+static metric_t metrics[MAX_METRICS];
+static int metric_count;
+static int had_errors;
+
+static void add_metric(direction_t better, double value, const char *fmt, ...) {
+    if (metric_count >= MAX_METRICS) return;
+    metric_t *m = &metrics[metric_count++];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(m->name, sizeof(m->name), fmt, ap);
+    va_end(ap);
+    m->value = value;
+    m->better = better;
+}
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// ======================== LOGGER ========================
+
+typedef struct {
+    logger_t *logger;
+    int id;
+    long count;
+} log_worker_t;
+
+static void* log_worker(void *arg) {
+    log_worker_t *w = arg;
+    for (long i = 0; i < w->count; i++) {
+        tslog_infof(w->logger, "[REQ #%ld] GET /index.html thread %d", i, w->id);
+    }
+    return NULL;
+}
+
+static double logger_run(const char *file, int async, tslog_format_t format, int threads) {
+    tslog_options_t opts;
+    tslog_options_default(&opts);
+    opts.async = async;
+    opts.format = format;
+    logger_t *logger = tslog_init_ex(file, &opts);
+    if (!logger) return 0;
+
+    pthread_t tids[64];
+    log_worker_t workers[64];
+    double start = now_sec();
+    for (int i = 0; i < threads; i++) {
+        workers[i] = (log_worker_t){ logger, i, LOGGER_MESSAGES / threads };
+        pthread_create(&tids[i], NULL, log_worker, &workers[i]);
+    }
+    for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+    tslog_flush(logger); // o assíncrono só conta quando chegou ao arquivo
+    double elapsed = now_sec() - start;
+    tslog_destroy(logger);
+    unlink(file);
+    return (LOGGER_MESSAGES / threads) * threads / elapsed;
+}
+
+static void bench_logger(const char *dir) {
+    static const int thread_counts[] = { 1, 2, 4, 8, 16, 32, 64 };
+    static const struct { const char *name; int async; tslog_format_t format; } modes[] = {
+        { "sync", 0, TSLOG_FORMAT_TEXT },
+        { "async", 1, TSLOG_FORMAT_TEXT },
+        { "binary", 1, TSLOG_FORMAT_BINARY },
+    };
+    char file[512];
+    snprintf(file, sizeof(file), "%s/bench.log", dir);
+
+    fprintf(stderr, "\n== Logger: msg/s, %d mensagens por rodada, melhor de %d ==\n%-8s",
+            LOGGER_MESSAGES, LOGGER_REPEAT, "threads");
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) fprintf(stderr, " %12s", modes[m].name);
+    fprintf(stderr, "\n");
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        fprintf(stderr, "%-8d", thread_counts[t]);
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            double rate = 0;
+            for (int r = 0; r < LOGGER_REPEAT; r++) {
+                double run = logger_run(file, modes[m].async, modes[m].format, thread_counts[t]);
+                if (run > rate) rate = run;
+            }
+            fprintf(stderr, " %12.0f", rate);
+            add_metric(HIGHER, rate, "logger.%s.t%d.msgs_per_s", modes[m].name, thread_counts[t]);
+        }
+        fprintf(stderr, "\n");
+    }
+}
+
+// ======================== SERVIDOR ========================
+
+static int write_file(const char *dir, const char *name, size_t size, char fill) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    if (fill == 0) {
+        fprintf(f, "<!DOCTYPE html><html><body><h1>bench</h1>");
+        for (size_t n = 42; n + 21 < size; n += 21) fprintf(f, "<p>texto de teste</p>");
+        fprintf(f, "</body></html>\n");
+    } else {
+        char block[4096];
+        memset(block, fill, sizeof(block));
+        for (size_t n = 0; n < size; n += sizeof(block)) fwrite(block, 1, sizeof(block), f);
+    }
+    return fclose(f);
+}
+
+// Inicia ./web_server com porta 0 e lê a porta que ele anunciou na saída
+static pid_t start_server(const char *dir, const char *mode, int *port) {
+    int pipefd[2];
+    if (pipe(pipefd) < 0) return -1;
+    char log_file[512];
+    snprintf(log_file, sizeof(log_file), "%s/web_server.log", dir);
+
+    pid_t pid = fork();
+    if (pid < 0) return -1;
+    if (pid == 0) {
+        dup2(pipefd[1], STDOUT_FILENO);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        execl("./web_server", "web_server", "0", "--mode", mode, "--root", dir,
+              "--log-file", log_file, (char *)NULL);
+        _exit(127);
+    }
+    close(pipefd[1]);
+
+    FILE *out = fdopen(pipefd[0], "r");
+    char line[256];
+    *port = 0;
+    while (*port == 0 && fgets(line, sizeof(line), out)) {
+        sscanf(line, "Escutando em http://localhost:%d", port);
+    }
+    // O resto da saída é descartado (o servidor ignora SIGPIPE)
+    fclose(out);
+    if (*port <= 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+        return -1;
+    }
+    return pid;
+}
+
+static void stop_server(pid_t pid) {
+    kill(pid, SIGINT);
+    for (int i = 0; i < SERVER_START_MS / 10; i++) {
+        if (waitpid(pid, NULL, WNOHANG) == pid) return;
+        usleep(10000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+}
+
+typedef struct {
+    const char *name;
+    const char *url;
+    int connections;
+    int keep_alive;
+} scenario_t;
+
+static void bench_server(const char *dir, const char *mode, int port, double duration) {
+    static const scenario_t scenarios[] = {
+        { "small_hit", "/small.html", 16, 0 },  // uma conexão por requisição
+        { "not_found", "/naoexiste", 16, 0 },
+        { "large_file", "/large.bin", 4, 1 },
+        { "keep_alive", "/small.html", 16, 1 },
+    };
+
+    fprintf(stderr, "\n== Servidor (modo %s, porta %d, %.0fs por cenario) ==\n", mode, port, duration);
+    fprintf(stderr, "%-12s %10s %10s %10s %10s %8s\n", "cenario", "req/s", "MB/s", "p50 ms", "p99 ms", "erros");
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        const scenario_t *s = &scenarios[i];
+        lg_config_t cfg;
+        lg_config_default(&cfg);
+        cfg.port = port;
+        cfg.threads = 2;
+        cfg.connections = s->connections;
+        cfg.keep_alive = s->keep_alive;
+        lg_add_url(&cfg, s->url);
+
+        // Aquece o cache e o pool antes de medir
+        static lg_result_t result;
+        cfg.duration_s = duration / 10 > 0.2 ? duration / 10 : 0.2;
+        lg_run(&cfg, &result);
+        cfg.duration_s = duration;
+        if (lg_run(&cfg, &result) < 0) {
+            fprintf(stderr, "%-12s falhou ao iniciar\n", s->name);
+            had_errors = 1;
+            continue;
+        }
+
+        double elapsed = result.elapsed_s > 0 ? result.elapsed_s : 1;
+        uint64_t errors = result.err_connect + result.err_timeout + result.err_io;
+        double rps = result.completed / elapsed;
+        double mbps = result.bytes / elapsed / 1e6;
+        double p50 = lg_percentile_ms(&result, 0.50), p99 = lg_percentile_ms(&result, 0.99);
+        fprintf(stderr, "%-12s %10.0f %10.1f %10.3f %10.3f %8llu\n",
+                s->name, rps, mbps, p50, p99, (unsigned long long)errors);
+        if (errors > 0) had_errors = 1;
+
+        add_metric(HIGHER, rps, "server.%s.rps", s->name);
+        add_metric(INFO, mbps, "server.%s.mb_per_s", s->name);
+        add_metric(LOWER, p50, "server.%s.p50_ms", s->name);
+        add_metric(INFO, p99, "server.%s.p99_ms", s->name);
+        add_metric(INFO, (double)errors, "server.%s.errors", s->name);
+    }
+}
+
+// ======================== RESULTADO ========================
+
+static int write_results(const char *path, const char *mode, double duration) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    char date[32];
+    time_t t = time(NULL);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    fprintf(f, "{\n  \"meta\": {\"date\": \"%s\", \"cpus\": %ld, \"server_mode\": \"%s\", \"duration_s\": %g},\n",
+            date, sysconf(_SC_NPROCESSORS_ONLN), mode, duration);
+    fprintf(f, "  \"metrics\": {\n");
+    for (int i = 0; i < metric_count; i++) {
+        fprintf(f, "    \"%s\": %.3f%s\n", metrics[i].name, metrics[i].value,
+                i + 1 < metric_count ? "," : "");
+    }
+    fprintf(f, "  }\n}\n");
+    return fclose(f);
+}
+
+// Lê "nome": valor do baseline (o formato gerado por write_results)
+static int baseline_value(FILE *f, const char *name, double *value) {
+    char line[256], key[128];
+    rewind(f);
+    while (fgets(line, sizeof(line), f)) {
+        double v;
+        if (sscanf(line, " \"%127[^\"]\": %lf", key, &v) == 2 && strcmp(key, name) == 0) {
+            *value = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Retorna o número de regressões
+static int compare_baseline(const char *path, double tolerance) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "\nSem baseline em %s (grave um com make bench-baseline)\n", path);
+        return 0;
+    }
+    fprintf(stderr, "\n== Comparacao com %s (tolerancia %.0f%%) ==\n", path, tolerance);
+    int regressions = 0;
+    for (int i = 0; i < metric_count; i++) {
+        metric_t *m = &metrics[i];
+        double base;
+        if (m->better == INFO || !baseline_value(f, m->name, &base) || base <= 0) continue;
+        double delta = (m->value - base) / base * 100;
+        int worse = m->better == HIGHER ? delta < -tolerance : delta > tolerance;
+        if (worse) regressions++;
+        fprintf(stderr, "%-36s %12.3f %12.3f %+8.1f%% %s\n", m->name, base, m->value, delta,
+                worse ? "REGRESSAO" : "ok");
+    }
+    fclose(f);
+    return regressions;
+}
+
+static int copy_file(const char *from, const char *to) {
+    FILE *in = fopen(from, "r"), *out = in ? fopen(to, "w") : NULL;
+    if (!out) {
+        if (in) fclose(in);
+        return -1;
+    }
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), in)) > 0) fwrite(buf, 1, n, out);
+    fclose(in);
+    return fclose(out);
+}
+
+static void remove_dir(const char *dir) {
+    static const char *files[] = { "index.html", "small.html", "large.bin", "web_server.log", "bench.log" };
+    char path[512];
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "%s/%s", dir, files[i]);
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [opcoes]\n"
+            "  -o, --out ARQ         resultado em JSON (padrao bench_results.json)\n"
+            "  -b, --baseline ARQ    baseline para comparar (padrao bench_baseline.json)\n"
+            "  -t, --tolerance PCT   piora aceita antes de falhar (padrao 15)\n"
+            "  -d, --duration S      duracao de cada cenario do servidor (padrao 3)\n"
+            "  -m, --mode MODO       modo do web_server (padrao epoll)\n"
+            "      --save-baseline   grava o resultado como novo baseline\n"
+            "      --skip-logger     so o servidor\n"
+            "      --skip-server     so o logger\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    const char *out_file = "bench_results.json";
+    const char *baseline = "bench_baseline.json";
+    const char *mode = "epoll";
+    double tolerance = 15, duration = 3;
+    int save_baseline = 0, skip_logger = 0, skip_server = 0;
+
+    static const struct option long_opts[] = {
+        {"out", required_argument, NULL, 'o'},
+        {"baseline", required_argument, NULL, 'b'},
+        {"tolerance", required_argument, NULL, 't'},
+        {"duration", required_argument, NULL, 'd'},
+        {"mode", required_argument, NULL, 'm'},
+        {"save-baseline", no_argument, NULL, 'S'},
+        {"skip-logger", no_argument, NULL, 'L'},
+        {"skip-server", no_argument, NULL, 'W'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt_c;
+    while ((opt_c = getopt_long(argc, argv, "o:b:t:d:m:h", long_opts, NULL)) != -1) {
+        switch (opt_c) {
+        case 'o': out_file = optarg; break;
+        case 'b': baseline = optarg; break;
+        case 't': tolerance = atof(optarg); break;
+        case 'd': duration = atof(optarg); break;
+        case 'm': mode = optarg; break;
+        case 'S': save_baseline = 1; break;
+        case 'L': skip_logger = 1; break;
+        case 'W': skip_server = 1; break;
+        default:
+            print_usage(argv[0]);
+            return opt_c == 'h' ? 0 : 1;
+        }
+    }
+    if (duration <= 0 || tolerance < 0) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    // Raiz própria para o servidor: arquivos do benchmark sem tocar em www/
+    char dir[] = "/tmp/web_bench.XXXXXX";
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "ERRO: mkdtemp: %s\n", strerror(errno));
+        return 1;
+    }
+
+    if (!skip_logger) bench_logger(dir);
+
+    if (!skip_server) {
+        int port;
+        pid_t pid = -1;
+        if (write_file(dir, "index.html", 1024, 0) == 0 && write_file(dir, "small.html", 1024, 0) == 0 &&
+            write_file(dir, "large.bin", LARGE_FILE_SIZE, 'x') == 0) {
+            pid = start_server(dir, mode, &port);
+        }
+        if (pid < 0) {
+            fprintf(stderr, "ERRO: nao foi possivel iniciar ./web_server\n");
+            remove_dir(dir);
+            return 1;
+        }
+        bench_server(dir, mode, port, duration);
+        stop_server(pid);
+    }
+    remove_dir(dir);
+
+    if (write_results(out_file, mode, duration) < 0) {
+        fprintf(stderr, "ERRO: Falha ao gravar %s: %s\n", out_file, strerror(errno));
+        return 1;
+    }
+    fprintf(stderr, "\nResultado em %s\n", out_file);
+
+    if (save_baseline) {
+        if (copy_file(out_file, baseline) < 0) {
+            fprintf(stderr, "ERRO: Falha ao gravar %s\n", baseline);
+            return 1;
+        }
+        fprintf(stderr, "Baseline gravado em %s\n", baseline);
+        return had_errors;
+    }
+
+    int regressions = compare_baseline(baseline, tolerance);
+    if (had_errors) fprintf(stderr, "FALHOU: houve erros nas requisicoes\n");
+    if (regressions) fprintf(stderr, "FALHOU: %d metricas pioraram mais que %.0f%%\n", regressions, tolerance);
+    return had_errors || regressions ? 1 : 0;
+}
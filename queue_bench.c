@@ -0,0 +1,88 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Compara as filas de trabalho (mutex x ring) com 1, 8 e 64 workers.
+// Produtores fazem o papel do acceptor/event loops e empurram pedidos
+// falsos; cada worker simula um trabalho curto antes do próximo pop.
+
+#define DEFAULT_ITEMS 500000
+#define QUEUE_CAPACITY MAX_QUEUE_SIZE
+
+volatile sig_atomic_t g_running = 1;
+
+static work_queue_t *queue;
+static long items_per_producer;
+static int work_spins;
+static request_t dummy;
+static _Atomic long consumed;
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void* producer(void *arg) {
+    for (long i = 0; i < items_per_producer; i++) {
+        while (work_queue_push(queue, &dummy) < 0) {}
+    }
+    return NULL;
+}
+
+static void* worker(void *arg) {
+    volatile int spin;
+    while (work_queue_pop(queue, -1)) {
+        for (spin = 0; spin < work_spins; spin++) {}
+        atomic_fetch_add_explicit(&consumed, 1, memory_order_relaxed);
+    }
+    return NULL;
+}
+
+static double run(queue_kind_t kind, int producers, int workers, long items) {
+    pthread_t prod[producers], work[workers];
+
+    g_running = 1;
+    atomic_store(&consumed, 0);
+    items_per_producer = items / producers;
+    long total = items_per_producer * producers;
+    queue = work_queue_init(kind, QUEUE_CAPACITY);
+
+    double start = now_sec();
+    for (int i = 0; i < workers; i++) pthread_create(&work[i], NULL, worker, NULL);
+    for (int i = 0; i < producers; i++) pthread_create(&prod[i], NULL, producer, NULL);
+    for (int i = 0; i < producers; i++) pthread_join(prod[i], NULL);
+    while (atomic_load(&consumed) < total) sched_yield();
+    double elapsed = now_sec() - start;
+
+    g_running = 0;
+    work_queue_shutdown(queue);
+    for (int i = 0; i < workers; i++) pthread_join(work[i], NULL);
+    work_queue_destroy(queue, NULL);
+    return total / elapsed;
+}
+
+int main(int argc, char *argv[]) {
+    long items = argc > 1 ? atol(argv[1]) : DEFAULT_ITEMS;
+    work_spins = argc > 2 ? atoi(argv[2]) : 100;
+    if (items <= 0) items = DEFAULT_ITEMS;
+
+    static const int worker_counts[] = { 1, 8, 64 };
+    static const int producer_counts[] = { 1, 4 };
+
+    printf("%-11s %8s %12s %12s %8s\n", "produtores", "workers", "mutex op/s", "ring op/s", "ganho");
+    for (size_t p = 0; p < sizeof(producer_counts) / sizeof(producer_counts[0]); p++) {
+        for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+            double m = run(QUEUE_MUTEX, producer_counts[p], worker_counts[w], items);
+            double r = run(QUEUE_RING, producer_counts[p], worker_counts[w], items);
+            printf("%-11d %8d %12.0f %12.0f %7.2fx\n",
+                   producer_counts[p], worker_counts[w], m, r, r / m);
+        }
+    }
+    printf("(%ld pedidos por rodada, fila de %d, %d voltas de trabalho por pedido)\n",
+           items, QUEUE_CAPACITY, work_spins);
+    return 0;
+}
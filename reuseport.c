@@ -0,0 +1,148 @@
+#define _GNU_SOURCE
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+// Modo reuseport: cada listener tem seu próprio socket com SO_REUSEPORT na
+// mesma porta e atende as conexões que aceita na própria thread. O kernel
+// distribui as conexões entre os sockets; não há fila compartilhada. Como
+// a thread do listener fica presa enquanto atende, cada conexão leva um só
+// pedido e "Connection: close": um cliente ocioso em keep-alive seguraria o
+// listener (e quem mais chegou nele) até o keepalive_timeout.
+
+#define ACCEPT_POLL_MS 500      // para perceber o fim de g_running
+
+typedef struct {
+    int id;
+    int fd;
+    int cpu;                    // -1 = sem afinidade
+    pthread_t thread;
+    _Alignas(CACHE_LINE) _Atomic unsigned long accepted; // sem false sharing entre vizinhos
+} listener_t;
+
+static listener_t *listeners;
+static int listener_count;
+
+static int open_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) goto fail;
+
+    struct sockaddr_in addr = {0};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) goto fail;
+    if (listen(fd, SOMAXCONN) < 0) goto fail;
+    return fd;
+
+fail:
+    close(fd);
+    return -1;
+}
+
+static void* listener_thread(void *arg) {
+    listener_t *l = arg;
+
+    if (l->cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(l->cpu, &set);
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (err != 0) {
+            tslog_warnf(server.logger, "[LISTENER %d] Afinidade com CPU %d falhou: %s",
+                        l->id, l->cpu, strerror(err));
+        }
+    }
+    tslog_debugf(server.logger, "Listener #%d iniciado (cpu %d)", l->id, l->cpu);
+
+    struct pollfd pfd = { .fd = l->fd, .events = POLLIN };
+    while (g_running) {
+        if (poll(&pfd, 1, ACCEPT_POLL_MS) <= 0) continue;
+        int client_socket = accept(l->fd, NULL, NULL);
+        if (client_socket < 0) continue;
+
+        request_t *req = request_new(client_socket);
+        if (!req) {
+            close(client_socket);
+            continue;
+        }
+        atomic_fetch_add_explicit(&l->accepted, 1, memory_order_relaxed);
+        req->single = 1;
+        handle_client_request(req);
+    }
+
+    tslog_debugf(server.logger, "Listener #%d finalizando", l->id);
+    return NULL;
+}
+
+int reuseport_start(int port, int count, int pin) {
+    int ncpu = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    listeners = aligned_alloc(CACHE_LINE, count * sizeof(listener_t));
+    if (!listeners) return -1;
+    memset(listeners, 0, count * sizeof(listener_t));
+
+    for (int i = 0; i < count; i++) {
+        listener_t *l = &listeners[i];
+        l->id = i + 1;
+        l->cpu = pin ? i % ncpu : -1;
+        l->fd = open_listener(port);
+        if (l->fd < 0) {
+            tslog_errorf(server.logger, "Erro ao abrir listener %d na porta %d: %s",
+                         l->id, port, strerror(errno));
+            return -1;
+        }
+        // Porta 0: os demais listeners entram na porta que o kernel deu ao primeiro
+        if (port == 0) {
+            struct sockaddr_in addr;
+            socklen_t len = sizeof(addr);
+            if (getsockname(l->fd, (struct sockaddr*)&addr, &len) == 0) port = ntohs(addr.sin_port);
+        }
+        if (pthread_create(&l->thread, NULL, listener_thread, l) != 0) {
+            close(l->fd);
+            return -1;
+        }
+        listener_count++;
+    }
+
+    tslog_infof(server.logger, "Modo reuseport: %d listeners%s", count, pin ? " fixados por CPU" : "");
+    return port;
+}
+
+void reuseport_join(void) {
+    for (int i = 0; i < listener_count; i++) {
+        pthread_join(listeners[i].thread, NULL);
+    }
+}
+
+unsigned long reuseport_accepted(int index) {
+    if (index < 0 || index >= listener_count) return 0;
+    return atomic_load_explicit(&listeners[index].accepted, memory_order_relaxed);
+}
+
+int reuseport_count(void) {
+    return listener_count;
+}
+
+void reuseport_destroy(void) {
+    if (!listeners) return;
+    // Contadores por listener: mostra se o kernel espalhou a carga
+    for (int i = 0; i < listener_count; i++) {
+        tslog_infof(server.logger, "[LISTENER %d] %lu conexoes aceitas",
+                    listeners[i].id, reuseport_accepted(i));
+        close(listeners[i].fd);
+    }
+    free(listeners);
+    listeners = NULL;
+    listener_count = 0;
+}
@@ -0,0 +1,189 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <ctype.h>
+
+// Tabela de rotas: registradas na partida, antes das threads, e só lidas
+// depois (sem lock). Rotas exatas e de prefixo ficam em duas tabelas hash de
+// endereçamento aberto; um pedido custa uma busca pelo caminho inteiro e, se
+// nenhuma rota exata casar, uma por prefixo terminado em '/', do mais longo
+// ao mais curto ("/a/b/c" tenta "/a/b/", "/a/" e "/").
+//
+// O tipo MIME de uma rota de arquivo fixo ou com sufixo sai no registro; o
+// dos demais arquivos vem de uma tabela hash de extensões.
+
+#define ROUTE_SLOTS 64      // potência de 2, mais que o dobro de ROUTE_MAX
+#define MIME_SLOTS 64       // potência de 2, mais que o dobro das extensões
+#define MIME_EXT_MAX 8      // extensão mais longa, sem o ponto
+
+static route_t routes[ROUTE_MAX];
+static int route_count;
+static const route_t *exact_slots[ROUTE_SLOTS];
+static const route_t *prefix_slots[ROUTE_SLOTS];
+
+static const struct {
+    const char *ext;
+    const char *mime;
+} mime_types[] = {
+    { "html", "text/html" },
+    { "htm", "text/html" },
+    { "css", "text/css" },
+    { "js", "application/javascript" },
+    { "mjs", "application/javascript" },
+    { "json", "application/json" },
+    { "map", "application/json" },
+    { "txt", "text/plain" },
+    { "xml", "application/xml" },
+    { "svg", "image/svg+xml" },
+    { "jpg", "image/jpeg" },
+    { "jpeg", "image/jpeg" },
+    { "png", "image/png" },
+    { "gif", "image/gif" },
+    { "webp", "image/webp" },
+    { "avif", "image/avif" },
+    { "ico", "image/x-icon" },
+    { "woff", "font/woff" },
+    { "woff2", "font/woff2" },
+    { "ttf", "font/ttf" },
+    { "pdf", "application/pdf" },
+    { "wasm", "application/wasm" },
+    { "mp4", "video/mp4" },
+    { "webm", "video/webm" },
+    { "mp3", "audio/mpeg" },
+};
+#define MIME_COUNT (int)(sizeof(mime_types) / sizeof(mime_types[0]))
+#define MIME_DEFAULT "application/octet-stream"
+
+static signed char mime_slots[MIME_SLOTS]; // índice em mime_types, -1 = vazio
+
+// FNV-1a; a extensão entra em minúsculas (".PNG" = ".png")
+static uint32_t hash_bytes(const char *s, size_t len, int fold) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = s[i];
+        h ^= fold ? (unsigned char)tolower(c) : c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void router_init(void) {
+    memset(mime_slots, -1, sizeof(mime_slots));
+    for (int i = 0; i < MIME_COUNT; i++) {
+        uint32_t h = hash_bytes(mime_types[i].ext, strlen(mime_types[i].ext), 1);
+        while (mime_slots[h & (MIME_SLOTS - 1)] >= 0) h++;
+        mime_slots[h & (MIME_SLOTS - 1)] = i;
+    }
+}
+
+static const char *mime_for_extension(const char *ext, size_t len) {
+    if (len == 0 || len > MIME_EXT_MAX) return MIME_DEFAULT;
+    for (uint32_t h = hash_bytes(ext, len, 1);; h++) {
+        int i = mime_slots[h & (MIME_SLOTS - 1)];
+        if (i < 0) return MIME_DEFAULT;
+        if (strncasecmp(mime_types[i].ext, ext, len) == 0 && mime_types[i].ext[len] == '\0') {
+            return mime_types[i].mime;
+        }
+    }
+}
+
+// Retorna o tipo de conteúdo (MIME type) com base na extensão do arquivo.
+const char *get_mime_type(const char *path) {
+    const char *dot = strrchr(path, '.');
+    if (!dot || dot == path || strchr(dot, '/')) return MIME_DEFAULT;
+    return mime_for_extension(dot + 1, strlen(dot + 1));
+}
+
+int route_add(const route_t *route) {
+    size_t len = strlen(route->path);
+    if (route_count == ROUTE_MAX || route->path[0] != '/' ||
+        (route->match == ROUTE_PREFIX && route->path[len - 1] != '/') ||
+        (route->suffix && route->suffix[0] != '.')) return -1;
+    const route_t **slots = route->match == ROUTE_PREFIX ? prefix_slots : exact_slots;
+    uint32_t h = hash_bytes(route->path, len, 0);
+    for (;; h++) {
+        const route_t *other = slots[h & (ROUTE_SLOTS - 1)];
+        if (!other) break;
+        if (other->len == len && memcmp(other->path, route->path, len) == 0) return -1; // repetida
+    }
+
+    route_t *r = &routes[route_count++];
+    *r = *route;
+    r->len = len;
+    if (r->file) r->mime_type = get_mime_type(r->file);
+    else if (r->suffix) r->mime_type = mime_for_extension(r->suffix + 1, strlen(r->suffix + 1));
+    else r->mime_type = NULL;
+    slots[h & (ROUTE_SLOTS - 1)] = r;
+    return 0;
+}
+
+static const route_t *lookup(const route_t *const *slots, const char *path, size_t len) {
+    for (uint32_t h = hash_bytes(path, len, 0);; h++) {
+        const route_t *r = slots[h & (ROUTE_SLOTS - 1)];
+        if (!r) return NULL;
+        if (r->len == len && memcmp(r->path, path, len) == 0) return r;
+    }
+}
+
+const route_t *route_find(http_slice_t path) {
+    const char *query = memchr(path.ptr, '?', path.len);
+    if (query) path.len = query - path.ptr;
+    const route_t *r = lookup(exact_slots, path.ptr, path.len);
+    if (r) return r;
+    for (size_t len = path.len; len > 0; len--) {
+        if (path.ptr[len - 1] != '/') continue;
+        if ((r = lookup(prefix_slots, path.ptr, len))) return r;
+    }
+    return NULL;
+}
+
+// Caminho (sem a query) que pode virar arquivo sob server.root: começa por
+// '/', sem '\\' e sem segmentos vazios, "." ou ".." (que sairiam da raiz ou
+// dariam nomes diferentes ao mesmo arquivo)
+int route_path_safe(http_slice_t path) {
+    const char *query = memchr(path.ptr, '?', path.len);
+    if (query) path.len = query - path.ptr;
+    if (path.len == 0 || path.ptr[0] != '/' || memchr(path.ptr, '\\', path.len)) return 0;
+    size_t start = 1; // início do segmento atual
+    for (size_t i = 1; i <= path.len; i++) {
+        if (i < path.len && path.ptr[i] != '/') continue;
+        size_t len = i - start;
+        // O último segmento pode ser vazio: "/docs/"
+        if ((len == 0 && i < path.len) ||
+            (len == 1 && path.ptr[start] == '.') ||
+            (len == 2 && path.ptr[start] == '.' && path.ptr[start + 1] == '.')) return 0;
+        start = i + 1;
+    }
+    return 1;
+}
+
+// Tentativa 0: o arquivo fixo da rota, o caminho com o sufixo (se o último
+// segmento não tem extensão) ou o próprio caminho. Tentativa 1: o caminho
+// literal, só quando a 0 acrescentou o sufixo.
+const char *route_target(const request_t *req, int attempt, char *buf, size_t size) {
+    const route_t *route = req->route;
+    http_slice_t path = req->http.path;
+    const char *query = memchr(path.ptr, '?', path.len);
+    if (query) path.len = query - path.ptr;
+    if (!route_path_safe(path)) return NULL; // nunca sai de server.root
+
+    if (route && route->file) {
+        if (attempt > 0 || (size_t)snprintf(buf, size, "%s", route->file) >= size) return NULL;
+        return route->mime_type;
+    }
+    int suffixed = 0;
+    if (route && route->suffix && path.len > 0 && path.ptr[path.len - 1] != '/') {
+        size_t last = path.len; // início do último segmento
+        while (last > 0 && path.ptr[last - 1] != '/') last--;
+        suffixed = !memchr(path.ptr + last, '.', path.len - last);
+    }
+    if (attempt > suffixed) return NULL;
+    if (suffixed && attempt == 0) {
+        if ((size_t)snprintf(buf, size, "%.*s%s", (int)path.len, path.ptr, route->suffix) >= size) return NULL;
+        return route->mime_type;
+    }
+    if ((size_t)snprintf(buf, size, "%.*s", (int)path.len, path.ptr) >= size) return NULL;
+    return get_mime_type(buf);
+}
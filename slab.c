@@ -0,0 +1,255 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Slabs de objetos de tamanho fixo para o caminho do pedido: cada thread
+// guarda um magazine (pilha) de objetos livres por slab e só pega o lock do
+// depósito para trocar lotes inteiros. O padrão do modo threads (o acceptor
+// aloca o pedido, um worker libera) vira lotes que saem do magazine do
+// worker para o depósito e dele para o acceptor, sem passar pelo malloc.
+// O depósito guarda um limite de lotes; o excedente volta ao malloc.
+//
+// A arena do pedido corta blocos de um slab próprio e devolve todos de uma
+// vez em arena_reset, no fim do pedido.
+
+#define SLAB_BATCH_BYTES (32 * 1024) // memória de um lote
+#define SLAB_BATCH_MAX 32
+#define SLAB_DEPOT_BYTES (4 * 1024 * 1024) // livres guardados no depósito, por slab
+#define SLAB_DEPOT_MIN 4             // lotes guardados mesmo para objetos grandes
+
+// Objeto livre. O primeiro de um lote no depósito também guarda o próximo lote
+typedef struct slab_obj {
+    struct slab_obj *next;
+    struct slab_obj *next_batch;
+    int count;
+} slab_obj_t;
+
+struct slab {
+    int id;
+    const char *name;
+    size_t size;
+    int batch;                  // objetos por lote
+    int depot_max;              // lotes guardados no depósito
+    pthread_mutex_t lock;
+    slab_obj_t *depot;          // lotes livres, encadeados por next_batch
+    int depot_count;
+    _Atomic unsigned long allocated; // objetos pedidos ao malloc
+    _Atomic unsigned long released;  // devolvidos ao malloc
+};
+
+typedef struct {
+    slab_obj_t *head;
+    int count;
+} magazine_t;
+
+struct arena_block {
+    struct arena_block *next;
+    int large;                  // alocação maior que um bloco: veio do malloc
+};
+
+#define ARENA_HEADER ((sizeof(arena_block_t) + 15) & ~(size_t)15)
+
+static slab_t slabs[SLAB_MAX];
+static _Atomic int slab_count; // só cresce, antes de qualquer uso do slab novo
+static slab_t *arena_slab;
+static pthread_key_t magazine_key;
+static __thread magazine_t magazines[SLAB_MAX];
+static __thread int registered;
+
+static void depot_put(slab_t *slab, slab_obj_t *head, int count);
+
+// Thread terminou: os magazines dela voltam ao depósito
+static void flush_magazines(void *ptr) {
+    magazine_t *mags = ptr;
+    for (int i = 0; i < slab_count; i++) {
+        if (mags[i].head) depot_put(&slabs[i], mags[i].head, mags[i].count);
+        mags[i].head = NULL;
+        mags[i].count = 0;
+    }
+}
+
+void slab_init(void) {
+    pthread_key_create(&magazine_key, flush_magazines);
+    arena_slab = slab_create("arena", ARENA_BLOCK);
+}
+
+slab_t *slab_create(const char *name, size_t size) {
+    if (slab_count >= SLAB_MAX) return NULL;
+    slab_t *slab = &slabs[slab_count];
+    size = (size + 15) & ~(size_t)15; // mantém o alinhamento do malloc
+    if (size < sizeof(slab_obj_t)) size = sizeof(slab_obj_t);
+    slab->id = slab_count;
+    slab->name = name;
+    slab->size = size;
+    slab->batch = SLAB_BATCH_BYTES / size;
+    if (slab->batch < 1) slab->batch = 1;
+    if (slab->batch > SLAB_BATCH_MAX) slab->batch = SLAB_BATCH_MAX;
+    slab->depot_max = SLAB_DEPOT_BYTES / (size * slab->batch);
+    if (slab->depot_max < SLAB_DEPOT_MIN) slab->depot_max = SLAB_DEPOT_MIN;
+    pthread_mutex_init(&slab->lock, NULL);
+    slab_count++;
+    return slab;
+}
+
+static void release_list(slab_t *slab, slab_obj_t *obj) {
+    while (obj) {
+        slab_obj_t *next = obj->next;
+        free(obj);
+        atomic_fetch_add_explicit(&slab->released, 1, memory_order_relaxed);
+        obj = next;
+    }
+}
+
+static void depot_put(slab_t *slab, slab_obj_t *head, int count) {
+    pthread_mutex_lock(&slab->lock);
+    if (slab->depot_count < slab->depot_max) {
+        head->next_batch = slab->depot;
+        head->count = count;
+        slab->depot = head;
+        slab->depot_count++;
+        head = NULL;
+    }
+    pthread_mutex_unlock(&slab->lock);
+    release_list(slab, head); // depósito cheio
+}
+
+// Magazine vazio: um lote do depósito ou, sem nenhum, um lote novo do malloc
+static int refill(slab_t *slab, magazine_t *mag) {
+    if (!registered) {
+        pthread_setspecific(magazine_key, magazines);
+        registered = 1;
+    }
+    pthread_mutex_lock(&slab->lock);
+    slab_obj_t *batch = slab->depot;
+    if (batch) {
+        slab->depot = batch->next_batch;
+        slab->depot_count--;
+    }
+    pthread_mutex_unlock(&slab->lock);
+    if (batch) {
+        mag->head = batch;
+        mag->count = batch->count;
+        return 0;
+    }
+
+    for (int i = 0; i < slab->batch; i++) {
+        slab_obj_t *obj = malloc(slab->size);
+        if (!obj) break;
+        obj->next = mag->head;
+        mag->head = obj;
+        mag->count++;
+    }
+    if (!mag->count) return -1;
+    atomic_fetch_add_explicit(&slab->allocated, mag->count, memory_order_relaxed);
+    return 0;
+}
+
+void *slab_alloc(slab_t *slab) {
+    magazine_t *mag = &magazines[slab->id];
+    if (!mag->head && refill(slab, mag) < 0) return NULL;
+    slab_obj_t *obj = mag->head;
+    mag->head = obj->next;
+    mag->count--;
+    stats_alloc(slab->id, 0);
+    return obj;
+}
+
+void slab_free(slab_t *slab, void *ptr) {
+    if (!ptr) return;
+    magazine_t *mag = &magazines[slab->id];
+    slab_obj_t *obj = ptr;
+    obj->next = mag->head;
+    mag->head = obj;
+    mag->count++;
+    stats_alloc(slab->id, 1);
+    if (mag->count < 2 * slab->batch) return;
+
+    // Magazine cheio: um lote vai para o depósito, o outro fica
+    slab_obj_t *head = mag->head, *last = head;
+    for (int i = 1; i < slab->batch; i++) last = last->next;
+    mag->head = last->next;
+    mag->count -= slab->batch;
+    last->next = NULL;
+    if (!registered) {
+        pthread_setspecific(magazine_key, magazines);
+        registered = 1;
+    }
+    depot_put(slab, head, slab->batch);
+}
+
+int slab_info(int id, slab_info_t *info) {
+    if (id < 0 || id >= slab_count) return -1;
+    slab_t *slab = &slabs[id];
+    info->name = slab->name;
+    info->size = slab->size;
+    info->allocated = atomic_load_explicit(&slab->allocated, memory_order_relaxed);
+    info->released = atomic_load_explicit(&slab->released, memory_order_relaxed);
+    return 0;
+}
+
+// Encerramento, com as outras threads já terminadas: devolve tudo ao malloc
+void slab_shutdown(void) {
+    flush_magazines(magazines);
+    for (int i = 0; i < slab_count; i++) {
+        slab_t *slab = &slabs[i];
+        pthread_mutex_lock(&slab->lock);
+        while (slab->depot) {
+            slab_obj_t *batch = slab->depot;
+            slab->depot = batch->next_batch;
+            release_list(slab, batch);
+        }
+        slab->depot_count = 0;
+        pthread_mutex_unlock(&slab->lock);
+    }
+}
+
+// ======================== ARENA DO PEDIDO ========================
+
+void *arena_alloc(arena_t *arena, size_t size) {
+    size = (size + 15) & ~(size_t)15;
+    if (!arena->head || arena->used + size > ARENA_BLOCK) {
+        arena_block_t *block;
+        if (ARENA_HEADER + size > ARENA_BLOCK) {
+            block = malloc(ARENA_HEADER + size);
+            if (!block) return NULL;
+            block->large = 1;
+            // Fora do bloco atual: ele continua recebendo as próximas
+            if (arena->head) {
+                block->next = arena->head->next;
+                arena->head->next = block;
+            } else {
+                block->next = NULL;
+                arena->head = block;
+                arena->used = ARENA_BLOCK;
+            }
+            void *ptr = (char *)block + ARENA_HEADER;
+            memset(ptr, 0, size);
+            return ptr;
+        }
+        block = slab_alloc(arena_slab);
+        if (!block) return NULL;
+        block->large = 0;
+        block->next = arena->head;
+        arena->head = block;
+        arena->used = ARENA_HEADER;
+    }
+    void *ptr = (char *)arena->head + arena->used;
+    arena->used += size;
+    memset(ptr, 0, size);
+    return ptr;
+}
+
+void arena_reset(arena_t *arena) {
+    arena_block_t *block = arena->head;
+    while (block) {
+        arena_block_t *next = block->next;
+        if (block->large) free(block);
+        else slab_free(arena_slab, block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->used = 0;
+}
@@ -0,0 +1,389 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+
+// Métricas do servidor sem lock global: cada thread conta no seu próprio
+// shard (alinhado à linha de cache) e /stats soma todos na leitura.
+// Histogramas de latência em baldes logarítmicos: o balde i conta as
+// durações em [2^i, 2^(i+1)) ns.
+
+#define MAX_SHARDS 128
+#define STAT_BUCKETS 40         // até 2^40 ns (~18 min)
+
+static const int status_codes[STAT_STATUS_COUNT] = {
+    200, 206, 304, 400, 404, 405, 413, 416, 429, 431, 500, 503, 0
+};
+
+static const char *hist_names[STAT_HIST_COUNT] = {
+    [STAT_QUEUE_WAIT] = "queue_wait",
+    [STAT_PARSE] = "parse",
+    [STAT_FILE_READ] = "file_read",
+    [STAT_SEND] = "send",
+};
+
+typedef struct {
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum_ns;
+    _Atomic uint64_t buckets[STAT_BUCKETS];
+} histogram_t;
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint64_t requests;
+    _Atomic uint64_t bytes_sent;
+    _Atomic uint64_t responses[STAT_STATUS_COUNT];
+    _Atomic uint64_t timeouts[DEADLINE_COUNT];
+    _Atomic uint64_t shed[SHED_COUNT];
+    _Atomic uint64_t allocs[SLAB_MAX];
+    _Atomic uint64_t frees[SLAB_MAX];
+    histogram_t hist[STAT_HIST_COUNT];
+    int next_free;              // pilha de shards devolvidos (-1 = fim)
+} stats_shard_t;
+
+// O shard 0 é o compartilhado, para quando as threads passam de MAX_SHARDS;
+// como tudo é atômico a contagem continua certa, só volta a disputa
+static stats_shard_t shards[MAX_SHARDS];
+static pthread_mutex_t shard_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int shards_used = 1;     // maior índice já entregue + 1
+static int free_head = -1;      // shards de threads que já saíram
+static pthread_key_t shard_key;
+static __thread stats_shard_t *my_shard;
+static time_t start_time;
+
+// Thread terminou: o shard (com as contagens) fica para a próxima thread
+static void release_shard(void *ptr) {
+    stats_shard_t *shard = ptr;
+    if (shard == &shards[0]) return;
+    pthread_mutex_lock(&shard_mutex);
+    shard->next_free = free_head;
+    free_head = (int)(shard - shards);
+    pthread_mutex_unlock(&shard_mutex);
+}
+
+void stats_init(void) {
+    start_time = time(NULL);
+    pthread_key_create(&shard_key, release_shard);
+}
+
+static stats_shard_t *get_shard(void) {
+    if (my_shard) return my_shard;
+
+    pthread_mutex_lock(&shard_mutex);
+    if (free_head >= 0) {
+        my_shard = &shards[free_head];
+        free_head = my_shard->next_free;
+    } else if (shards_used < MAX_SHARDS) {
+        my_shard = &shards[shards_used++];
+    } else {
+        my_shard = &shards[0];
+    }
+    pthread_mutex_unlock(&shard_mutex);
+    pthread_setspecific(shard_key, my_shard);
+    return my_shard;
+}
+
+long long stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void stats_request(void) {
+    atomic_fetch_add_explicit(&get_shard()->requests, 1, memory_order_relaxed);
+}
+
+void stats_response(const char *status, size_t bytes) {
+    stats_shard_t *shard = get_shard();
+    int code = status ? atoi(status) : 0;
+    int i = 0;
+    while (i < STAT_STATUS_COUNT - 1 && status_codes[i] != code) i++;
+    atomic_fetch_add_explicit(&shard->responses[i], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&shard->bytes_sent, bytes, memory_order_relaxed);
+}
+
+void stats_timeout(deadline_kind_t kind) {
+    atomic_fetch_add_explicit(&get_shard()->timeouts[kind], 1, memory_order_relaxed);
+}
+
+void stats_shed(shed_reason_t reason) {
+    atomic_fetch_add_explicit(&get_shard()->shed[reason], 1, memory_order_relaxed);
+}
+
+void stats_alloc(int slab, int freed) {
+    stats_shard_t *shard = get_shard();
+    atomic_fetch_add_explicit(freed ? &shard->frees[slab] : &shard->allocs[slab], 1, memory_order_relaxed);
+}
+
+void stats_time(stat_hist_t which, long long ns) {
+    if (ns < 0) ns = 0;
+    histogram_t *h = &get_shard()->hist[which];
+    int bucket = ns > 0 ? 63 - __builtin_clzll((unsigned long long)ns) : 0;
+    if (bucket >= STAT_BUCKETS) bucket = STAT_BUCKETS - 1;
+    atomic_fetch_add_explicit(&h->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->sum_ns, (uint64_t)ns, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->buckets[bucket], 1, memory_order_relaxed);
+}
+
+// ======================== LEITURA ========================
+
+typedef struct {
+    uint64_t requests;
+    uint64_t bytes_sent;
+    uint64_t responses[STAT_STATUS_COUNT];
+    uint64_t timeouts[DEADLINE_COUNT];
+    uint64_t shed[SHED_COUNT];
+    uint64_t allocs[SLAB_MAX];
+    uint64_t frees[SLAB_MAX];
+    struct {
+        uint64_t count, sum_ns;
+        uint64_t buckets[STAT_BUCKETS];
+    } hist[STAT_HIST_COUNT];
+} stats_snapshot_t;
+
+static uint64_t load(_Atomic uint64_t *v) {
+    return atomic_load_explicit(v, memory_order_relaxed);
+}
+
+static void snapshot(stats_snapshot_t *s) {
+    memset(s, 0, sizeof(*s));
+    pthread_mutex_lock(&shard_mutex);
+    int used = shards_used;
+    pthread_mutex_unlock(&shard_mutex);
+
+    for (int i = 0; i < used; i++) {
+        stats_shard_t *shard = &shards[i];
+        s->requests += load(&shard->requests);
+        s->bytes_sent += load(&shard->bytes_sent);
+        for (int c = 0; c < STAT_STATUS_COUNT; c++) s->responses[c] += load(&shard->responses[c]);
+        for (int k = 0; k < DEADLINE_COUNT; k++) s->timeouts[k] += load(&shard->timeouts[k]);
+        for (int k = 0; k < SHED_COUNT; k++) s->shed[k] += load(&shard->shed[k]);
+        for (int a = 0; a < SLAB_MAX; a++) {
+            s->allocs[a] += load(&shard->allocs[a]);
+            s->frees[a] += load(&shard->frees[a]);
+        }
+        for (int h = 0; h < STAT_HIST_COUNT; h++) {
+            s->hist[h].count += load(&shard->hist[h].count);
+            s->hist[h].sum_ns += load(&shard->hist[h].sum_ns);
+            for (int b = 0; b < STAT_BUCKETS; b++) {
+                s->hist[h].buckets[b] += load(&shard->hist[h].buckets[b]);
+            }
+        }
+    }
+}
+
+unsigned long stats_total_requests(void) {
+    stats_snapshot_t s;
+    snapshot(&s);
+    return (unsigned long)s.requests;
+}
+
+// Limite superior (ns) do balde onde cai o quantil q
+static uint64_t percentile_ns(const uint64_t *buckets, uint64_t count, double q) {
+    if (count == 0) return 0;
+    uint64_t rank = (uint64_t)(q * count + 0.5), seen = 0;
+    if (rank == 0) rank = 1;
+    for (int b = 0; b < STAT_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) return 2ULL << b;
+    }
+    return 2ULL << (STAT_BUCKETS - 1);
+}
+
+// Texto crescendo num buffer alocado (vira res->owned)
+typedef struct {
+    char *data;
+    size_t len, cap;
+    int failed;
+} text_t;
+
+static void append(text_t *t, const char *fmt, ...) {
+    if (t->failed) return;
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(t->data + t->len, t->cap - t->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            t->failed = 1;
+            return;
+        }
+        if ((size_t)n < t->cap - t->len) {
+            t->len += n;
+            return;
+        }
+        size_t cap = t->cap * 2 + n;
+        char *grown = realloc(t->data, cap);
+        if (!grown) {
+            t->failed = 1;
+            return;
+        }
+        t->data = grown;
+        t->cap = cap;
+    }
+}
+
+static void render_json(text_t *t, const stats_snapshot_t *s) {
+    unsigned long hits, misses, entries;
+    size_t cache_bytes;
+    file_cache_stats(&hits, &misses, &cache_bytes, &entries);
+
+    append(t, "{\n  \"uptime_seconds\": %ld,\n", (long)(time(NULL) - start_time));
+    append(t, "  \"requests\": %llu,\n", (unsigned long long)s->requests);
+    append(t, "  \"bytes_sent\": %llu,\n", (unsigned long long)s->bytes_sent);
+    append(t, "  \"responses\": {");
+    int first = 1;
+    for (int c = 0; c < STAT_STATUS_COUNT; c++) {
+        if (!s->responses[c]) continue;
+        if (status_codes[c]) append(t, "%s\"%d\": %llu", first ? "" : ", ", status_codes[c],
+                                    (unsigned long long)s->responses[c]);
+        else append(t, "%s\"other\": %llu", first ? "" : ", ", (unsigned long long)s->responses[c]);
+        first = 0;
+    }
+    append(t, "},\n  \"timeouts\": {");
+    for (int k = 0; k < DEADLINE_COUNT; k++) {
+        append(t, "%s\"%s\": %llu", k ? ", " : "", deadline_name(k), (unsigned long long)s->timeouts[k]);
+    }
+    append(t, "},\n  \"shed\": {");
+    for (int k = 0; k < SHED_COUNT; k++) {
+        append(t, "%s\"%s\": %llu", k ? ", " : "", shed_name(k), (unsigned long long)s->shed[k]);
+    }
+    append(t, "},\n  \"latency_us\": {\n");
+    for (int h = 0; h < STAT_HIST_COUNT; h++) {
+        uint64_t count = s->hist[h].count;
+        const uint64_t *b = s->hist[h].buckets;
+        append(t, "    \"%s\": {\"count\": %llu, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, "
+                  "\"p99\": %.1f, \"p999\": %.1f, \"buckets\": {",
+               hist_names[h], (unsigned long long)count,
+               count ? s->hist[h].sum_ns / 1000.0 / count : 0.0,
+               percentile_ns(b, count, 0.50) / 1000.0, percentile_ns(b, count, 0.90) / 1000.0,
+               percentile_ns(b, count, 0.99) / 1000.0, percentile_ns(b, count, 0.999) / 1000.0);
+        // Só os baldes ocupados; a chave é o limite superior em µs
+        first = 1;
+        for (int i = 0; i < STAT_BUCKETS; i++) {
+            if (!b[i]) continue;
+            append(t, "%s\"%g\": %llu", first ? "" : ", ", (2ULL << i) / 1000.0,
+                   (unsigned long long)b[i]);
+            first = 0;
+        }
+        append(t, "}}%s\n", h + 1 < STAT_HIST_COUNT ? "," : "");
+    }
+    append(t, "  },\n");
+    append(t, "  \"cache\": {\"hits\": %lu, \"misses\": %lu, \"entries\": %lu, \"bytes\": %zu},\n",
+           hits, misses, entries, cache_bytes);
+    // Por slab: em uso = allocs - frees; livres guardados = malloc - devolvidos - em uso
+    append(t, "  \"alloc\": {");
+    slab_info_t info;
+    for (int a = 0; slab_info(a, &info) == 0; a++) {
+        append(t, "%s\n    \"%s\": {\"size\": %zu, \"allocs\": %llu, \"frees\": %llu, \"in_use\": %lld, "
+                  "\"malloc\": %lu, \"released\": %lu}",
+               a ? "," : "", info.name, info.size, (unsigned long long)s->allocs[a],
+               (unsigned long long)s->frees[a], (long long)(s->allocs[a] - s->frees[a]),
+               info.allocated, info.released);
+    }
+    append(t, "\n  },\n");
+    append(t, "  \"pool\": {\"workers\": %d, \"queued\": %d, \"overloaded\": %d}\n}\n",
+           worker_pool_size(), work_queue_count(server.work_queue), admission_overloaded());
+}
+
+static void render_prometheus(text_t *t, const stats_snapshot_t *s) {
+    append(t, "# HELP webserver_requests_total Requisicoes interpretadas.\n"
+              "# TYPE webserver_requests_total counter\n"
+              "webserver_requests_total %llu\n", (unsigned long long)s->requests);
+    append(t, "# HELP webserver_sent_bytes_total Bytes enviados (cabecalho + corpo).\n"
+              "# TYPE webserver_sent_bytes_total counter\n"
+              "webserver_sent_bytes_total %llu\n", (unsigned long long)s->bytes_sent);
+    append(t, "# HELP webserver_responses_total Respostas por codigo HTTP.\n"
+              "# TYPE webserver_responses_total counter\n");
+    for (int c = 0; c < STAT_STATUS_COUNT; c++) {
+        if (status_codes[c]) {
+            append(t, "webserver_responses_total{code=\"%d\"} %llu\n", status_codes[c],
+                   (unsigned long long)s->responses[c]);
+        } else {
+            append(t, "webserver_responses_total{code=\"other\"} %llu\n",
+                   (unsigned long long)s->responses[c]);
+        }
+    }
+    append(t, "# HELP webserver_timeouts_total Conexoes fechadas por prazo vencido.\n"
+              "# TYPE webserver_timeouts_total counter\n");
+    for (int k = 0; k < DEADLINE_COUNT; k++) {
+        append(t, "webserver_timeouts_total{kind=\"%s\"} %llu\n", deadline_name(k),
+               (unsigned long long)s->timeouts[k]);
+    }
+    append(t, "# HELP webserver_shed_total Pedidos recusados pelo controle de admissao.\n"
+              "# TYPE webserver_shed_total counter\n");
+    for (int k = 0; k < SHED_COUNT; k++) {
+        append(t, "webserver_shed_total{reason=\"%s\"} %llu\n", shed_name(k),
+               (unsigned long long)s->shed[k]);
+    }
+    append(t, "# HELP webserver_overloaded Espera na fila acima do alvo (descartando pedidos atrasados).\n"
+              "# TYPE webserver_overloaded gauge\n"
+              "webserver_overloaded %d\n", admission_overloaded());
+    slab_info_t info;
+    append(t, "# HELP webserver_slab_allocs_total Objetos entregues por slab.\n"
+              "# TYPE webserver_slab_allocs_total counter\n");
+    for (int a = 0; slab_info(a, &info) == 0; a++) {
+        append(t, "webserver_slab_allocs_total{slab=\"%s\"} %llu\n", info.name, (unsigned long long)s->allocs[a]);
+    }
+    append(t, "# HELP webserver_slab_frees_total Objetos devolvidos por slab.\n"
+              "# TYPE webserver_slab_frees_total counter\n");
+    for (int a = 0; slab_info(a, &info) == 0; a++) {
+        append(t, "webserver_slab_frees_total{slab=\"%s\"} %llu\n", info.name, (unsigned long long)s->frees[a]);
+    }
+    append(t, "# HELP webserver_slab_malloc_total Objetos pedidos ao malloc por slab.\n"
+              "# TYPE webserver_slab_malloc_total counter\n");
+    for (int a = 0; slab_info(a, &info) == 0; a++) {
+        append(t, "webserver_slab_malloc_total{slab=\"%s\"} %lu\n", info.name, info.allocated);
+    }
+    for (int h = 0; h < STAT_HIST_COUNT; h++) {
+        const char *name = hist_names[h];
+        append(t, "# HELP webserver_%s_seconds Latencia de %s.\n"
+                  "# TYPE webserver_%s_seconds histogram\n", name, name, name);
+        uint64_t cumulative = 0;
+        for (int i = 0; i < STAT_BUCKETS; i++) {
+            cumulative += s->hist[h].buckets[i];
+            append(t, "webserver_%s_seconds_bucket{le=\"%g\"} %llu\n",
+                   name, (2ULL << i) / 1e9, (unsigned long long)cumulative);
+        }
+        append(t, "webserver_%s_seconds_bucket{le=\"+Inf\"} %llu\n"
+                  "webserver_%s_seconds_sum %.9f\n"
+                  "webserver_%s_seconds_count %llu\n",
+               name, (unsigned long long)s->hist[h].count,
+               name, s->hist[h].sum_ns / 1e9,
+               name, (unsigned long long)s->hist[h].count);
+    }
+}
+
+// Handler de /stats (JSON) e /metrics (Prometheus): monta o texto em res
+void stats_serve(request_t *req, response_t *res, int prometheus) {
+    stats_snapshot_t snap;
+    snapshot(&snap);
+    text_t text = { malloc(4096), 0, 4096, 0 };
+    if (!text.data) text.failed = 1;
+    if (prometheus) render_prometheus(&text, &snap);
+    else render_json(&text, &snap);
+    if (text.failed) {
+        free(text.data);
+        set_error_response(res, HTTP_500);
+        return;
+    }
+
+    res->status = "200 OK";
+    res->mime_type = prometheus ? "text/plain; version=0.0.4" : "application/json";
+    res->body = text.data;
+    res->body_len = text.len;
+    res->owned = text.data;
+    res->header = NULL;
+    res->cached = NULL;
+    res->bundle = NULL;
+    res->file_fd = -1;
+    res->file_offset = 0;
+    res->multipart = NULL;
+    res->encoding = NULL;
+    res->vary = 0;
+    res->extra[0] = '\0';
+    tslog_infof(server.logger, "[RES #%d] 200 OK - %s", req->id, prometheus ? "/metrics" : "/stats");
+}
@@ -0,0 +1,237 @@
+#!/bin/bash
+
+# Teste automatizado de faixas (Range) e pedidos condicionais (304).
+# Sobe o web_server numa porta livre com uma raiz temporária e confere
+# status, cabeçalhos e os bytes do corpo com curl, em cada modo de MODES.
+#
+# Uso: ./test_http.sh            (modos threads e epoll)
+#      MODES="threads epoll reuseport uring" ./test_http.sh
+
+SERVER="./web_server"
+MODES=${MODES:-"threads epoll"}
+SMALL_SIZE=36           # abaixo de --sendfile-threshold: cache em memória
+BIG_SIZE=300000         # acima: sendfile
+
+if ! command -v curl &> /dev/null; then
+    echo "ERRO: curl nao encontrado."
+    echo "Instale com: sudo apt-get install curl"
+    exit 1
+fi
+if [ ! -x "$SERVER" ]; then
+    echo "ERRO: $SERVER nao encontrado (rode make)"
+    exit 1
+fi
+
+TMP=$(mktemp -d)
+SERVER_PID=""
+trap 'stop_server; rm -rf "$TMP"' EXIT
+
+# Raiz: um arquivo pequeno e um grande, ambos sem compressão
+mkdir "$TMP/www"
+printf '0123456789abcdefghijklmnopqrstuvwxyz' > "$TMP/www/small.txt"
+seq 1 100000 | head -c $BIG_SIZE > "$TMP/www/big.bin"
+
+PASSED=0
+FAILED=0
+
+ok() {
+    PASSED=$((PASSED + 1))
+    echo "  ok   $1"
+}
+
+fail() {
+    FAILED=$((FAILED + 1))
+    echo "  FALHOU $1: $2"
+}
+
+start_server() {
+    "$SERVER" --port 0 --mode "$1" --root "$TMP/www" --log-file "$TMP/server.log" \
+              --sendfile-threshold 64K > "$TMP/server.out" 2>&1 &
+    SERVER_PID=$!
+    PORT=""
+    for _ in $(seq 1 50); do
+        PORT=$(grep -o 'localhost:[0-9]*' "$TMP/server.out" 2>/dev/null | cut -d: -f2)
+        [ -n "$PORT" ] && return 0
+        sleep 0.1
+    done
+    echo "ERRO: servidor nao subiu no modo $1"
+    cat "$TMP/server.out"
+    return 1
+}
+
+stop_server() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null
+        wait "$SERVER_PID" 2>/dev/null
+        SERVER_PID=""
+    fi
+}
+
+# fetch CAMINHO [argumentos do curl]: status em $STATUS, cabeçalhos e corpo em arquivos
+fetch() {
+    local path=$1
+    shift
+    rm -f "$TMP/body" # sem corpo o curl nem cria o arquivo
+    STATUS=$(curl -s -D "$TMP/headers" -o "$TMP/body" -w '%{http_code}' "$@" \
+             "http://127.0.0.1:$PORT$path")
+}
+
+# header NOME: valor do cabeçalho da última resposta (sem o \r)
+header() {
+    grep -i "^$1:" "$TMP/headers" | head -1 | cut -d' ' -f2- | tr -d '\r'
+}
+
+# Bytes [INICIO, FIM] de um arquivo da raiz
+slice() {
+    tail -c +$(($2 + 1)) "$TMP/www/$1" | head -c $(($3 - $2 + 1))
+}
+
+# expect NOME STATUS [CABECALHO VALOR]...: confere a última resposta
+expect() {
+    local name=$1 status=$2
+    shift 2
+    if [ "$STATUS" != "$status" ]; then
+        fail "$name" "status $STATUS, esperado $status"
+        return 1
+    fi
+    while [ $# -ge 2 ]; do
+        local got
+        got=$(header "$1")
+        if [ "$got" != "$2" ]; then
+            fail "$name" "$1 '$got', esperado '$2'"
+            return 1
+        fi
+        shift 2
+    done
+    return 0
+}
+
+# expect_body NOME ARQUIVO_ESPERADO: corpo idêntico byte a byte
+expect_body() {
+    touch "$TMP/body"
+    if cmp -s "$TMP/body" "$2"; then
+        ok "$1"
+    else
+        fail "$1" "corpo difere ($(wc -c < "$TMP/body") bytes, esperado $(wc -c < "$2"))"
+    fi
+}
+
+# Uma faixa: 206, Content-Range e os bytes certos
+check_range() {
+    local file=$1 range=$2 first=$3 last=$4 size=$5
+    fetch "/$file" -H "Range: bytes=$range"
+    expect "$file bytes=$range" 206 \
+           Content-Range "bytes $first-$last/$size" \
+           Content-Length $((last - first + 1)) || return
+    slice "$file" "$first" "$last" > "$TMP/expected"
+    expect_body "$file bytes=$range" "$TMP/expected"
+}
+
+# Várias faixas: multipart/byteranges com cada parte no formato esperado
+check_multipart() {
+    local file=$1 type=$2 size=$3
+    shift 3
+    local ranges="" spec
+    for spec in "$@"; do ranges="$ranges${ranges:+,}$spec"; done
+    fetch "/$file" -H "Range: bytes=$ranges"
+    expect "$file bytes=$ranges" 206 || return
+    local boundary
+    boundary=$(header Content-Type | sed -n 's/^multipart\/byteranges; boundary=//p')
+    if [ -z "$boundary" ]; then
+        fail "$file bytes=$ranges" "Content-Type '$(header Content-Type)'"
+        return
+    fi
+    : > "$TMP/expected"
+    for spec in "$@"; do
+        local first=${spec%-*} last=${spec#*-}
+        printf '\r\n--%s\r\nContent-Type: %s\r\nContent-Range: bytes %s-%s/%s\r\n\r\n' \
+               "$boundary" "$type" "$first" "$last" "$size" >> "$TMP/expected"
+        slice "$file" "$first" "$last" >> "$TMP/expected"
+    done
+    printf '\r\n--%s--\r\n' "$boundary" >> "$TMP/expected"
+    expect_body "$file bytes=$ranges (multipart)" "$TMP/expected"
+}
+
+run_checks() {
+    # Inteiro (a primeira ida ao disco) e de novo (do cache)
+    fetch /small.txt
+    expect "small.txt" 200 Content-Length $SMALL_SIZE Accept-Ranges bytes && \
+        expect_body "small.txt" "$TMP/www/small.txt"
+    fetch /small.txt
+    expect "small.txt (cache)" 200 && expect_body "small.txt (cache)" "$TMP/www/small.txt"
+    local etag last_modified
+    etag=$(header ETag)
+    last_modified=$(header Last-Modified)
+
+    # Faixas: fechada, sufixo, aberta e fim além do tamanho
+    for file in small.txt big.bin; do
+        local size=$SMALL_SIZE
+        [ "$file" = big.bin ] && size=$BIG_SIZE
+        check_range $file 0-9 0 9 $size
+        check_range $file 5-5 5 5 $size
+        check_range $file -7 $((size - 7)) $((size - 1)) $size
+        check_range $file $((size - 4))- $((size - 4)) $((size - 1)) $size
+        check_range $file 10-99999999 10 $((size - 1)) $size
+        fetch "/$file" -H "Range: bytes=$size-"
+        expect "$file bytes=$size- (416)" 416 Content-Range "bytes */$size" && ok "$file bytes=$size- (416)"
+        # Faixa que não é de bytes é ignorada: o arquivo inteiro
+        fetch "/$file" -H "Range: items=0-1"
+        expect "$file items=0-1" 200 && expect_body "$file items=0-1" "$TMP/www/$file"
+    done
+    check_multipart small.txt text/plain $SMALL_SIZE 0-1 5-6 30-35
+    check_multipart big.bin application/octet-stream $BIG_SIZE 0-99 150000-150099 299990-299999
+
+    # Condicionais: If-None-Match decide e If-Modified-Since é ignorado
+    fetch /small.txt -H "If-None-Match: $etag"
+    expect "If-None-Match igual" 304 ETag "$etag" && ok "If-None-Match igual"
+    if [ -s "$TMP/body" ]; then fail "304 sem corpo" "$(wc -c < "$TMP/body") bytes"; else ok "304 sem corpo"; fi
+    fetch /small.txt -H 'If-None-Match: "outra"' -H "If-Modified-Since: $last_modified"
+    expect "If-None-Match diferente + If-Modified-Since igual" 200 && \
+        expect_body "If-None-Match diferente + If-Modified-Since igual" "$TMP/www/small.txt"
+    fetch /small.txt -H "If-None-Match: $etag" -H "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT"
+    expect "If-None-Match igual + If-Modified-Since antigo" 304 && ok "If-None-Match igual + If-Modified-Since antigo"
+    fetch /small.txt -H "If-Modified-Since: $last_modified"
+    expect "If-Modified-Since igual" 304 && ok "If-Modified-Since igual"
+    fetch /small.txt -H "If-Modified-Since: Thu, 01 Jan 1970 00:00:00 GMT"
+    expect "If-Modified-Since antigo" 200 && expect_body "If-Modified-Since antigo" "$TMP/www/small.txt"
+
+    # 304 vence a faixa
+    fetch /small.txt -H "If-None-Match: $etag" -H "Range: bytes=0-9"
+    expect "If-None-Match igual + Range" 304 && ok "If-None-Match igual + Range"
+
+    # If-Range: ETag ou data atuais mantêm a faixa; velhos dão o arquivo inteiro
+    fetch /small.txt -H "If-Range: $etag" -H "Range: bytes=0-9"
+    expect "If-Range ETag atual" 206 Content-Range "bytes 0-9/$SMALL_SIZE" && ok "If-Range ETag atual"
+    fetch /small.txt -H 'If-Range: "velha"' -H "Range: bytes=0-9"
+    expect "If-Range ETag velha" 200 && expect_body "If-Range ETag velha" "$TMP/www/small.txt"
+    fetch /small.txt -H "If-Range: W/$etag" -H "Range: bytes=0-9"
+    expect "If-Range ETag fraca" 200 && expect_body "If-Range ETag fraca" "$TMP/www/small.txt"
+    fetch /small.txt -H "If-Range: $last_modified" -H "Range: bytes=0-9"
+    expect "If-Range data atual" 206 Content-Range "bytes 0-9/$SMALL_SIZE" && ok "If-Range data atual"
+    fetch /small.txt -H "If-Range: Thu, 01 Jan 1970 00:00:00 GMT" -H "Range: bytes=0-9"
+    expect "If-Range data velha" 200 && expect_body "If-Range data velha" "$TMP/www/small.txt"
+
+    # O mesmo no arquivo grande (sendfile)
+    fetch /big.bin
+    expect "big.bin" 200 Content-Length $BIG_SIZE && expect_body "big.bin" "$TMP/www/big.bin"
+    local big_etag
+    big_etag=$(header ETag)
+    fetch /big.bin -H "If-None-Match: $big_etag" -H "Range: bytes=0-9"
+    expect "big.bin If-None-Match igual + Range" 304 && ok "big.bin If-None-Match igual + Range"
+    fetch /big.bin -H "If-Range: $big_etag" -H "Range: bytes=100-199"
+    expect "big.bin If-Range ETag atual" 206 Content-Range "bytes 100-199/$BIG_SIZE" && \
+        { slice big.bin 100 199 > "$TMP/expected"; expect_body "big.bin If-Range ETag atual" "$TMP/expected"; }
+    fetch /big.bin -H 'If-Range: "velha"' -H "Range: bytes=100-199"
+    expect "big.bin If-Range ETag velha" 200 && expect_body "big.bin If-Range ETag velha" "$TMP/www/big.bin"
+}
+
+for mode in $MODES; do
+    echo "=== Modo $mode ==="
+    start_server "$mode" || exit 1
+    run_checks
+    stop_server
+done
+
+echo ""
+echo "$PASSED ok, $FAILED falhas"
+[ "$FAILED" -eq 0 ]
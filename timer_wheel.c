@@ -0,0 +1,179 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/socket.h>
+
+// Roda de temporizadores hashed: o slot de um prazo é (expira / tick) mod
+// slots. Prazos mais longos que uma volta ficam no mesmo slot e só vencem
+// quando a hora chega, então o tamanho da roda não limita a duração.
+// Armar e cancelar mexem só numa lista duplamente encadeada.
+
+#define WATCHDOG_SLOTS 512
+#define WATCHDOG_TICK_MS 100
+
+static const char *deadline_names[DEADLINE_COUNT] = {
+    [DEADLINE_HEADER] = "header",
+    [DEADLINE_IDLE] = "idle",
+    [DEADLINE_WRITE] = "write",
+};
+
+long long timer_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000;
+}
+
+const char *deadline_name(deadline_kind_t kind) {
+    return deadline_names[kind];
+}
+
+long deadline_ms(deadline_kind_t kind) {
+    switch (kind) {
+    case DEADLINE_HEADER: return server.header_timeout * 1000L;
+    case DEADLINE_IDLE: return server.keepalive_timeout * 1000L;
+    case DEADLINE_WRITE: return server.write_timeout * 1000L;
+    default: return 0;
+    }
+}
+
+int timer_wheel_init(timer_wheel_t *wheel, int slots, int tick_ms) {
+    unsigned count = 1;
+    while (count < (unsigned)slots) count <<= 1;
+    wheel->slots = malloc(count * sizeof(timer_node_t));
+    if (!wheel->slots) return -1;
+    for (unsigned i = 0; i < count; i++) {
+        wheel->slots[i].prev = wheel->slots[i].next = &wheel->slots[i];
+    }
+    wheel->mask = count - 1;
+    wheel->tick_ms = tick_ms;
+    wheel->tick = timer_now_ms() / tick_ms;
+    return 0;
+}
+
+void timer_wheel_destroy(timer_wheel_t *wheel) {
+    free(wheel->slots);
+    wheel->slots = NULL;
+}
+
+int timer_armed(const timer_node_t *timer) {
+    return timer->prev != NULL;
+}
+
+void timer_wheel_cancel(timer_node_t *timer) {
+    if (!timer->prev) return;
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->prev = timer->next = NULL;
+}
+
+void timer_wheel_arm(timer_wheel_t *wheel, timer_node_t *timer, long long expires_ms) {
+    timer_wheel_cancel(timer);
+    // Arredonda para cima: quando a roda chega ao slot o prazo já passou
+    long long tick = (expires_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (tick <= wheel->tick) tick = wheel->tick + 1; // já passou: vence na próxima volta
+    timer_node_t *head = &wheel->slots[tick & wheel->mask];
+    timer->expires_ms = expires_ms;
+    timer->prev = head->prev;
+    timer->next = head;
+    head->prev->next = timer;
+    head->prev = timer;
+}
+
+timer_node_t *timer_wheel_expire(timer_wheel_t *wheel, long long now_ms) {
+    timer_node_t *expired = NULL, **tail = &expired;
+    long long target = now_ms / wheel->tick_ms;
+    long long steps = target - wheel->tick;
+    // Parado por mais de uma volta: basta olhar cada slot uma vez
+    if (steps > (long long)wheel->mask + 1) steps = wheel->mask + 1;
+
+    for (long long i = 1; i <= steps; i++) {
+        timer_node_t *head = &wheel->slots[(wheel->tick + i) & wheel->mask];
+        timer_node_t *t = head->next;
+        while (t != head) {
+            timer_node_t *next = t->next;
+            if (t->expires_ms <= now_ms) {
+                timer_wheel_cancel(t);
+                *tail = t;
+                tail = &t->next;
+            }
+            t = next;
+        }
+    }
+    *tail = NULL;
+    if (target > wheel->tick) wheel->tick = target;
+    return expired;
+}
+
+// ======================== SOCKETS BLOQUEANTES ========================
+
+static struct {
+    timer_wheel_t wheel;
+    pthread_mutex_t lock;
+    pthread_t thread;
+    int started;
+} watchdog = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void* watchdog_thread(void *arg) {
+    while (g_running) {
+        usleep(WATCHDOG_TICK_MS * 1000);
+        pthread_mutex_lock(&watchdog.lock);
+        timer_node_t *t = timer_wheel_expire(&watchdog.wheel, timer_now_ms());
+        while (t) {
+            timer_node_t *next = t->next;
+            socket_deadline_t *d = (socket_deadline_t *)t;
+            // Sob o lock: o dono cancela antes de fechar, o fd ainda é dele.
+            // Escrita parada: linger 0 faz o close do dono mandar RST
+            if (d->kind == DEADLINE_WRITE) {
+                struct linger reset = { 1, 0 };
+                setsockopt(d->fd, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+            }
+            shutdown(d->fd, SHUT_RDWR);
+            stats_timeout(d->kind);
+            tslog_debugf(server.logger, "[TIMEOUT] socket %d: prazo %s vencido", d->fd, deadline_name(d->kind));
+            t = next;
+        }
+        pthread_mutex_unlock(&watchdog.lock);
+    }
+    return NULL;
+}
+
+int socket_deadlines_start(void) {
+    if (timer_wheel_init(&watchdog.wheel, WATCHDOG_SLOTS, WATCHDOG_TICK_MS) < 0) return -1;
+    if (pthread_create(&watchdog.thread, NULL, watchdog_thread, NULL) != 0) {
+        timer_wheel_destroy(&watchdog.wheel);
+        return -1;
+    }
+    watchdog.started = 1;
+    return 0;
+}
+
+void socket_deadlines_stop(void) {
+    if (!watchdog.started) return;
+    pthread_join(watchdog.thread, NULL);
+    timer_wheel_destroy(&watchdog.wheel);
+    watchdog.started = 0;
+}
+
+void socket_deadline_arm(socket_deadline_t *deadline, deadline_kind_t kind) {
+    long ms = deadline_ms(kind);
+    if (!watchdog.started) {
+        deadline->kind = kind;
+        return;
+    }
+    pthread_mutex_lock(&watchdog.lock);
+    deadline->kind = kind; // lido pelo vigia ao vencer
+    if (ms > 0) timer_wheel_arm(&watchdog.wheel, &deadline->node, timer_now_ms() + ms);
+    else timer_wheel_cancel(&deadline->node);
+    pthread_mutex_unlock(&watchdog.lock);
+}
+
+void socket_deadline_cancel(socket_deadline_t *deadline) {
+    if (!watchdog.started) return;
+    pthread_mutex_lock(&watchdog.lock);
+    timer_wheel_cancel(&deadline->node);
+    pthread_mutex_unlock(&watchdog.lock);
+}
@@ -0,0 +1,58 @@
+#ifndef TSLOG_BINARY_H
+#define TSLOG_BINARY_H
+
+#include <stdint.h>
+
+// Formato binário do libtslog (usado pelo logger e pelo tslog_decode).
+//
+// O arquivo é uma sequência de registros; o primeiro byte indica o tipo.
+// Inteiros em ordem de bytes nativa (o decodificador roda na mesma arquitetura).
+//
+//   SEGMENT 'S': magic "TSLB", u16 versão, u64 realtime_ns, u64 mono_ns
+//                (aberto a cada tslog_init; zera a tabela de formatos)
+//   FORMAT  'F': u32 id, u16 tamanho, bytes da string de formato
+//   LOG     'L': u64 mono_ns, u32 tid, u8 nível, u32 id do formato,
+//                u16 tamanho, argumentos brutos
+//
+// Argumentos brutos, na ordem do formato (incluindo '*' de largura/precisão):
+// inteiros e ponteiros em 8 bytes, reais como double, strings como u16 + bytes.
+
+#define TSLOG_BIN_MAGIC "TSLB"
+#define TSLOG_BIN_VERSION 1
+
+#define TSLOG_REC_SEGMENT 'S'
+#define TSLOG_REC_FORMAT  'F'
+#define TSLOG_REC_LOG     'L'
+
+#define TSLOG_MAX_ARGS 32
+
+// Tipo de cada argumento de um formato printf
+enum {
+    TSLOG_ARG_NONE = 0,     // "%%"
+    TSLOG_ARG_INT,          // int (e menores, promovidos)
+    TSLOG_ARG_LONG,         // long, long long, size_t, intmax_t, ptrdiff_t
+    TSLOG_ARG_DOUBLE,
+    TSLOG_ARG_LDOUBLE,      // gravado como double
+    TSLOG_ARG_STR,
+    TSLOG_ARG_PTR
+};
+
+// Um especificador de conversão dentro da string de formato
+typedef struct {
+    const char *start;      // aponta para o '%'
+    const char *end;        // primeiro caractere depois da conversão
+    const char *len_start;  // modificador de tamanho (hh, l, z, ...)
+    const char *len_end;
+    int stars;              // '*' em largura/precisão, cada um consome um int
+    int prec_star;          // precisão veio de '*' (ex. "%.*s": o int limita a string)
+    int type;               // TSLOG_ARG_*
+} tslog_spec_t;
+
+// Avança *cursor até o próximo especificador.
+// Retorna 1 se achou, 0 no fim da string, -1 se não suportado (%n, %1$d, %ls...)
+int tslog_next_spec(const char **cursor, tslog_spec_t *spec);
+
+// Preenche types com a sequência de argumentos do formato; -1 se não suportado
+int tslog_scan_format(const char *fmt, unsigned char *types, int max_args);
+
+#endif // TSLOG_BINARY_H
@@ -0,0 +1,302 @@
+#include "libtslog.h"
+#include "tslog_binary.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define OUT_SIZE 8192
+#define CONV_SIZE 1024
+
+// Tabela de formatos do segmento atual (id -> string)
+typedef struct {
+    char **text;
+    size_t cap;
+} format_table_t;
+
+typedef struct {
+    char data[OUT_SIZE];
+    size_t len;
+} out_buf_t;
+
+static const char* const level_names[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+static void out_append(out_buf_t *out, const char *s, size_t n) {
+    if (n > OUT_SIZE - 1 - out->len) n = OUT_SIZE - 1 - out->len;
+    memcpy(out->data + out->len, s, n);
+    out->len += n;
+    out->data[out->len] = '\0';
+}
+
+static void formats_reset(format_table_t *t) {
+    for (size_t i = 0; i < t->cap; i++) {
+        free(t->text[i]);
+        t->text[i] = NULL;
+    }
+}
+
+static int formats_set(format_table_t *t, uint32_t id, char *text) {
+    if (id >= t->cap) {
+        size_t cap = t->cap ? t->cap : 1024;
+        while (cap <= id) cap *= 2;
+        char **grown = realloc(t->text, cap * sizeof(char*));
+        if (!grown) return -1;
+        memset(grown + t->cap, 0, (cap - t->cap) * sizeof(char*));
+        t->text = grown;
+        t->cap = cap;
+    }
+    free(t->text[id]);
+    t->text[id] = text;
+    return 0;
+}
+
+// Leitura sequencial dos argumentos brutos de um registro
+typedef struct {
+    const char *data;
+    size_t len;
+    size_t off;
+} arg_reader_t;
+
+static int64_t read_i64(arg_reader_t *r) {
+    int64_t v = 0;
+    if (r->off + 8 <= r->len) memcpy(&v, r->data + r->off, 8);
+    r->off += 8;
+    return v;
+}
+
+static double read_double(arg_reader_t *r) {
+    double v = 0;
+    if (r->off + 8 <= r->len) memcpy(&v, r->data + r->off, 8);
+    r->off += 8;
+    return v;
+}
+
+static void read_string(arg_reader_t *r, char *dst, size_t cap) {
+    uint16_t n = 0;
+    if (r->off + 2 <= r->len) memcpy(&n, r->data + r->off, 2);
+    r->off += 2;
+    if (r->off > r->len) n = 0;
+    else if (n > r->len - r->off) n = (uint16_t)(r->len - r->off);
+    if (n > cap - 1) n = (uint16_t)(cap - 1);
+    if (n) memcpy(dst, r->data + r->off, n);
+    dst[n] = '\0';
+    r->off += n;
+}
+
+// Reaplica o formato printf aos argumentos gravados
+static void render_message(const char *fmt, arg_reader_t *args, out_buf_t *out) {
+    const char *cursor = fmt, *literal = fmt;
+    tslog_spec_t spec;
+    int r;
+
+    while ((r = tslog_next_spec(&cursor, &spec)) > 0) {
+        out_append(out, literal, spec.start - literal);
+        literal = spec.end;
+
+        if (spec.type == TSLOG_ARG_NONE) {
+            out_append(out, "%", 1);
+            continue;
+        }
+
+        int stars[2] = { 0, 0 };
+        for (int i = 0; i < spec.stars; i++) stars[i] = (int)read_i64(args);
+
+        // Normaliza o modificador de tamanho para o tipo realmente gravado
+        char conv[64];
+        size_t head = spec.len_start - spec.start;
+        if (head > sizeof(conv) - 8) head = sizeof(conv) - 8;
+        memcpy(conv, spec.start, head);
+        size_t n = head;
+        if (spec.type == TSLOG_ARG_INT) {
+            memcpy(conv + n, spec.len_start, spec.len_end - spec.len_start);
+            n += spec.len_end - spec.len_start;
+        } else if (spec.type == TSLOG_ARG_LONG) {
+            conv[n++] = 'l';
+            conv[n++] = 'l';
+        }
+        conv[n++] = spec.end[-1];
+        conv[n] = '\0';
+
+        char text[CONV_SIZE];
+        char str[TSLOG_MSG_MAX];
+        int ns = spec.stars;
+#define CONVERT(value) \
+        (ns == 0 ? snprintf(text, sizeof(text), conv, value) : \
+         ns == 1 ? snprintf(text, sizeof(text), conv, stars[0], value) : \
+                   snprintf(text, sizeof(text), conv, stars[0], stars[1], value))
+        int written;
+        switch (spec.type) {
+        case TSLOG_ARG_INT:
+            written = CONVERT((int)read_i64(args));
+            break;
+        case TSLOG_ARG_LONG:
+            written = CONVERT((long long)read_i64(args));
+            break;
+        case TSLOG_ARG_PTR:
+            written = CONVERT((void*)(uintptr_t)read_i64(args));
+            break;
+        case TSLOG_ARG_DOUBLE:
+        case TSLOG_ARG_LDOUBLE:
+            written = CONVERT(read_double(args));
+            break;
+        case TSLOG_ARG_STR:
+            read_string(args, str, sizeof(str));
+            written = CONVERT(str);
+            break;
+        default:
+            written = 0;
+            break;
+        }
+#undef CONVERT
+        if (written < 0) written = 0;
+        if (written > (int)sizeof(text) - 1) written = sizeof(text) - 1;
+        out_append(out, text, written);
+    }
+
+    // Formato não suportado: o resto sai literal
+    out_append(out, literal, strlen(literal));
+}
+
+static void print_json_string(const char *s) {
+    putchar('"');
+    for (; *s; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') printf("\\%c", c);
+        else if (c == '\n') fputs("\\n", stdout);
+        else if (c == '\r') fputs("\\r", stdout);
+        else if (c == '\t') fputs("\\t", stdout);
+        else if (c < 0x20) printf("\\u%04x", c);
+        else putchar(c);
+    }
+    putchar('"');
+}
+
+static int read_exact(FILE *in, void *buf, size_t n) {
+    return fread(buf, 1, n, in) == n ? 0 : -1;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [--json] [arquivo]\n", prog);
+    fprintf(stderr, "Converte um log binario do libtslog em texto (ou JSON por linha).\n");
+}
+
+int main(int argc, char *argv[]) {
+    int json = 0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(argv[0]);
+            return 0;
+        } else {
+            path = argv[i];
+        }
+    }
+
+    FILE *in = path ? fopen(path, "rb") : stdin;
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    format_table_t formats = { NULL, 0 };
+    uint64_t anchor_real = 0, anchor_mono = 0;
+    int have_segment = 0, status = 0;
+    int type;
+
+    while ((type = fgetc(in)) != EOF) {
+        if (type == TSLOG_REC_SEGMENT) {
+            char magic[4];
+            uint16_t version;
+            if (read_exact(in, magic, 4) || read_exact(in, &version, 2) ||
+                read_exact(in, &anchor_real, 8) || read_exact(in, &anchor_mono, 8)) {
+                goto truncated;
+            }
+            if (memcmp(magic, TSLOG_BIN_MAGIC, 4) != 0 || version != TSLOG_BIN_VERSION) {
+                fprintf(stderr, "Cabecalho invalido ou versao nao suportada\n");
+                status = 1;
+                break;
+            }
+            formats_reset(&formats);
+            have_segment = 1;
+        } else if (type == TSLOG_REC_FORMAT) {
+            uint32_t id;
+            uint16_t len;
+            if (read_exact(in, &id, 4) || read_exact(in, &len, 2)) goto truncated;
+            char *text = malloc(len + 1);
+            if (!text || read_exact(in, text, len)) {
+                free(text);
+                goto truncated;
+            }
+            text[len] = '\0';
+            if (formats_set(&formats, id, text) != 0) {
+                free(text);
+                status = 1;
+                break;
+            }
+        } else if (type == TSLOG_REC_LOG) {
+            uint64_t mono_ns;
+            uint32_t tid, id;
+            uint8_t level;
+            uint16_t len;
+            char payload[65536];
+            if (read_exact(in, &mono_ns, 8) || read_exact(in, &tid, 4) ||
+                read_exact(in, &level, 1) || read_exact(in, &id, 4) ||
+                read_exact(in, &len, 2) || read_exact(in, payload, len)) {
+                goto truncated;
+            }
+            if (!have_segment) {
+                fprintf(stderr, "Registro antes do cabecalho de segmento\n");
+                status = 1;
+                break;
+            }
+
+            out_buf_t msg = { .len = 0 };
+            msg.data[0] = '\0';
+            arg_reader_t args = { payload, len, 0 };
+            const char *fmt = id < formats.cap ? formats.text[id] : NULL;
+            if (fmt) render_message(fmt, &args, &msg);
+            else out_append(&msg, "<formato desconhecido>", 22);
+
+            // Tempo absoluto = âncora de relógio real + delta monotônico
+            int64_t delta = (int64_t)(mono_ns - anchor_mono);
+            uint64_t real_ns = anchor_real + delta;
+            time_t sec = (time_t)(real_ns / 1000000000ULL);
+            unsigned long nsec = (unsigned long)(real_ns % 1000000000ULL);
+            const char *lvl = level <= LOG_ERROR ? level_names[level] : "?";
+            struct tm tm_info;
+            char date[32];
+
+            if (json) {
+                gmtime_r(&sec, &tm_info);
+                strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &tm_info);
+                printf("{\"ts\":\"%s.%09luZ\",\"mono_ns\":%llu,\"tid\":%u,\"level\":\"%s\",\"msg\":",
+                       date, nsec, (unsigned long long)mono_ns, tid, lvl);
+                print_json_string(msg.data);
+                fputs("}\n", stdout);
+            } else {
+                localtime_r(&sec, &tm_info);
+                strftime(date, sizeof(date), "%Y-%m-%d %H:%M:%S", &tm_info);
+                printf("[%s.%09lu] %s (tid %u): %s\n", date, nsec, lvl, tid, msg.data);
+            }
+        } else {
+            fprintf(stderr, "Tipo de registro desconhecido: 0x%02x\n", type);
+            status = 1;
+            break;
+        }
+        continue;
+
+truncated:
+        fprintf(stderr, "Arquivo truncado\n");
+        status = 1;
+        break;
+    }
+
+    formats_reset(&formats);
+    free(formats.text);
+    if (in != stdin) fclose(in);
+    return status;
+}
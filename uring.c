@@ -0,0 +1,312 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+// io_uring sem liburing: os anéis de submissão e conclusão são mapeados do
+// kernel e o resto são três syscalls. As SQEs de uma volta do loop se
+// acumulam e vão num único io_uring_enter, que também espera as conclusões.
+// Os recv tiram o buffer de um anel de buffers fornecidos (um por ring):
+// conexão parada não prende buffer, ele só é escolhido quando chegam dados.
+
+#define URING_BUFFER_GROUP 1
+
+struct uring {
+    int fd;
+    unsigned features;
+    // Submissão
+    unsigned *sq_head, *sq_tail, sq_mask, sq_entries;
+    unsigned sq_local;          // tail com as SQEs ainda não publicadas
+    struct io_uring_sqe *sqes;
+    // Conclusão
+    unsigned *cq_head, *cq_tail, cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_map, *cq_map;
+    size_t sq_map_len, cq_map_len, sqes_len;
+    // Anel de buffers fornecidos para os recv
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_len;
+    unsigned buf_count, buf_size;
+    char *buf_base;
+    unsigned short buf_tail;
+};
+
+static int sys_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_enter(int fd, unsigned submit, unsigned wait, unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, submit, wait, flags, arg, argsz);
+}
+
+static int sys_register(int fd, unsigned op, void *arg, unsigned count) {
+    return (int)syscall(__NR_io_uring_register, fd, op, arg, count);
+}
+
+// Operações usadas pelo loop; kernels antigos não têm todas
+static int probe_ops(uring_t *ring) {
+    static const unsigned char needed[] = {
+        IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_SENDMSG, IORING_OP_READ,
+    };
+    size_t len = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, len);
+    if (!probe) return -1;
+    int ok = sys_register(ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0;
+    for (size_t i = 0; ok && i < sizeof(needed); i++) {
+        ok = needed[i] <= probe->last_op && (probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED);
+    }
+    free(probe);
+    if (!ok) errno = ENOSYS;
+    return ok ? 0 : -1;
+}
+
+static void buffer_add(uring_t *ring, unsigned id) {
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[ring->buf_tail & (ring->buf_count - 1)];
+    buf->addr = (uintptr_t)(ring->buf_base + (size_t)id * ring->buf_size);
+    buf->len = ring->buf_size;
+    buf->bid = id;
+    ring->buf_tail++;
+}
+
+static int buffers_init(uring_t *ring, unsigned count, unsigned size) {
+    unsigned entries = 1;
+    while (entries < count) entries <<= 1;
+    ring->buf_count = entries;
+    ring->buf_size = size;
+    ring->buf_ring_len = entries * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_len, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buf_ring == MAP_FAILED) {
+        ring->buf_ring = NULL;
+        return -1;
+    }
+    ring->buf_base = malloc((size_t)entries * size);
+    if (!ring->buf_base) return -1;
+
+    // Anel de buffers (5.19): mesma versão que trouxe o accept multishot
+    struct io_uring_buf_reg reg = {
+        .ring_addr = (uintptr_t)ring->buf_ring,
+        .ring_entries = entries,
+        .bgid = URING_BUFFER_GROUP,
+    };
+    if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return -1;
+    for (unsigned i = 0; i < entries; i++) buffer_add(ring, i);
+    __atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+    return 0;
+}
+
+uring_t *uring_create(unsigned entries, unsigned buffers, unsigned buffer_size) {
+    uring_t *ring = calloc(1, sizeof(uring_t));
+    if (!ring) return NULL;
+    ring->fd = -1;
+
+    // Conclusões com folga: accept e recv de muitas conexões chegam juntos
+    struct io_uring_params p = { .flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN,
+                                 .cq_entries = entries * 4 };
+    ring->fd = sys_setup(entries, &p);
+    if (ring->fd < 0 && errno == EINVAL) {
+        // COOP_TASKRUN é 5.19; o resto do que se exige vem junto do anel de buffers
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = entries * 4;
+        ring->fd = sys_setup(entries, &p);
+    }
+    if (ring->fd < 0) goto fail;
+    ring->features = p.features;
+    // Sem EXT_ARG não há espera com timeout; sem NODROP conclusões se perdem
+    if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP)) {
+        errno = ENOSYS;
+        goto fail;
+    }
+
+    ring->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ring->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_map_len > ring->sq_map_len) ring->sq_map_len = ring->cq_map_len;
+        ring->cq_map_len = ring->sq_map_len;
+    }
+    ring->sq_map = mmap(NULL, ring->sq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_map == MAP_FAILED) {
+        ring->sq_map = NULL;
+        goto fail;
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_map = ring->sq_map;
+    } else {
+        ring->cq_map = mmap(NULL, ring->cq_map_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_map == MAP_FAILED) {
+            ring->cq_map = NULL;
+            goto fail;
+        }
+    }
+    ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) {
+        ring->sqes = NULL;
+        goto fail;
+    }
+
+    char *sq = ring->sq_map, *cq = ring->cq_map;
+    ring->sq_head = (unsigned *)(sq + p.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    ring->sq_mask = *(unsigned *)(sq + p.sq_off.ring_mask);
+    ring->sq_entries = p.sq_entries;
+    ring->sq_local = *ring->sq_tail;
+    // SQE i sempre na posição i do anel: o array de índices é fixo
+    unsigned *array = (unsigned *)(sq + p.sq_off.array);
+    for (unsigned i = 0; i < p.sq_entries; i++) array[i] = i;
+    ring->cq_head = (unsigned *)(cq + p.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    ring->cq_mask = *(unsigned *)(cq + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+
+    if (probe_ops(ring) < 0) goto fail;
+    if (buffers_init(ring, buffers, buffer_size) < 0) goto fail;
+    return ring;
+
+fail:;
+    int saved = errno;
+    uring_destroy(ring);
+    errno = saved;
+    return NULL;
+}
+
+void uring_destroy(uring_t *ring) {
+    if (!ring) return;
+    if (ring->sqes) munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_map && ring->cq_map != ring->sq_map) munmap(ring->cq_map, ring->cq_map_len);
+    if (ring->sq_map) munmap(ring->sq_map, ring->sq_map_len);
+    // Fechar o ring cancela o que ainda estava em voo
+    if (ring->fd >= 0) close(ring->fd);
+    if (ring->buf_ring) munmap(ring->buf_ring, ring->buf_ring_len);
+    free(ring->buf_base);
+    free(ring);
+}
+
+int uring_supported(void) {
+    uring_t *ring = uring_create(8, 1, 64);
+    if (!ring) return 0;
+    uring_destroy(ring);
+    return 1;
+}
+
+// Publica as SQEs acumuladas e entra no kernel (wait_ms < 0 = só submete)
+static int uring_enter(uring_t *ring, int wait_ms) {
+    __atomic_store_n(ring->sq_tail, ring->sq_local, __ATOMIC_RELEASE);
+    unsigned pending = ring->sq_local - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    if (wait_ms < 0) {
+        if (pending == 0) return 0;
+        return sys_enter(ring->fd, pending, 0, 0, NULL, 0);
+    }
+    struct __kernel_timespec ts = { .tv_sec = wait_ms / 1000, .tv_nsec = (wait_ms % 1000) * 1000000L };
+    struct io_uring_getevents_arg arg = { .ts = (uintptr_t)&ts };
+    return sys_enter(ring->fd, pending, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+int uring_reserve(uring_t *ring, unsigned count) {
+    for (;;) {
+        unsigned used = ring->sq_local - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        if (ring->sq_entries - used >= count) return 0;
+        // Anel cheio: adianta a submissão do lote
+        if (uring_enter(ring, -1) < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) return -1;
+    }
+}
+
+static struct io_uring_sqe *next_sqe(uring_t *ring, uint8_t opcode, int fd, unsigned long long data) {
+    if (uring_reserve(ring, 1) < 0) return NULL;
+    struct io_uring_sqe *sqe = &ring->sqes[ring->sq_local & ring->sq_mask];
+    ring->sq_local++;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = data;
+    return sqe;
+}
+
+int uring_accept_multishot(uring_t *ring, int fd, unsigned long long data) {
+    struct io_uring_sqe *sqe = next_sqe(ring, IORING_OP_ACCEPT, fd, data);
+    if (!sqe) return -1;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    return 0;
+}
+
+int uring_recv(uring_t *ring, int fd, size_t len, unsigned long long data) {
+    struct io_uring_sqe *sqe = next_sqe(ring, IORING_OP_RECV, fd, data);
+    if (!sqe) return -1;
+    sqe->len = len < ring->buf_size ? len : ring->buf_size;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUFFER_GROUP;
+    return 0;
+}
+
+int uring_read(uring_t *ring, int fd, void *buf, size_t len, off_t offset, unsigned long long data) {
+    struct io_uring_sqe *sqe = next_sqe(ring, IORING_OP_READ, fd, data);
+    if (!sqe) return -1;
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = offset;
+    return 0;
+}
+
+int uring_sendmsg(uring_t *ring, int fd, const struct msghdr *msg, int flags, unsigned long long data) {
+    struct io_uring_sqe *sqe = next_sqe(ring, IORING_OP_SENDMSG, fd, data);
+    if (!sqe) return -1;
+    sqe->addr = (uintptr_t)msg;
+    sqe->len = 1;
+    sqe->msg_flags = flags | MSG_NOSIGNAL;
+    return 0;
+}
+
+int uring_read_send(uring_t *ring, int file_fd, off_t offset, int sock, void *buf, size_t len,
+                    int flags, unsigned long long read_data, unsigned long long send_data) {
+    // As duas no mesmo lote: um link não atravessa duas submissões
+    if (uring_reserve(ring, 2) < 0) return -1;
+    uring_read(ring, file_fd, buf, len, offset, read_data);
+    struct io_uring_sqe *first = &ring->sqes[(ring->sq_local - 1) & ring->sq_mask];
+    first->flags = IOSQE_IO_LINK; // leitura curta ou com erro cancela o envio
+    struct io_uring_sqe *sqe = next_sqe(ring, IORING_OP_SEND, sock, send_data);
+    sqe->addr = (uintptr_t)buf;
+    sqe->len = len;
+    sqe->msg_flags = flags | MSG_NOSIGNAL;
+    return 0;
+}
+
+int uring_wait(uring_t *ring, int timeout_ms) {
+    // Já há conclusões: só submete o lote
+    int ready = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE) != *ring->cq_head;
+    int r = uring_enter(ring, ready ? -1 : timeout_ms);
+    if (r < 0 && (errno == ETIME || errno == EINTR || errno == EAGAIN || errno == EBUSY)) return 0;
+    return r < 0 ? -1 : 0;
+}
+
+int uring_next(uring_t *ring, uring_cqe_t *out) {
+    unsigned head = *ring->cq_head;
+    if (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) return 0;
+    const struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+    out->data = cqe->user_data;
+    out->res = cqe->res;
+    out->more = (cqe->flags & IORING_CQE_F_MORE) != 0;
+    out->buffer = (cqe->flags & IORING_CQE_F_BUFFER) ? (int)(cqe->flags >> IORING_CQE_BUFFER_SHIFT) : -1;
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+const char *uring_buffer(uring_t *ring, int id) {
+    return ring->buf_base + (size_t)id * ring->buf_size;
+}
+
+void uring_buffer_recycle(uring_t *ring, int id) {
+    buffer_add(ring, id);
+    __atomic_store_n(&ring->buf_ring->tail, ring->buf_tail, __ATOMIC_RELEASE);
+}
@@ -1,99 +1,241 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <arpa/inet.h>
-#include <sys/socket.h>
-#include <errno.h>
-
-#define BUFFER_SIZE 2048
-#define DEFAULT_PORT 8080
-
-int make_request(const char *host, int port, const char *path) {
-    int sock;
-    struct sockaddr_in server_addr;
-    char request[512];
-    char response[BUFFER_SIZE];
-    int bytes;
-    
-    // Cria socket
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        fprintf(stderr, "ERRO: Falha ao criar socket: %s\n", strerror(errno));
-        return -1;
-    }
-    
-    // Configura endereço
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(port);
-    
-    if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
-        fprintf(stderr, "ERRO: Endereco invalido: %s\n", host);
-        close(sock);
-        return -1;
-    }
-    
-    // Conecta
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        fprintf(stderr, "ERRO: Falha ao conectar em %s:%d - %s\n", 
-                host, port, strerror(errno));
-        close(sock);
-        return -1;
-    }
-    
-    printf("Conectado a %s:%d\n", host, port);
-    
-    // Monta requisição HTTP GET
-    snprintf(request, sizeof(request),
-             "GET %s HTTP/1.1\r\n"
-             "Host: %s:%d\r\n"
-             "Connection: close\r\n"
-             "\r\n",
-             path, host, port);
-    
-    // Envia requisição
-    if (send(sock, request, strlen(request), 0) < 0) {
-        fprintf(stderr, "ERRO: Falha ao enviar requisicao\n");
-        close(sock);
-        return -1;
-    }
-    
-    printf("\n>>> Requisicao enviada:\nGET %s\n\n", path);
-    
-    // Recebe resposta
-    printf("<<< Resposta:\n");
-    printf("----------------------------------------\n");
-    while ((bytes = recv(sock, response, BUFFER_SIZE - 1, 0)) > 0) {
-        response[bytes] = '\0';
-        printf("%s", response);
-    }
-    printf("----------------------------------------\n\n");
-    
-    close(sock);
-    return 0;
-}
-
-int main(int argc, char *argv[]) {
-    char *host = "127.0.0.1";
-    int port = DEFAULT_PORT;
-    char *path = "/";
-    
-    printf("=== CLIENTE WEB HTTP ===\n\n");
-    
-    // Parse argumentos
-    if (argc >= 2) path = argv[1];
-    if (argc >= 3) host = argv[2];
-    if (argc >= 4) port = atoi(argv[3]);
-    
-    printf("Host: %s\n", host);
-    printf("Porta: %d\n", port);
-    printf("Path: %s\n", path);
-    printf("========================\n\n");
-    
-    if (make_request(host, port, path) < 0) {
-        return 1;
-    }
-    
-    return 0;
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <getopt.h>
+#include "load_gen.h"
+
+#define BUFFER_SIZE 2048
+#define DEFAULT_PORT 8080
+
+int make_request(const char *host, int port, const char *path) {
+    int sock;
+    struct sockaddr_in server_addr;
+    char request[512];
+    char response[BUFFER_SIZE];
+    int bytes;
+    
+    // Cria socket
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+        fprintf(stderr, "ERRO: Falha ao criar socket: %s\n", strerror(errno));
+        return -1;
+    }
+    
+    // Configura endereço
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    
+    if (inet_pton(AF_INET, host, &server_addr.sin_addr) <= 0) {
+        fprintf(stderr, "ERRO: Endereco invalido: %s\n", host);
+        close(sock);
+        return -1;
+    }
+    
+    // Conecta
+    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+        fprintf(stderr, "ERRO: Falha ao conectar em %s:%d - %s\n", 
+                host, port, strerror(errno));
+        close(sock);
+        return -1;
+    }
+    
+    printf("Conectado a %s:%d\n", host, port);
+    
+    // Monta requisição HTTP GET
+    snprintf(request, sizeof(request),
+             "GET %s HTTP/1.1\r\n"
+             "Host: %s:%d\r\n"
+             "Connection: close\r\n"
+             "\r\n",
+             path, host, port);
+    
+    // Envia requisição
+    if (send(sock, request, strlen(request), 0) < 0) {
+        fprintf(stderr, "ERRO: Falha ao enviar requisicao\n");
+        close(sock);
+        return -1;
+    }
+    
+    printf("\n>>> Requisicao enviada:\nGET %s\n\n", path);
+    
+    // Recebe resposta
+    printf("<<< Resposta:\n");
+    printf("----------------------------------------\n");
+    while ((bytes = recv(sock, response, BUFFER_SIZE - 1, 0)) > 0) {
+        response[bytes] = '\0';
+        printf("%s", response);
+    }
+    printf("----------------------------------------\n\n");
+    
+    close(sock);
+    return 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [path] [host] [porta]\n"
+            "     %s --bench [opcoes]\n\n"
+            "Modo benchmark:\n"
+            "  -b, --bench              gera carga em vez de um pedido unico\n"
+            "  -t, --threads N          threads geradoras (padrao 2)\n"
+            "  -c, --connections N      conexoes no total (padrao 16)\n"
+            "  -d, --duration SEG       duracao do teste (padrao 10)\n"
+            "  -n, --requests N         para apos N requisicoes\n"
+            "  -r, --rate RPS           laco aberto: RPS fixo, latencia desde o horario marcado\n"
+            "      --close              uma conexao por requisicao (sem keep-alive)\n"
+            "  -u, --url PATH[:PESO]    URL a pedir (repetivel, com peso)\n"
+            "      --urls ARQ           lista de URLs, uma por linha: \"path peso\"\n"
+            "  -H, --host IP            servidor (padrao 127.0.0.1)\n"
+            "  -p, --port N             porta (padrao %d)\n"
+            "      --timeout MS         timeout por requisicao (padrao 5000)\n"
+            "  -o, --output ARQ         grava o relatorio JSON no arquivo (padrao: stdout)\n",
+            prog, prog, DEFAULT_PORT);
+}
+
+static int run_bench(int argc, char *argv[]) {
+    lg_config_t cfg;
+    lg_config_default(&cfg);
+    cfg.port = DEFAULT_PORT;
+    const char *output = NULL;
+
+    static const struct option long_opts[] = {
+        {"bench", no_argument, NULL, 'b'},
+        {"threads", required_argument, NULL, 't'},
+        {"connections", required_argument, NULL, 'c'},
+        {"duration", required_argument, NULL, 'd'},
+        {"requests", required_argument, NULL, 'n'},
+        {"rate", required_argument, NULL, 'r'},
+        {"close", no_argument, NULL, 'K'},
+        {"url", required_argument, NULL, 'u'},
+        {"urls", required_argument, NULL, 'U'},
+        {"host", required_argument, NULL, 'H'},
+        {"port", required_argument, NULL, 'p'},
+        {"timeout", required_argument, NULL, 'T'},
+        {"output", required_argument, NULL, 'o'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt_c, duration_set = 0;
+    while ((opt_c = getopt_long(argc, argv, "bt:c:d:n:r:u:H:p:o:h", long_opts, NULL)) != -1) {
+        switch (opt_c) {
+        case 'b':
+            break;
+        case 't':
+            cfg.threads = atoi(optarg);
+            break;
+        case 'c':
+            cfg.connections = atoi(optarg);
+            break;
+        case 'd':
+            cfg.duration_s = atof(optarg);
+            duration_set = 1;
+            break;
+        case 'n':
+            cfg.requests = atol(optarg);
+            break;
+        case 'r':
+            cfg.rate = atof(optarg);
+            break;
+        case 'K':
+            cfg.keep_alive = 0;
+            break;
+        case 'u':
+            if (lg_add_url(&cfg, optarg) < 0) {
+                fprintf(stderr, "URL invalida: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'U':
+            if (lg_load_urls(&cfg, optarg) < 0) {
+                fprintf(stderr, "ERRO: Falha ao ler lista de URLs: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'H':
+            cfg.host = optarg;
+            break;
+        case 'p':
+            cfg.port = atoi(optarg);
+            break;
+        case 'T':
+            cfg.timeout_ms = atoi(optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            print_usage(argv[0]);
+            return opt_c == 'h' ? 0 : 1;
+        }
+    }
+    // Só -n: roda até completar as requisições
+    if (cfg.requests > 0 && !duration_set) cfg.duration_s = 0;
+    if (cfg.url_count == 0) lg_add_url(&cfg, "/");
+    if (cfg.threads < 1 || cfg.connections < 1 || cfg.timeout_ms < 1 ||
+        (cfg.duration_s <= 0 && cfg.requests <= 0)) {
+        fprintf(stderr, "Parametros de benchmark invalidos\n");
+        return 1;
+    }
+    if (cfg.connections < cfg.threads) cfg.threads = cfg.connections;
+
+    fprintf(stderr, "Benchmark %s:%d: %d threads, %d conexoes%s, %s\n",
+            cfg.host, cfg.port, cfg.threads, cfg.connections,
+            cfg.keep_alive ? " keep-alive" : " (uma por requisicao)",
+            cfg.rate > 0 ? "laco aberto" : "laco fechado");
+
+    static lg_result_t result; // histograma grande: fora da pilha
+    if (lg_run(&cfg, &result) < 0) {
+        fprintf(stderr, "ERRO: Falha ao iniciar o benchmark em %s:%d\n", cfg.host, cfg.port);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (output && !(out = fopen(output, "w"))) {
+        fprintf(stderr, "ERRO: Falha ao criar %s: %s\n", output, strerror(errno));
+        return 1;
+    }
+    lg_print_json(out, &cfg, &result);
+    if (out != stdout) fclose(out);
+
+    uint64_t errors = result.err_connect + result.err_timeout + result.err_io;
+    fprintf(stderr, "%llu requisicoes em %.2fs (%.0f req/s), %llu erros; "
+                    "p50 %.3fms p99 %.3fms p99.9 %.3fms\n",
+            (unsigned long long)result.completed, result.elapsed_s,
+            result.elapsed_s > 0 ? result.completed / result.elapsed_s : 0.0,
+            (unsigned long long)errors, lg_percentile_ms(&result, 0.50),
+            lg_percentile_ms(&result, 0.99), lg_percentile_ms(&result, 0.999));
+    return result.completed > 0 ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    char *host = "127.0.0.1";
+    int port = DEFAULT_PORT;
+    char *path = "/";
+    
+    // Opções (--bench, -t, ...) ativam o gerador de carga
+    if (argc >= 2 && argv[1][0] == '-') return run_bench(argc, argv);
+    
+    printf("=== CLIENTE WEB HTTP ===\n\n");
+    
+    // Parse argumentos
+    if (argc >= 2) path = argv[1];
+    if (argc >= 3) host = argv[2];
+    if (argc >= 4) port = atoi(argv[3]);
+    
+    printf("Host: %s\n", host);
+    printf("Porta: %d\n", port);
+    printf("Path: %s\n", path);
+    printf("========================\n\n");
+    
+    if (make_request(host, port, path) < 0) {
+        return 1;
+    }
+    
+    return 0;
 }
\ No newline at end of file
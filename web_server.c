@@ -1,398 +1,1622 @@
-#include "libtslog.h"
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
-#include <unistd.h>
-#include <pthread.h>
-#include <arpa/inet.h>
-#include <sys/socket.h>
-#include <sys/stat.h>
-#include <errno.h>
-#include <signal.h>
-
-#define MAX_PENDING 20
-#define BUFFER_SIZE 4096
-#define DEFAULT_PORT 8080
-#define THREAD_POOL_SIZE 10
-#define MAX_QUEUE_SIZE 100
-
-typedef struct {
-    int socket;
-    int id;
-} request_t;
-
-typedef struct {
-    request_t *queue[MAX_QUEUE_SIZE];
-    int front;
-    int rear;
-    int count;
-    pthread_mutex_t mutex;
-    pthread_cond_t not_empty;
-    pthread_cond_t not_full;
-} work_queue_t;
-
-typedef struct {
-    logger_t *logger;
-    pthread_mutex_t stats_mutex;
-    int total_requests;
-    int request_id;
-    work_queue_t *work_queue;
-    pthread_t thread_pool[THREAD_POOL_SIZE];
-} server_t;
-
-server_t server;
-volatile sig_atomic_t g_running = 1;
-
-void handle_sigint(int signum) {
-    g_running = 0;
-}
-
-// ======================== WORK QUEUE ========================
-
-work_queue_t* work_queue_init() {
-    work_queue_t *queue = malloc(sizeof(work_queue_t));
-    if (!queue) return NULL;
-    
-    queue->front = 0;
-    queue->rear = 0;
-    queue->count = 0;
-    
-    pthread_mutex_init(&queue->mutex, NULL);
-    pthread_cond_init(&queue->not_empty, NULL);
-    pthread_cond_init(&queue->not_full, NULL);
-    
-    return queue;
-}
-
-void work_queue_destroy(work_queue_t *queue) {
-    if (!queue) return;
-    
-    pthread_mutex_lock(&queue->mutex);
-    
-    // Libera requisições pendentes
-    while (queue->count > 0) {
-        request_t *req = queue->queue[queue->front];
-        close(req->socket);
-        free(req);
-        queue->front = (queue->front + 1) % MAX_QUEUE_SIZE;
-        queue->count--;
-    }
-    
-    pthread_mutex_unlock(&queue->mutex);
-    
-    pthread_cond_destroy(&queue->not_empty);
-    pthread_cond_destroy(&queue->not_full);
-    pthread_mutex_destroy(&queue->mutex);
-    free(queue);
-}
-
-int work_queue_push(work_queue_t *queue, request_t *req) {
-    pthread_mutex_lock(&queue->mutex);
-    
-    // Aguarda espaço na fila (com timeout para não bloquear indefinidamente)
-    while (queue->count >= MAX_QUEUE_SIZE && g_running) {
-        struct timespec timeout;
-        clock_gettime(CLOCK_REALTIME, &timeout);
-        timeout.tv_sec += 1; // timeout de 1 segundo
-        
-        int result = pthread_cond_timedwait(&queue->not_full, &queue->mutex, &timeout);
-        if (result == ETIMEDOUT) {
-            pthread_mutex_unlock(&queue->mutex);
-            return -1; // Fila cheia, rejeita conexão
-        }
-    }
-    
-    if (!g_running) {
-        pthread_mutex_unlock(&queue->mutex);
-        return -1;
-    }
-    
-    queue->queue[queue->rear] = req;
-    queue->rear = (queue->rear + 1) % MAX_QUEUE_SIZE;
-    queue->count++;
-    
-    pthread_cond_signal(&queue->not_empty);
-    pthread_mutex_unlock(&queue->mutex);
-    
-    return 0;
-}
-
-request_t* work_queue_pop(work_queue_t *queue) {
-    pthread_mutex_lock(&queue->mutex);
-    
-    // Aguarda trabalho na fila
-    while (queue->count == 0 && g_running) {
-        pthread_cond_wait(&queue->not_empty, &queue->mutex);
-    }
-    
-    if (!g_running && queue->count == 0) {
-        pthread_mutex_unlock(&queue->mutex);
-        return NULL;
-    }
-    
-    request_t *req = queue->queue[queue->front];
-    queue->front = (queue->front + 1) % MAX_QUEUE_SIZE;
-    queue->count--;
-    
-    pthread_cond_signal(&queue->not_full);
-    pthread_mutex_unlock(&queue->mutex);
-    
-    return req;
-}
-
-// ======================== HTTP FUNCTIONS ========================
-
-// Retorna o tipo de conteúdo (MIME type) com base na extensão do arquivo.
-const char* get_mime_type(const char* path) {
-    const char *dot = strrchr(path, '.');
-    if (!dot || dot == path) return "application/octet-stream";
-    if (strcmp(dot, ".html") == 0) return "text/html";
-    if (strcmp(dot, ".css") == 0) return "text/css";
-    if (strcmp(dot, ".js") == 0) return "application/javascript";
-    if (strcmp(dot, ".jpg") == 0) return "image/jpeg";
-    if (strcmp(dot, ".jpeg") == 0) return "image/jpeg";
-    if (strcmp(dot, ".png") == 0) return "image/png";
-    if (strcmp(dot, ".txt") == 0) return "text/plain";
-    return "application/octet-stream";
-}
-
-// Lê um arquivo do disco e o carrega na memória.
-char* read_file(const char* path, long* file_size) {
-    FILE* file = fopen(path, "rb");
-    if (!file) return NULL;
-
-    fseek(file, 0, SEEK_END);
-    *file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char* buffer = (char*)malloc(*file_size + 1);
-    if (!buffer) {
-        fclose(file);
-        return NULL;
-    }
-
-    fread(buffer, 1, *file_size, file);
-    buffer[*file_size] = '\0';
-    fclose(file);
-    return buffer;
-}
-
-// Envia uma resposta HTTP completa para o cliente.
-void send_http_response(int sock, const char* status, const char* mime_type, const char* content, long content_length) {
-    char header_buffer[BUFFER_SIZE];
-    snprintf(header_buffer, sizeof(header_buffer),
-             "HTTP/1.1 %s\r\n"
-             "Content-Type: %s\r\n"
-             "Content-Length: %ld\r\n"
-             "Connection: close\r\n"
-             "\r\n",
-             status, mime_type, content_length);
-
-    send(sock, header_buffer, strlen(header_buffer), 0);
-    send(sock, content, content_length, 0);
-}
-
-// Lida com a conexão de um único cliente.
-void handle_client_request(request_t *req) {
-    char buffer[BUFFER_SIZE];
-    char method[16], path[256], version[16];
-    char log_msg[512];
-
-    ssize_t bytes = recv(req->socket, buffer, BUFFER_SIZE - 1, 0);
-    if (bytes <= 0) {
-        goto cleanup;
-    }
-    buffer[bytes] = '\0';
-
-    if (sscanf(buffer, "%15s %255s %15s", method, path, version) != 3) {
-        send_http_response(req->socket, "400 Bad Request", "text/plain", "Bad Request", 11);
-        goto cleanup;
-    }
-
-    pthread_mutex_lock(&server.stats_mutex);
-    server.total_requests++;
-    pthread_mutex_unlock(&server.stats_mutex);
-    
-    snprintf(log_msg, sizeof(log_msg), "[REQ #%d] %s %s", req->id, method, path);
-    tslog_info(server.logger, log_msg);
-
-    if (strcmp(method, "GET") != 0) {
-        send_http_response(req->socket, "405 Method Not Allowed", "text/plain", "Method Not Allowed", 18);
-        goto cleanup;
-    }
-    
-    char file_path[512];
-    if (strcmp(path, "/") == 0) {
-        snprintf(file_path, sizeof(file_path), "www/index.html");
-    } else {
-        snprintf(file_path, sizeof(file_path), "www%s", path);
-    }
-
-    struct stat st;
-    if (stat(file_path, &st) != 0) {
-        const char* msg = "404 Not Found";
-        send_http_response(req->socket, "404 Not Found", "text/plain", msg, strlen(msg));
-        snprintf(log_msg, sizeof(log_msg), "[RES #%d] 404 Not Found - %s", req->id, file_path);
-        tslog_info(server.logger, log_msg);
-    } else {
-        long file_size;
-        char* file_content = read_file(file_path, &file_size);
-
-        if (file_content) {
-            const char* mime_type = get_mime_type(file_path);
-            send_http_response(req->socket, "200 OK", mime_type, file_content, file_size);
-            snprintf(log_msg, sizeof(log_msg), "[RES #%d] 200 OK - %s", req->id, file_path);
-            tslog_info(server.logger, log_msg);
-            free(file_content);
-        } else {
-            const char* msg = "500 Internal Server Error";
-            send_http_response(req->socket, "500 Internal Server Error", "text/plain", msg, strlen(msg));
-            snprintf(log_msg, sizeof(log_msg), "[RES #%d] 500 Server Error - %s", req->id, file_path);
-            tslog_error(server.logger, log_msg);
-        }
-    }
-
-cleanup:
-    close(req->socket);
-    free(req);
-}
-
-// Thread worker do pool
-void* worker_thread(void *arg) {
-    char log_msg[256];
-    int thread_id = *((int*)arg);
-    
-    snprintf(log_msg, sizeof(log_msg), "Worker thread #%d iniciada", thread_id);
-    tslog_info(server.logger, log_msg);
-    
-    while (g_running) {
-        request_t *req = work_queue_pop(server.work_queue);
-        if (req) {
-            handle_client_request(req);
-        }
-    }
-    
-    snprintf(log_msg, sizeof(log_msg), "Worker thread #%d finalizando", thread_id);
-    tslog_info(server.logger, log_msg);
-    
-    return NULL;
-}
-
-// Função para obter próximo request_id de forma thread-safe
-int get_next_request_id() {
-    pthread_mutex_lock(&server.stats_mutex);
-    int id = ++server.request_id;
-    pthread_mutex_unlock(&server.stats_mutex);
-    return id;
-}
-
-// Função principal que inicializa e executa o servidor.
-int main(int argc, char *argv[]) {
-    int port = DEFAULT_PORT;
-    if (argc >= 2) port = atoi(argv[1]);
-    
-    signal(SIGINT, handle_sigint);
-    
-    printf("=== SERVIDOR WEB HTTP (em C) ===\n");
-    printf("Porta: %d\n", port);
-    printf("Diretorio raiz: ./www/\n");
-    printf("Pool de threads: %d workers\n", THREAD_POOL_SIZE);
-    printf("Fila maxima: %d conexoes\n", MAX_QUEUE_SIZE);
-    printf("================================\n\n");
-    
-    server.logger = tslog_init("web_server.log");
-    pthread_mutex_init(&server.stats_mutex, NULL);
-    server.total_requests = 0;
-    server.request_id = 0;
-    
-    // Inicializa fila de trabalho
-    server.work_queue = work_queue_init();
-    if (!server.work_queue) {
-        fprintf(stderr, "Erro ao criar fila de trabalho\n");
-        return 1;
-    }
-    
-    tslog_info(server.logger, "=== Servidor iniciado ===");
-    
-    // Cria pool de threads
-    char log_msg[256];
-    snprintf(log_msg, sizeof(log_msg), "Criando pool com %d threads...", THREAD_POOL_SIZE);
-    tslog_info(server.logger, log_msg);
-    
-    int thread_ids[THREAD_POOL_SIZE];
-    for (int i = 0; i < THREAD_POOL_SIZE; i++) {
-        thread_ids[i] = i + 1;
-        if (pthread_create(&server.thread_pool[i], NULL, worker_thread, &thread_ids[i]) != 0) {
-            fprintf(stderr, "Erro ao criar thread worker %d\n", i);
-            return 1;
-        }
-    }
-    
-    int server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    struct sockaddr_in server_addr = {0};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(port);
-    
-    if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        tslog_error(server.logger, "Erro no bind");
-        return 1;
-    }
-    
-    if (listen(server_socket, MAX_PENDING) < 0) {
-        tslog_error(server.logger, "Erro no listen");
-        return 1;
-    }
-    
-    snprintf(log_msg, sizeof(log_msg), "Escutando em http://localhost:%d", port);
-    tslog_info(server.logger, log_msg);
-    printf("Pressione Ctrl+C para encerrar\n\n");
-    
-    while (g_running) {
-        int client_socket = accept(server_socket, NULL, NULL);
-        if (client_socket < 0) {
-            if (errno == EINTR && !g_running) break;
-            continue;
-        }
-        
-        request_t *req = malloc(sizeof(request_t));
-        if (!req) {
-            close(client_socket);
-            continue;
-        }
-        
-        req->socket = client_socket;
-        req->id = get_next_request_id(); // Thread-safe agora!
-        
-        // Adiciona à fila de trabalho
-        if (work_queue_push(server.work_queue, req) < 0) {
-            // Fila cheia, rejeita conexão
-            const char *msg = "503 Service Unavailable\r\nConnection: close\r\n\r\nServidor sobrecarregado";
-            send(client_socket, msg, strlen(msg), 0);
-            close(client_socket);
-            free(req);
-            
-            tslog_error(server.logger, "Fila de trabalho cheia - conexao rejeitada");
-        }
-    }
-    
-    tslog_info(server.logger, "=== Servidor finalizando... ===");
-    
-    // Sinaliza threads para parar
-    pthread_cond_broadcast(&server.work_queue->not_empty);
-    
-    // Aguarda threads terminarem
-    for (int i = 0; i < THREAD_POOL_SIZE; i++) {
-        pthread_join(server.thread_pool[i], NULL);
-    }
-    
-    close(server_socket);
-    work_queue_destroy(server.work_queue);
-    pthread_mutex_destroy(&server.stats_mutex);
-    tslog_destroy(server.logger);
-    printf("\nServidor encerrado.\n");
-    return 0;
+#define _GNU_SOURCE
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <getopt.h>
+#include <poll.h>
+#include <strings.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+#define MAX_PENDING 20
+#define DEFAULT_PORT 8080
+#define HTTP_DATE_FORMAT "%a, %d %b %Y %H:%M:%S GMT"  // IMF-fixdate (RFC 9110)
+#define CACHE_CONTROL_MAX 128      // valor de uma regra --cache-control
+
+// Modelo de atendimento escolhido com --mode
+typedef enum {
+    MODE_THREADS = 0,   // accept bloqueante + fila + pool
+    MODE_EPOLL,         // event loops + pool só para disco
+    MODE_REUSEPORT,     // um socket SO_REUSEPORT por listener, sem fila
+    MODE_URING          // event loops do modo epoll com I/O pelo io_uring
+} server_mode_t;
+
+server_t server;
+volatile sig_atomic_t g_running = 1;
+
+void handle_sigint(int signum) {
+    g_running = 0;
+}
+
+// SIGHUP: rotação manual do log e releitura do bundle (os dois só marcam
+// um flag atômico)
+void handle_sighup(int signum) {
+    tslog_rotate(server.logger);
+    bundle_request_reload();
+}
+
+// ======================== HTTP FUNCTIONS ========================
+
+// Lê um arquivo do disco e o carrega na memória.
+char* read_file(const char* path, long* file_size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    *file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* buffer = (char*)malloc(*file_size + 1);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
+
+    fread(buffer, 1, *file_size, file);
+    buffer[*file_size] = '\0';
+    fclose(file);
+    return buffer;
+}
+
+// Respostas de erro: o cabeçalho (sem a linha Connection) é montado uma
+// vez na partida e depois só referenciado pelos iovecs
+static struct {
+    const char *status;
+    const char *body;
+    int retry_after;        // segundos em Retry-After (0 = sem o cabeçalho)
+    char header[160];
+    size_t header_len;
+} error_responses[HTTP_ERROR_COUNT] = {
+    [HTTP_400] = { "400 Bad Request", "Bad Request" },
+    [HTTP_404] = { "404 Not Found", "404 Not Found" },
+    [HTTP_405] = { "405 Method Not Allowed", "Method Not Allowed" },
+    [HTTP_413] = { "413 Content Too Large", "Content Too Large" },
+    [HTTP_429] = { "429 Too Many Requests", "Too Many Requests", 1 },
+    [HTTP_431] = { "431 Request Header Fields Too Large", "Request Header Fields Too Large" },
+    [HTTP_500] = { "500 Internal Server Error", "500 Internal Server Error" },
+    [HTTP_501] = { "501 Not Implemented", "Not Implemented" },
+    [HTTP_503] = { "503 Service Unavailable", "Servidor sobrecarregado", 1 },
+};
+
+void render_error_responses(void) {
+    for (int i = 0; i < HTTP_ERROR_COUNT; i++) {
+        int len = snprintf(error_responses[i].header, sizeof(error_responses[i].header),
+                           "HTTP/1.1 %s\r\n"
+                           "Content-Type: text/plain\r\n"
+                           "Content-Length: %zu\r\n",
+                           error_responses[i].status, strlen(error_responses[i].body));
+        if (error_responses[i].retry_after) {
+            len += snprintf(error_responses[i].header + len, sizeof(error_responses[i].header) - len,
+                            "Retry-After: %d\r\n", error_responses[i].retry_after);
+        }
+        error_responses[i].header_len = len;
+    }
+}
+
+void set_error_response(response_t *res, http_error_t error) {
+    res->status = error_responses[error].status;
+    res->mime_type = "text/plain";
+    res->body = error_responses[error].body;
+    res->body_len = strlen(res->body);
+    res->owned = NULL;
+    res->header = error_responses[error].header;
+    res->header_len = error_responses[error].header_len;
+    res->cached = NULL;
+    res->bundle = NULL;
+    res->file_fd = -1;
+    res->file_offset = 0;
+    res->multipart = NULL;
+    res->encoding = NULL;
+    res->vary = 0;
+    res->extra[0] = '\0';
+}
+
+void set_not_modified(response_t *res) {
+    free(res->owned);
+    res->owned = NULL;
+    if (res->file_fd >= 0) close(res->file_fd);
+    res->file_fd = -1;
+    res->status = "304 Not Modified";
+    res->body = NULL;
+    res->body_len = 0;
+    res->header = NULL;
+}
+
+void response_prepare(response_t *res, char *buf, size_t size) {
+    if (res->header) return; // já pronto (cache ou erro)
+    int len;
+    if (strncmp(res->status, "304", 3) == 0) {
+        // Sem corpo: só os validadores e o Vary que o 200 teria
+        len = snprintf(buf, size, "HTTP/1.1 %s\r\n%s%s", res->status,
+                       res->vary ? "Vary: Accept-Encoding\r\n" : "", res->extra);
+    } else {
+        len = snprintf(buf, size,
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: %s\r\n"
+                       "Content-Length: %ld\r\n"
+                       "%s%s%s"
+                       "%s%s",
+                       res->status, res->mime_type, res->body_len,
+                       res->encoding ? "Content-Encoding: " : "", res->encoding ? res->encoding : "",
+                       res->encoding ? "\r\n" : "",
+                       res->vary ? "Vary: Accept-Encoding\r\n" : "", res->extra);
+    }
+    res->header = buf;
+    res->header_len = len < (int)size ? len : size - 1;
+}
+
+void response_free(response_t *res) {
+    free(res->owned);
+    res->owned = NULL;
+    file_cache_release(res->cached);
+    res->cached = NULL;
+    bundle_release(res->bundle);
+    res->bundle = NULL;
+    res->header = NULL;
+    if (res->file_fd >= 0) close(res->file_fd);
+    res->file_fd = -1;
+    res->multipart = NULL;
+    if (res->arena) arena_reset(res->arena); // fim do pedido
+}
+
+int send_file_body(int sock, int file_fd, off_t *offset, off_t end) {
+    while (*offset < end) {
+        ssize_t n = sendfile(sock, file_fd, offset, end - *offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+            return -1;
+        }
+        if (n == 0) return -1; // arquivo encolheu no meio do envio
+    }
+    return 0;
+}
+
+// Envia os iovecs pulando os *sent bytes já enviados; uma syscall por volta
+static int send_iov(int sock, const struct iovec *iov, int count, size_t *sent, int flags) {
+    for (;;) {
+        struct iovec cur[4];
+        int n = 0;
+        size_t skip = *sent;
+        for (int i = 0; i < count; i++) {
+            if (skip >= iov[i].iov_len) {
+                skip -= iov[i].iov_len;
+                continue;
+            }
+            cur[n].iov_base = (char *)iov[i].iov_base + skip;
+            cur[n].iov_len = iov[i].iov_len - skip;
+            skip = 0;
+            n++;
+        }
+        if (n == 0) return 0;
+
+        struct msghdr msg = { .msg_iov = cur, .msg_iovlen = n };
+        ssize_t w = sendmsg(sock, &msg, flags | MSG_NOSIGNAL);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+            return -1;
+        }
+        *sent += w;
+    }
+}
+
+int response_chunk(const response_t *res, size_t sent, response_chunk_t *chunk) {
+    static const char keep[] = "Connection: keep-alive\r\n\r\n";
+    static const char close_[] = "Connection: close\r\n\r\n";
+    int streamed = res->file_fd >= 0 || res->multipart;
+    const struct iovec head[3] = {
+        { (void *)res->header, res->header_len },
+        { res->keep_alive ? (void *)keep : (void *)close_,
+          res->keep_alive ? sizeof(keep) - 1 : sizeof(close_) - 1 },
+        { (void *)res->body, streamed ? 0 : res->body_len },
+    };
+    chunk->iov_count = 0;
+    chunk->file_fd = -1;
+
+    // Cabeçalho, linha Connection e corpo em memória saem juntos
+    size_t pos = 0;
+    for (int i = 0; i < 3; i++) {
+        if (sent < pos + head[i].iov_len) {
+            size_t skip = sent > pos ? sent - pos : 0;
+            chunk->iov[chunk->iov_count].iov_base = (char *)head[i].iov_base + skip;
+            chunk->iov[chunk->iov_count].iov_len = head[i].iov_len - skip;
+            chunk->iov_count++;
+        }
+        pos += head[i].iov_len;
+    }
+    chunk->more = streamed;
+    if (chunk->iov_count) return 1;
+    if (!streamed) return 0;
+
+    if (!res->multipart) {
+        size_t done = sent - pos;
+        if (done >= (size_t)res->body_len) return 0;
+        chunk->file_fd = res->file_fd;
+        chunk->file_offset = res->file_offset + done;
+        chunk->file_len = res->body_len - done;
+        chunk->more = 0;
+        return 1;
+    }
+
+    // multipart/byteranges: cabeçalho de cada parte e a faixa, do arquivo ou
+    // do corpo em memória, e por fim o delimitador de fechamento
+    const multipart_t *mp = res->multipart;
+    const char *part_head = mp->heads;
+    for (int i = 0; i <= mp->count; i++) {
+        int last = i == mp->count;
+        size_t head_len = last ? mp->tail_len : mp->part[i].head_len;
+        if (sent < pos + head_len) {
+            chunk->iov[0].iov_base = (char *)part_head + (sent - pos);
+            chunk->iov[0].iov_len = head_len - (sent - pos);
+            chunk->iov_count = 1;
+            chunk->more = !last;
+            return 1;
+        }
+        pos += head_len;
+        part_head += head_len;
+        if (last) break;
+
+        off_t start = mp->part[i].start, len = mp->part[i].len;
+        if (sent < pos + len) {
+            size_t done = sent - pos;
+            if (res->file_fd >= 0) {
+                chunk->file_fd = res->file_fd;
+                chunk->file_offset = start + done;
+                chunk->file_len = len - done;
+            } else {
+                chunk->iov[0].iov_base = (char *)res->body + start + done;
+                chunk->iov[0].iov_len = len - done;
+                chunk->iov_count = 1;
+            }
+            chunk->more = 1;
+            return 1;
+        }
+        pos += len;
+    }
+    return 0;
+}
+
+int response_send(int sock, const response_t *res, size_t *sent) {
+    response_chunk_t chunk;
+    while (response_chunk(res, *sent, &chunk)) {
+        int r;
+        if (chunk.iov_count) {
+            // Com arquivo, MSG_MORE junta o cabeçalho ao primeiro pedaço do sendfile
+            size_t done = 0;
+            r = send_iov(sock, chunk.iov, chunk.iov_count, &done, chunk.more ? MSG_MORE : 0);
+            *sent += done;
+        } else {
+            off_t offset = chunk.file_offset;
+            r = send_file_body(sock, chunk.file_fd, &offset, offset + chunk.file_len);
+            *sent += offset - chunk.file_offset;
+        }
+        if (r != 0) return r;
+    }
+    return 0;
+}
+
+// HTTP/1.1 mantém a conexão por padrão; HTTP/1.0 só com "Connection: keep-alive"
+static int wants_keep_alive(const http_parser_t *http) {
+    http_slice_t connection = http->headers[HTTP_HDR_CONNECTION];
+    int keep = http->version_minor >= 1;
+    if (http_slice_has_token(connection, "close")) keep = 0;
+    else if (http_slice_has_token(connection, "keep-alive")) keep = 1;
+    return keep && server.keepalive_timeout > 0;
+}
+
+int begin_request(request_t *req, http_parse_result_t result, size_t buffered, response_t *res) {
+    http_parser_t *http = &req->http;
+
+    req->keep_alive = 0;
+    req->length = 0;
+    req->route = NULL;
+    if (result == HTTP_PARSE_TOO_LARGE) {
+        set_error_response(res, HTTP_431);
+        return 1;
+    }
+    if (result != HTTP_PARSE_DONE) {
+        set_error_response(res, HTTP_400);
+        return 1;
+    }
+    stats_time(STAT_PARSE, req->parse_ns);
+    req->parse_ns = 0;
+
+    stats_request();
+    tslog_infof(server.logger, "[REQ #%d] %.*s %.*s", req->id,
+                (int)http->method.len, http->method.ptr, (int)http->path.len, http->path.ptr);
+
+    if (!rate_limit_allow(req->client)) {
+        stats_shed(SHED_RATE_LIMIT);
+        set_error_response(res, HTTP_429);
+        return 1;
+    }
+
+    // Corpo em chunks não é suportado: sem saber onde ele termina, o resto
+    // viraria o próximo pedido (request smuggling). Com Content-Length junto
+    // é ambíguo (RFC 9112 6.3): 400. Os dois fecham a conexão
+    if (http->headers[HTTP_HDR_TRANSFER_ENCODING].len > 0) {
+        set_error_response(res, http->content_length >= 0 ? HTTP_400 : HTTP_501);
+        return 1;
+    }
+
+    // Método diferencia maiúsculas (RFC 9110 9.1): "get" não é GET
+    if (http->method.len != 3 || memcmp(http->method.ptr, "GET", 3) != 0) {
+        // Um corpo eventual não é lido: fecha em vez de confundir o próximo pedido
+        set_error_response(res, HTTP_405);
+        return 1;
+    }
+    if (http->content_length > MAX_BODY_SIZE) {
+        set_error_response(res, HTTP_413);
+        return 1;
+    }
+
+    // O corpo (ignorado num GET) só é pulado se já estiver inteiro no buffer;
+    // senão a conexão fecha depois da resposta
+    req->length = http->header_len + (http->content_length > 0 ? http->content_length : 0);
+    if (req->length <= buffered) req->keep_alive = wants_keep_alive(http);
+
+    // ".." e afins nunca chegam a virar caminho em server.root
+    if (!route_path_safe(http->path)) {
+        set_error_response(res, HTTP_400);
+        tslog_infof(server.logger, "[RES #%d] 400 Bad Request - caminho invalido", req->id);
+        return 1;
+    }
+
+    // Rotas com handler geram a resposta em memória, sem passar pelos workers
+    req->route = route_find(http->path);
+    if (req->route && req->route->handler) {
+        req->route->handler(req, res, req->route->arg);
+        return 1;
+    }
+    return 0;
+}
+
+// Caminho em server.root (www/) da tentativa attempt do alvo (ver
+// route_target); retorna o MIME ou NULL se não há essa tentativa
+static const char *resolve_path(const request_t *req, int attempt, char *file_path, size_t size) {
+    char rel[512];
+    const char *mime_type = route_target(req, attempt, rel, sizeof(rel));
+    if (!mime_type || (size_t)snprintf(file_path, size, "%s%s", server.root, rel) >= size) return NULL;
+    return mime_type;
+}
+
+// Rotas da partida: métricas em memória, "/" servindo index.html e o resto
+// de server.root, com "/about" achando about.html
+static void register_routes(void) {
+    route_add(&(route_t){ .path = "/stats", .match = ROUTE_EXACT, .handler = stats_serve, .arg = 0 });
+    route_add(&(route_t){ .path = "/metrics", .match = ROUTE_EXACT, .handler = stats_serve, .arg = 1 });
+    route_add(&(route_t){ .path = "/", .match = ROUTE_EXACT, .file = "/index.html" });
+    route_add(&(route_t){ .path = "/", .match = ROUTE_PREFIX, .suffix = ".html" });
+}
+
+// ======================== VALIDADORES E CACHE-CONTROL ========================
+
+// Regras de --cache-control: prefixo do caminho dentro de server.root -> valor
+static struct {
+    char prefix[256];
+    size_t len;
+    char value[CACHE_CONTROL_MAX];
+} cache_rules[MAX_CACHE_RULES];
+static int cache_rule_count;
+
+// "PREFIXO=VALOR", ex. "/static/=public, max-age=31536000"
+static int add_cache_rule(const char *spec) {
+    const char *eq = strchr(spec, '=');
+    if (!eq || eq == spec || spec[0] != '/' || !eq[1] || cache_rule_count == MAX_CACHE_RULES) return -1;
+    size_t len = eq - spec;
+    if (len >= sizeof(cache_rules[0].prefix) || strlen(eq + 1) >= CACHE_CONTROL_MAX ||
+        strpbrk(eq + 1, "\r\n")) return -1;
+    memcpy(cache_rules[cache_rule_count].prefix, spec, len);
+    cache_rules[cache_rule_count].prefix[len] = '\0';
+    cache_rules[cache_rule_count].len = len;
+    strcpy(cache_rules[cache_rule_count].value, eq + 1);
+    cache_rule_count++;
+    return 0;
+}
+
+const char *cache_control_for(const char *file_path) {
+    size_t root_len = strlen(server.root);
+    if (strncmp(file_path, server.root, root_len) != 0) return NULL;
+    return cache_control_rule(file_path + root_len); // "/" vira "/index.html": regra estável por arquivo
+}
+
+const char *cache_control_rule(const char *rel) {
+    const char *best = NULL;
+    size_t best_len = 0;
+    for (int i = 0; i < cache_rule_count; i++) {
+        if (cache_rules[i].len >= best_len && strncmp(rel, cache_rules[i].prefix, cache_rules[i].len) == 0) {
+            best = cache_rules[i].value;
+            best_len = cache_rules[i].len;
+        }
+    }
+    return best;
+}
+
+// ETag forte a partir de inode, tamanho e mtime em ns: muda com qualquer
+// escrita ou troca do arquivo sem precisar ler o conteúdo
+void file_meta_init(file_meta_t *meta, const struct stat *st) {
+    snprintf(meta->etag, sizeof(meta->etag), "%llx-%llx-%llx",
+             (unsigned long long)st->st_ino, (unsigned long long)st->st_size,
+             (unsigned long long)st->st_mtim.tv_sec * 1000000000ULL + st->st_mtim.tv_nsec);
+    meta->mtime = st->st_mtime;
+    struct tm tm;
+    gmtime_r(&meta->mtime, &tm);
+    strftime(meta->last_modified, sizeof(meta->last_modified), HTTP_DATE_FORMAT, &tm);
+}
+
+// ETag entre aspas da variante: cada codificação é outra representação
+// e tem a sua ("-gzip", "-br")
+static int format_etag(char *buf, size_t size, const file_meta_t *meta, content_encoding_t enc) {
+    return snprintf(buf, size, "\"%s%s%s\"", meta->etag, enc ? "-" : "", enc ? compress_name(enc) : "");
+}
+
+size_t file_meta_headers(char *buf, size_t size, const file_meta_t *meta, content_encoding_t enc,
+                         const char *cache_control) {
+    char etag[80];
+    format_etag(etag, sizeof(etag), meta, enc);
+    int len = snprintf(buf, size,
+                       "ETag: %s\r\n"
+                       "Last-Modified: %s\r\n"
+                       "Accept-Ranges: bytes\r\n"
+                       "%s%s%s",
+                       etag, meta->last_modified,
+                       cache_control ? "Cache-Control: " : "", cache_control ? cache_control : "",
+                       cache_control ? "\r\n" : "");
+    return len < (int)size ? (size_t)len : size - 1;
+}
+
+size_t format_ready_header(char *buf, size_t size, int not_modified, const char *mime_type, size_t body_len,
+                           content_encoding_t enc, int vary, const file_meta_t *meta, const char *cache_control) {
+    char extra[EXTRA_HEADERS_MAX];
+    file_meta_headers(extra, sizeof(extra), meta, enc, cache_control);
+    const char *vary_line = vary ? "Vary: Accept-Encoding\r\n" : "";
+    int len;
+    if (not_modified) {
+        // 304 repete os validadores e o Vary do 200, sem corpo nem Content-Length
+        len = snprintf(buf, size, "HTTP/1.1 304 Not Modified\r\n%s%s", vary_line, extra);
+    } else {
+        len = snprintf(buf, size,
+                       "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: %s\r\n"
+                       "Content-Length: %zu\r\n"
+                       "%s%s%s"
+                       "%s%s",
+                       mime_type, body_len,
+                       enc ? "Content-Encoding: " : "", enc ? compress_name(enc) : "", enc ? "\r\n" : "",
+                       vary_line, extra);
+    }
+    return len < (int)size ? (size_t)len : size - 1;
+}
+
+// If-None-Match: lista de entidades ou "*"; comparação fraca (W/ ignorado)
+static int etag_listed(http_slice_t list, const file_meta_t *meta, content_encoding_t enc) {
+    char etag[80];
+    int etag_len = format_etag(etag, sizeof(etag), meta, enc);
+    const char *p = list.ptr, *end = list.ptr + list.len;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        if (p < end && *p == '*') return 1;
+        if (end - p >= 2 && p[0] == 'W' && p[1] == '/') p += 2;
+        const char *tag = p;
+        if (p < end && *p == '"') {
+            for (p++; p < end && *p != '"'; p++) {}
+            if (p < end) p++;
+        }
+        if (p - tag == etag_len && memcmp(tag, etag, etag_len) == 0) return 1;
+        while (p < end && *p != ',') p++;
+    }
+    return 0;
+}
+
+// Data HTTP de um cabeçalho; -1 se ausente ou inválida
+static time_t parse_http_date(http_slice_t value) {
+    char date[64];
+    if (value.len == 0 || value.len >= sizeof(date)) return -1;
+    memcpy(date, value.ptr, value.len);
+    date[value.len] = '\0';
+    struct tm tm = {0};
+    const char *rest = strptime(date, HTTP_DATE_FORMAT, &tm);
+    if (!rest || *rest) return -1;
+    return timegm(&tm);
+}
+
+int http_not_modified(const http_parser_t *http, const file_meta_t *meta, content_encoding_t enc) {
+    http_slice_t inm = http->headers[HTTP_HDR_IF_NONE_MATCH];
+    if (inm.len > 0) return etag_listed(inm, meta, enc); // prevalece sobre If-Modified-Since
+
+    time_t since = parse_http_date(http->headers[HTTP_HDR_IF_MODIFIED_SINCE]);
+    return since >= 0 && meta->mtime <= since; // data inválida: ignora o cabeçalho
+}
+
+// ======================== RANGE ========================
+
+typedef struct {
+    off_t start, len;
+} byte_range_t;
+
+static int read_offset(const char **p, const char *end, off_t *value) {
+    const char *start = *p;
+    *value = 0;
+    for (; *p < end && **p >= '0' && **p <= '9'; (*p)++) {
+        if (*value > (INT64_MAX - 9) / 10) return -1;
+        *value = *value * 10 + (**p - '0');
+    }
+    return *p > start;
+}
+
+// "bytes=0-99, 200-, -500" sobre um corpo de size bytes. Retorna quantas
+// faixas são satisfazíveis (0 = 416) ou -1 para ignorar o Range e mandar tudo
+static int parse_ranges(http_slice_t header, off_t size, byte_range_t *out) {
+    const char *p = header.ptr, *end = header.ptr + header.len;
+    if (header.len < 6 || strncasecmp(p, "bytes=", 6) != 0) return -1;
+    p += 6;
+
+    int count = 0, specs = 0;
+    off_t total = 0;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) p++;
+        if (p == end) break;
+        if (++specs > MAX_RANGES) return -1;
+
+        off_t first, last;
+        int has_first = read_offset(&p, end, &first);
+        if (has_first < 0 || p == end || *p++ != '-') return -1;
+        int has_last = read_offset(&p, end, &last);
+        if (has_last < 0) return -1;
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p < end && *p != ',') return -1;
+
+        if (!has_first) {
+            // Sufixo: os últimos "last" bytes
+            if (!has_last) return -1;
+            if (last == 0 || size == 0) continue;
+            first = last < size ? size - last : 0;
+            last = size - 1;
+        } else {
+            if (has_last && last < first) return -1;
+            if (first >= size) continue;
+            if (!has_last || last >= size) last = size - 1;
+        }
+        out[count].start = first;
+        out[count].len = last - first + 1;
+        total += out[count].len;
+        count++;
+    }
+    if (specs == 0) return -1;
+    // Faixas sobrepostas somando mais que o corpo: mais barato mandar tudo
+    if (total > size) return -1;
+    return count;
+}
+
+// If-Range: a faixa só vale se a versão do cliente ainda é a atual
+// (comparação forte: ETag fraca nunca casa; data precisa ser a mesma)
+static int if_range_matches(const http_parser_t *http, const file_meta_t *meta, content_encoding_t enc) {
+    http_slice_t value = http->headers[HTTP_HDR_IF_RANGE];
+    if (value.len == 0) return 1;
+    if (value.ptr[0] == '"') {
+        char etag[80];
+        int etag_len = format_etag(etag, sizeof(etag), meta, enc);
+        return value.len == (size_t)etag_len && memcmp(value.ptr, etag, etag_len) == 0;
+    }
+    if (value.len >= 2 && value.ptr[0] == 'W' && value.ptr[1] == '/') return 0;
+    return parse_http_date(value) == meta->mtime;
+}
+
+static multipart_t *build_multipart(arena_t *arena, const byte_range_t *ranges, int count, off_t size,
+                                    const char *mime_type) {
+    static _Atomic unsigned long sequence;
+    if (!arena) return NULL;
+    multipart_t *mp = arena_alloc(arena, sizeof(*mp));
+    // Cada cabeçalho de parte: delimitador, Content-Type e Content-Range
+    size_t cap = count * (strlen(mime_type) + 128) + 64;
+    if (!mp || !(mp->heads = arena_alloc(arena, cap))) return NULL;
+    char boundary[40];
+    snprintf(boundary, sizeof(boundary), "%08lx%016llx",
+             atomic_fetch_add_explicit(&sequence, 1, memory_order_relaxed), (unsigned long long)stats_now_ns());
+    snprintf(mp->content_type, sizeof(mp->content_type), "multipart/byteranges; boundary=%s", boundary);
+
+    size_t used = 0;
+    for (int i = 0; i < count; i++) {
+        int len = snprintf(mp->heads + used, cap - used,
+                           "\r\n--%s\r\n"
+                           "Content-Type: %s\r\n"
+                           "Content-Range: bytes %lld-%lld/%lld\r\n\r\n",
+                           boundary, mime_type, (long long)ranges[i].start,
+                           (long long)(ranges[i].start + ranges[i].len - 1), (long long)size);
+        mp->part[i].start = ranges[i].start;
+        mp->part[i].len = ranges[i].len;
+        mp->part[i].head_len = len;
+        used += len;
+    }
+    mp->tail_len = snprintf(mp->heads + used, cap - used, "\r\n--%s--\r\n", boundary);
+    mp->count = count;
+    return mp;
+}
+
+void response_apply_range(const http_parser_t *http, const file_meta_t *meta, content_encoding_t enc,
+                          response_t *res) {
+    if (http->headers[HTTP_HDR_RANGE].len == 0 || !if_range_matches(http, meta, enc)) return;
+    byte_range_t ranges[MAX_RANGES];
+    off_t size = res->body_len;
+    int count = parse_ranges(http->headers[HTTP_HDR_RANGE], size, ranges);
+    // multipart de um corpo comprimido não teria Content-Encoding certo: manda tudo
+    if (count < 0 || (count > 1 && enc != ENC_IDENTITY)) return;
+
+    size_t used = strlen(res->extra);
+    if (count == 0) {
+        static const char body[] = "Range Not Satisfiable";
+        free(res->owned);
+        res->owned = NULL;
+        if (res->file_fd >= 0) close(res->file_fd);
+        res->file_fd = -1;
+        res->status = "416 Range Not Satisfiable";
+        res->mime_type = "text/plain";
+        res->body = body;
+        res->body_len = sizeof(body) - 1;
+        res->encoding = NULL;
+        res->vary = 0;
+        snprintf(res->extra, sizeof(res->extra), "Content-Range: bytes */%lld\r\n", (long long)size);
+    } else if (count == 1) {
+        // Só a faixa: ponteiro dentro do corpo em memória ou deslocamento no arquivo
+        if (res->file_fd >= 0) res->file_offset = ranges[0].start;
+        else res->body += ranges[0].start;
+        res->body_len = ranges[0].len;
+        res->status = "206 Partial Content";
+        snprintf(res->extra + used, sizeof(res->extra) - used, "Content-Range: bytes %lld-%lld/%lld\r\n",
+                 (long long)ranges[0].start, (long long)(ranges[0].start + ranges[0].len - 1),
+                 (long long)size);
+    } else {
+        multipart_t *mp = build_multipart(res->arena, ranges, count, size, res->mime_type);
+        if (!mp) return; // sem memória: o 200 inteiro ainda é uma resposta válida
+        res->multipart = mp;
+        res->body_len = mp->tail_len;
+        for (int i = 0; i < count; i++) res->body_len += mp->part[i].head_len + mp->part[i].len;
+        res->mime_type = mp->content_type;
+        res->status = "206 Partial Content";
+    }
+    res->header = NULL; // o pronto do cache é o do 200
+}
+
+// Acerto no cache (ou qualquer pedido com --bundle): nenhuma syscall, pode
+// rodar direto no event loop
+int serve_cached(request_t *req, response_t *res) {
+    if (bundle_serve(req, res)) return 1;
+    char file_path[512];
+    int attempt = 0;
+    for (;; attempt++) {
+        if (!resolve_path(req, attempt, file_path, sizeof(file_path))) return 0;
+        if (file_cache_get(file_path, &req->http, res)) break;
+    }
+    tslog_infof(server.logger, "[RES #%d] %s - %s%s%s%s", req->id, res->status, file_path,
+                res->encoding ? " (" : "", res->encoding ? res->encoding : "", res->encoding ? ")" : "");
+    return 1;
+}
+
+// Variantes comprimidas de um arquivo que vai para o cache (ou o bundle): o
+// irmão .gz/.br em www/ se existir, senão comprime agora se compress (uma vez;
+// depois vem do cache)
+void file_variants_load(const char *file_path, const char *mime_type, int compress, file_variants_t *v) {
+    int compressible = compress_mime(mime_type);
+    for (int i = 1; i < ENC_COUNT; i++) {
+        char sibling[520];
+        long size;
+        snprintf(sibling, sizeof(sibling), "%s%s", file_path, compress_suffix(i));
+        v->body[i] = read_file(sibling, &size);
+        v->len[i] = v->body[i] ? (size_t)size : 0;
+        if (v->body[i]) {
+            v->vary = 1;
+            continue;
+        }
+        if (server.compress && compress && compressible && compress_available(i) &&
+            v->len[ENC_IDENTITY] >= server.compress_min) {
+            v->body[i] = compress_body(i, v->body[ENC_IDENTITY], v->len[ENC_IDENTITY], &v->len[i]);
+            if (v->body[i]) {
+                tslog_debugf(server.logger, "[COMPRESS] %s: %s %zu -> %zu bytes", file_path,
+                             compress_name(i), v->len[ENC_IDENTITY], v->len[i]);
+            }
+        }
+    }
+    if (compressible) v->vary = 1;
+}
+
+// Arquivo grande vai por sendfile: usa o irmão .gz/.br aceito, se houver
+static int open_sibling(const char *file_path, int accepted, response_t *res, struct stat *st,
+                        content_encoding_t *enc) {
+    for (int i = ENC_COUNT - 1; i > 0; i--) {
+        if (!(accepted & (1 << i))) continue;
+        char sibling[520];
+        snprintf(sibling, sizeof(sibling), "%s%s", file_path, compress_suffix(i));
+        struct stat sst;
+        if (stat(sibling, &sst) != 0 || !S_ISREG(sst.st_mode)) continue;
+        int fd = open(sibling, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        *st = sst;
+        *enc = i;
+        res->encoding = compress_name(i);
+        res->vary = 1;
+        return fd;
+    }
+    return -1;
+}
+
+// Resolve o caminho em www/ e carrega o arquivo (stat + leitura bloqueiam)
+void build_response(request_t *req, response_t *res) {
+    if (serve_cached(req, res)) return;
+
+    // Lida antes do stat: se o arquivo mudar durante a leitura não vai para o cache
+    unsigned long generation = file_cache_generation();
+    long long started = stats_now_ns();
+
+    // Primeira tentativa que existe ("/about" -> about.html, senão about)
+    char file_path[512] = "";
+    const char *mime_type = NULL;
+    struct stat st;
+    int found = 0;
+    for (int attempt = 0; !found; attempt++) {
+        char candidate[512];
+        const char *mime = resolve_path(req, attempt, candidate, sizeof(candidate));
+        if (!mime) break;
+        found = stat(candidate, &st) == 0 && S_ISREG(st.st_mode);
+        if (found || attempt == 0) {
+            memcpy(file_path, candidate, sizeof(file_path));
+            mime_type = mime;
+        }
+    }
+
+    int accepted = compress_accepted(req->http.headers[HTTP_HDR_ACCEPT_ENCODING]);
+    int fd;
+    content_encoding_t enc = ENC_IDENTITY;
+    res->encoding = NULL;
+    res->vary = 0;
+    res->extra[0] = '\0';
+    if (!found) {
+        set_error_response(res, HTTP_404);
+        tslog_infof(server.logger, "[RES #%d] 404 Not Found - %s", req->id, file_path);
+    } else if (S_ISREG(st.st_mode) && st.st_size >= server.sendfile_threshold &&
+               ((fd = open_sibling(file_path, accepted, res, &st, &enc)) >= 0 ||
+                (fd = open(file_path, O_RDONLY | O_CLOEXEC)) >= 0)) {
+        // Arquivo grande: não passa pela memória, o kernel copia direto para o socket
+        file_meta_t meta;
+        file_meta_init(&meta, &st); // do irmão .gz/.br quando é ele que vai
+        file_meta_headers(res->extra, sizeof(res->extra), &meta, enc, cache_control_for(file_path));
+        res->status = "200 OK";
+        res->mime_type = mime_type;
+        res->body = NULL;
+        res->body_len = st.st_size;
+        res->owned = NULL;
+        res->header = NULL;
+        res->cached = NULL;
+        res->bundle = NULL;
+        res->file_fd = fd;
+        res->file_offset = 0;
+        res->multipart = NULL;
+        if (compress_mime(mime_type)) res->vary = 1;
+        if (http_not_modified(&req->http, &meta, enc)) set_not_modified(res);
+        else response_apply_range(&req->http, &meta, enc, res);
+        stats_time(STAT_FILE_READ, stats_now_ns() - started);
+        tslog_infof(server.logger, "[RES #%d] %s - %s (sendfile%s%s)", req->id, res->status, file_path,
+                    res->encoding ? ", " : "", res->encoding ? res->encoding : "");
+    } else {
+        long file_size;
+        char* file_content = read_file(file_path, &file_size);
+
+        if (file_content) {
+            file_variants_t variants = { .body = { file_content }, .len = { file_size } };
+            file_meta_init(&variants.meta, &st);
+            variants.cache_control = cache_control_for(file_path);
+            // Sem cache a compressão seria refeita a cada pedido: não vale
+            file_variants_load(file_path, mime_type, file_cache_accepts(file_path, file_size), &variants);
+            stats_time(STAT_FILE_READ, stats_now_ns() - started);
+            file_cache_put(file_path, &variants, mime_type, generation, &req->http, res);
+            tslog_infof(server.logger, "[RES #%d] %s - %s%s%s%s", req->id, res->status, file_path,
+                        res->encoding ? " (" : "", res->encoding ? res->encoding : "",
+                        res->encoding ? ")" : "");
+        } else {
+            stats_time(STAT_FILE_READ, stats_now_ns() - started);
+            set_error_response(res, HTTP_500);
+            tslog_errorf(server.logger, "[RES #%d] 500 Server Error - %s", req->id, file_path);
+        }
+    }
+}
+
+// Espera o socket ficar pronto para events, acordando para ver g_running.
+// Sem prazo aqui: o shutdown de um prazo vencido acorda o poll
+static int wait_socket(int fd, short events) {
+    struct pollfd pfd = { .fd = fd, .events = events };
+    while (g_running) {
+        int r = poll(&pfd, 1, 500);
+        if (r > 0) return 1;
+        if (r < 0 && errno != EINTR) return -1;
+    }
+    return 0;
+}
+
+// Lida com a conexão de um único cliente: com keep-alive atende vários
+// pedidos em sequência, inclusive os que chegaram juntos (pipelining).
+void handle_client_request(request_t *req) {
+    char *buffer = slab_alloc(server.buffer_slab);
+    size_t len = 0;
+    int served = 0;
+    socket_deadline_t deadline = { .fd = req->socket };
+    if (!buffer) goto cleanup;
+
+    // Não bloqueante: toda espera passa pelo poll de wait_socket
+    int flags = fcntl(req->socket, F_GETFL, 0);
+    if (flags >= 0) fcntl(req->socket, F_SETFL, flags | O_NONBLOCK);
+    socket_deadline_arm(&deadline, DEADLINE_HEADER);
+
+    http_parser_init(&req->http, BUFFER_SIZE - 1);
+    for (;;) {
+        http_parse_result_t result;
+        for (;;) {
+            long long started = stats_now_ns();
+            result = http_parse(&req->http, buffer, len);
+            req->parse_ns += stats_now_ns() - started;
+            if (result != HTTP_PARSE_AGAIN) break;
+            if (wait_socket(req->socket, POLLIN) <= 0) goto cleanup;
+            ssize_t bytes = recv(req->socket, buffer + len, BUFFER_SIZE - 1 - len, 0);
+            if (bytes < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+            if (bytes <= 0) goto cleanup;
+            // Primeiro byte do próximo pedido: prazo do cabeçalho, sem renovar a cada byte
+            if (len == 0 && deadline.kind == DEADLINE_IDLE) socket_deadline_arm(&deadline, DEADLINE_HEADER);
+            len += bytes;
+        }
+        // Pedido completo: o disco não tem prazo
+        socket_deadline_cancel(&deadline);
+
+        response_t res;
+        res.arena = &req->arena;
+        if (begin_request(req, result, len, &res) == 0) {
+            build_response(req, &res);
+        }
+
+        served++;
+        res.keep_alive = req->keep_alive && !req->single &&
+                         (server.max_requests == 0 || served < server.max_requests);
+        char header[RESPONSE_HEADER_MAX];
+        size_t sent = 0;
+        response_prepare(&res, header, sizeof(header));
+        long long started = stats_now_ns();
+        size_t progress = (size_t)-1;
+        int status;
+        while ((status = response_send(req->socket, &res, &sent)) == 1) {
+            // Cliente não está lendo: o prazo de escrita conta desde o último byte aceito
+            if (sent != progress) socket_deadline_arm(&deadline, DEADLINE_WRITE);
+            progress = sent;
+            if (wait_socket(req->socket, POLLOUT) <= 0) {
+                status = -1;
+                break;
+            }
+        }
+        stats_time(STAT_SEND, stats_now_ns() - started);
+        stats_response(res.status, sent);
+        response_free(&res);
+        if (status != 0 || !res.keep_alive) break;
+
+        // Próximo pedido: o que sobrou no buffer já pode ser ele
+        memmove(buffer, buffer + req->length, len - req->length);
+        len -= req->length;
+        req->id = get_next_request_id();
+        http_parser_init(&req->http, BUFFER_SIZE - 1);
+        socket_deadline_arm(&deadline, len ? DEADLINE_HEADER : DEADLINE_IDLE);
+    }
+
+cleanup:
+    socket_deadline_cancel(&deadline); // antes do close: o fd não pode ser reusado sob o prazo
+    close(req->socket);
+    slab_free(server.buffer_slab, buffer);
+    request_free(req);
+}
+
+// Trabalho de um worker do pool para um pedido tirado da fila
+void process_request(request_t *req) {
+    // Sobrecarga: quem já esperou demais leva 503 agora em vez de ser
+    // atendido atrasado, e a fila esvazia
+    int shed = admission_dequeue(req->wait_us);
+    if (shed) stats_shed(SHED_QUEUE_DELAY);
+    if (req->conn) {
+        // Modo epoll: só a parte bloqueante; o loop dono envia a resposta
+        if (shed) {
+            set_error_response(&req->res, HTTP_503);
+            req->keep_alive = 0;
+        } else {
+            build_response(req, &req->res);
+        }
+        event_loop_complete(req->conn);
+    } else if (shed) {
+        reject_overloaded(req);
+    } else {
+        handle_client_request(req);
+    }
+}
+
+// Modo threads: conexão recusada antes de ler o pedido. 503 com
+// Retry-After e fecha
+void reject_overloaded(request_t *req) {
+    response_t res;
+    size_t sent = 0;
+    set_error_response(&res, HTTP_503);
+    res.keep_alive = 0;
+    response_send(req->socket, &res, &sent);
+    stats_response(res.status, sent);
+    // Fechar com o pedido ainda não lido no buffer manda RST, e o cliente
+    // pode perder o 503: descarta o que já chegou (até 64K)
+    char discard[4096];
+    shutdown(req->socket, SHUT_WR);
+    for (int i = 0; i < 16 && recv(req->socket, discard, sizeof(discard), MSG_DONTWAIT) > 0; i++) {}
+    close(req->socket);
+    request_free(req);
+}
+
+// Função para obter próximo request_id de forma thread-safe
+int get_next_request_id() {
+    int id = atomic_fetch_add_explicit(&server.request_id, 1, memory_order_relaxed) + 1;
+    return id;
+}
+
+// Pedido de uma conexão aceita nos modos threads e reuseport
+request_t *request_new(int socket) {
+    request_t *req = slab_alloc(server.request_slab);
+    if (!req) return NULL;
+    memset(req, 0, sizeof(*req));
+    req->socket = socket;
+    req->id = get_next_request_id();
+    req->client = client_address(socket);
+    return req;
+}
+
+void request_free(request_t *req) {
+    slab_free(server.request_slab, req);
+}
+
+// Libera um pedido que ficou na fila no encerramento
+static void drop_queued(request_t *req) {
+    if (!req->conn) { // pedidos do modo epoll pertencem à conexão
+        close(req->socket);
+        request_free(req);
+    }
+}
+
+// Converte "10M", "512K", "1G" ou bytes simples
+static long long parse_size(const char *text) {
+    char *end;
+    long long value = strtoll(text, &end, 10);
+    if (end == text || value < 0) return -1;
+    switch (*end) {
+    case 'k': case 'K': value <<= 10; end++; break;
+    case 'm': case 'M': value <<= 20; end++; break;
+    case 'g': case 'G': value <<= 30; end++; break;
+    }
+    return *end ? -1 : value;
+}
+
+// Procura --config ARQ / --config=ARQ antes do getopt: o arquivo vem
+// primeiro para que a linha de comando possa sobrescrevê-lo
+static const char *find_config_arg(int argc, char *argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--config") == 0 && i + 1 < argc) return argv[i + 1];
+        if (strncmp(argv[i], "--config=", 9) == 0) return argv[i] + 9;
+    }
+    return NULL;
+}
+
+// Lê um arquivo de configuração com uma opção longa por linha
+// ("workers-max = 64", "pin", "# comentário") e devolve um argv
+// equivalente: argv[0], as opções do arquivo e depois as da linha de comando.
+static char **load_config(const char *path, const struct option *opts,
+                          int argc, char *argv[], int *out_argc) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Erro ao abrir %s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    size_t cap = argc + 16, count = 0;
+    char **args = malloc(cap * sizeof(char *));
+    char line[512];
+    int line_no = 0, ok = args != NULL;
+    if (ok) args[count++] = argv[0];
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_no++;
+        char *key = line + strspn(line, " \t");
+        char *end = key + strcspn(key, "#\r\n");
+        while (end > key && (end[-1] == ' ' || end[-1] == '\t')) end--;
+        *end = '\0';
+        if (!*key) continue;
+
+        // Nome, depois '=' ou espaço, depois o valor
+        char *value = key + strcspn(key, " \t=");
+        if (*value) {
+            *value++ = '\0';
+            value += strspn(value, " \t=");
+        }
+
+        const struct option *o = opts;
+        while (o->name && strcmp(o->name, key) != 0) o++;
+        if (!o->name || strcmp(key, "config") == 0) {
+            fprintf(stderr, "%s:%d: opcao desconhecida: %s\n", path, line_no, key);
+            ok = 0;
+            break;
+        }
+        if (o->has_arg == no_argument && *value && strcmp(value, "yes") != 0 &&
+            strcmp(value, "true") != 0 && strcmp(value, "1") != 0) {
+            continue; // "pin = no"
+        }
+        if (o->has_arg == required_argument && !*value) {
+            fprintf(stderr, "%s:%d: %s precisa de um valor\n", path, line_no, key);
+            ok = 0;
+            break;
+        }
+
+        if (count + 2 + argc >= cap) {
+            cap *= 2;
+            char **grown = realloc(args, cap * sizeof(char *));
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            args = grown;
+        }
+        size_t klen = strlen(key);
+        char *flag = malloc(klen + 3);
+        if (!flag) {
+            ok = 0;
+            break;
+        }
+        memcpy(flag, "--", 2);
+        memcpy(flag + 2, key, klen + 1);
+        args[count++] = flag;
+        if (o->has_arg == required_argument) {
+            if (!(args[count++] = strdup(value))) ok = 0;
+        }
+    }
+    fclose(file);
+
+    if (!ok) {
+        if (args) {
+            for (size_t i = 1; i < count; i++) free(args[i]);
+            free(args);
+        }
+        return NULL;
+    }
+    for (int i = 1; i < argc; i++) args[count++] = argv[i];
+    args[count] = NULL;
+    *out_argc = (int)count;
+    return args;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Uso: %s [opcoes] [porta]\n"
+            "  -p, --port N          porta de escuta (padrao %d; 0 = porta livre escolhida pelo kernel)\n"
+            "  -m, --mode MODO       threads (accept + fila, padrao), epoll, reuseport ou uring\n"
+            "                        (uring sem suporte no kernel cai para epoll)\n"
+            "      --root DIR        diretorio servido (padrao www)\n"
+            "      --pack ARQ        empacota --root em ARQ (bundle mapeado com --bundle) e sai\n"
+            "      --bundle ARQ      serve do bundle ARQ em vez de --root; SIGHUP remapeia apos trocar o arquivo\n"
+            "      --config ARQ      le opcoes de ARQ (uma por linha: \"workers-max = 64\"); a linha de comando sobrescreve\n"
+            "      --workers-min N   workers sempre ativos (padrao %d)\n"
+            "      --workers-max N   limite de workers quando a fila demora (padrao %d)\n"
+            "      --queue-size N    pedidos esperando na fila antes do 503 (padrao %d)\n"
+            "      --queue-wait-target MS  cresce o pool se a espera na fila passar de MS (padrao 50)\n"
+            "      --shed-target MS  espera na fila acima de MS por --shed-interval e sobrecarga: quem\n"
+            "                        esperou mais que MS leva 503 (0 desliga, padrao 100)\n"
+            "      --shed-interval MS  duracao da espera alta que caracteriza sobrecarga (padrao 500)\n"
+            "      --rate-limit N    pedidos por segundo por IP; acima disso 429 (0 = sem limite, padrao)\n"
+            "      --rate-burst N    rajada permitida por IP (padrao: --rate-limit)\n"
+            "      --worker-idle S   worker ocioso por S segundos sai, acima do minimo (padrao 30)\n"
+            "      --queue TIPO      fila dos workers: mutex (padrao) ou ring (sem lock)\n"
+            "      --cache-size N    memoria do cache de arquivos (aceita K, M, G; 0 desliga; padrao 64M)\n"
+            "      --sendfile-threshold N  arquivos a partir de N bytes vao por sendfile (padrao 256K)\n"
+            "      --compress-min-size N  comprime (gzip/br) textos a partir de N bytes ao guardar no cache (padrao 1K)\n"
+            "      --no-compress     nao comprime; irmaos .gz/.br em www/ continuam valendo\n"
+            "      --cache-control PREFIXO=VALOR  Cache-Control dos arquivos sob PREFIXO (repetivel; vale o maior prefixo)\n"
+            "      --loops N         threads de event loop nos modos epoll e uring (padrao: CPUs)\n"
+            "      --listeners N     sockets SO_REUSEPORT no modo reuseport (padrao: CPUs)\n"
+            "      --pin             fixa cada listener em uma CPU (modo reuseport)\n"
+            "      --keepalive-timeout S  fecha conexoes ociosas apos S segundos (0 = sem keep-alive, padrao 5)\n"
+            "      --header-timeout S     fecha quem nao termina o pedido em S segundos desde o 1o byte (0 = sem limite, padrao 10)\n"
+            "      --write-timeout S      fecha quem fica S segundos sem ler a resposta (0 = sem limite, padrao 30)\n"
+            "      --max-requests N  requisicoes por conexao (0 = sem limite, padrao 100)\n"
+            "  -l, --log-level NIVEL debug, info, warn, error ou off (padrao info)\n"
+            "      --log-file ARQ    arquivo de log (padrao web_server.log)\n"
+            "      --log-format FMT  text ou binary (decodifique com tslog_decode)\n"
+            "      --log-rotate-size N   rotaciona o log ao atingir N bytes (aceita K, M, G)\n"
+            "      --log-rotate-interval S  rotaciona o log a cada S segundos\n"
+            "      --log-keep N      mantem so os N logs rotacionados mais recentes\n"
+            "      --log-gzip        comprime os logs rotacionados em segundo plano\n"
+            "  -h, --help            mostra esta ajuda\n",
+            prog, DEFAULT_PORT, THREAD_POOL_SIZE, MAX_POOL_SIZE, MAX_QUEUE_SIZE);
+}
+
+// Função principal que inicializa e executa o servidor.
+int main(int argc, char *argv[]) {
+    int port = DEFAULT_PORT;
+    int log_level = LOG_INFO;
+    const char *log_file = "web_server.log";
+    tslog_format_t log_format = TSLOG_FORMAT_TEXT;
+    long long rotate_bytes = 0;
+    int rotate_seconds = 0, rotate_keep = 0, rotate_gzip = 0;
+    server_mode_t mode = MODE_THREADS;
+    server.keepalive_timeout = 5;
+    server.header_timeout = 10;
+    server.write_timeout = 30;
+    server.max_requests = 100;
+    server.sendfile_threshold = 256 << 10;
+    server.root = "www";
+    server.compress = 1;
+    server.compress_min = 1024;
+    int loops = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int listeners = loops, pin = 0;
+    long long cache_size = 64LL << 20;
+    const char *pack_file = NULL, *bundle_file = NULL;
+    queue_kind_t queue_kind = QUEUE_MUTEX;
+    int queue_size = MAX_QUEUE_SIZE;
+    pool_config_t pool = {
+        .min_workers = THREAD_POOL_SIZE,
+        .max_workers = MAX_POOL_SIZE,
+        .wait_target_ms = 50,
+        .idle_timeout_ms = 30 * 1000,
+    };
+    admission_config_t admission = {
+        .target_ms = 100,
+        .interval_ms = 500,
+    };
+
+    static const struct option long_opts[] = {
+        {"port", required_argument, NULL, 'p'},
+        {"mode", required_argument, NULL, 'm'},
+        {"root", required_argument, NULL, 'r'},
+        {"pack", required_argument, NULL, 'k'},
+        {"bundle", required_argument, NULL, 'U'},
+        {"loops", required_argument, NULL, 'L'},
+        {"listeners", required_argument, NULL, 'N'},
+        {"pin", no_argument, NULL, 'P'},
+        {"config", required_argument, NULL, 'c'},
+        {"workers-min", required_argument, NULL, 'n'},
+        {"workers-max", required_argument, NULL, 'x'},
+        {"queue-size", required_argument, NULL, 'D'},
+        {"queue-wait-target", required_argument, NULL, 'G'},
+        {"worker-idle", required_argument, NULL, 'O'},
+        {"shed-target", required_argument, NULL, 'J'},
+        {"shed-interval", required_argument, NULL, 'V'},
+        {"rate-limit", required_argument, NULL, 'X'},
+        {"rate-burst", required_argument, NULL, 'Y'},
+        {"queue", required_argument, NULL, 'W'},
+        {"cache-size", required_argument, NULL, 'C'},
+        {"sendfile-threshold", required_argument, NULL, 'S'},
+        {"compress-min-size", required_argument, NULL, 'M'},
+        {"no-compress", no_argument, NULL, 'E'},
+        {"cache-control", required_argument, NULL, 'A'},
+        {"keepalive-timeout", required_argument, NULL, 'T'},
+        {"header-timeout", required_argument, NULL, 'H'},
+        {"write-timeout", required_argument, NULL, 'w'},
+        {"max-requests", required_argument, NULL, 'Q'},
+        {"log-level", required_argument, NULL, 'l'},
+        {"log-file", required_argument, NULL, 'F'},
+        {"log-format", required_argument, NULL, 'B'},
+        {"log-rotate-size", required_argument, NULL, 'R'},
+        {"log-rotate-interval", required_argument, NULL, 'I'},
+        {"log-keep", required_argument, NULL, 'K'},
+        {"log-gzip", no_argument, NULL, 'Z'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    // O argv montado a partir do arquivo vive até o fim do processo, como o
+    // original (log_file e outros guardam ponteiros para ele)
+    const char *config_file = find_config_arg(argc, argv);
+    if (config_file) {
+        argv = load_config(config_file, long_opts, argc, argv, &argc);
+        if (!argv) return 1;
+    }
+
+    int opt_c;
+    while ((opt_c = getopt_long(argc, argv, "p:m:l:h", long_opts, NULL)) != -1) {
+        switch (opt_c) {
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'm':
+            if (strcmp(optarg, "epoll") == 0) {
+                mode = MODE_EPOLL;
+            } else if (strcmp(optarg, "reuseport") == 0) {
+                mode = MODE_REUSEPORT;
+            } else if (strcmp(optarg, "uring") == 0) {
+                mode = MODE_URING;
+            } else if (strcmp(optarg, "threads") == 0) {
+                mode = MODE_THREADS;
+            } else {
+                fprintf(stderr, "Modo invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            server.root = optarg;
+            break;
+        case 'k':
+            pack_file = optarg;
+            break;
+        case 'U':
+            bundle_file = optarg;
+            break;
+        case 'L':
+            loops = atoi(optarg);
+            if (loops < 1) {
+                fprintf(stderr, "Numero de loops invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'N':
+            listeners = atoi(optarg);
+            if (listeners < 1) {
+                fprintf(stderr, "Numero de listeners invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'P':
+            pin = 1;
+            break;
+        case 'c':
+            break; // já lido por load_config
+        case 'n':
+            pool.min_workers = atoi(optarg);
+            if (pool.min_workers < 1) {
+                fprintf(stderr, "Numero de workers invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'x':
+            pool.max_workers = atoi(optarg);
+            if (pool.max_workers < 1) {
+                fprintf(stderr, "Numero de workers invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'D':
+            queue_size = atoi(optarg);
+            if (queue_size < 1) {
+                fprintf(stderr, "Tamanho de fila invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'G':
+            pool.wait_target_ms = atoi(optarg);
+            break;
+        case 'O':
+            pool.idle_timeout_ms = atoi(optarg) * 1000;
+            break;
+        case 'J':
+            admission.target_ms = atoi(optarg);
+            break;
+        case 'V':
+            admission.interval_ms = atoi(optarg);
+            break;
+        case 'X':
+            admission.rate = atof(optarg);
+            break;
+        case 'Y':
+            admission.burst = atof(optarg);
+            break;
+        case 'W':
+            if (strcmp(optarg, "ring") == 0) {
+                queue_kind = QUEUE_RING;
+            } else if (strcmp(optarg, "mutex") == 0) {
+                queue_kind = QUEUE_MUTEX;
+            } else {
+                fprintf(stderr, "Fila invalida: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'C':
+            cache_size = parse_size(optarg);
+            if (cache_size < 0) {
+                fprintf(stderr, "Tamanho invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'S':
+            server.sendfile_threshold = (long)parse_size(optarg);
+            if (server.sendfile_threshold < 0) {
+                fprintf(stderr, "Tamanho invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'M': {
+            long long min = parse_size(optarg);
+            if (min < 0) {
+                fprintf(stderr, "Tamanho invalido: %s\n", optarg);
+                return 1;
+            }
+            server.compress_min = (size_t)min;
+            break;
+        }
+        case 'E':
+            server.compress = 0;
+            break;
+        case 'A':
+            if (add_cache_rule(optarg) != 0) {
+                fprintf(stderr, "Regra de Cache-Control invalida: %s (use /prefixo=valor)\n", optarg);
+                return 1;
+            }
+            break;
+        case 'T':
+            server.keepalive_timeout = atoi(optarg);
+            break;
+        case 'H':
+            server.header_timeout = atoi(optarg);
+            break;
+        case 'w':
+            server.write_timeout = atoi(optarg);
+            break;
+        case 'Q':
+            server.max_requests = atoi(optarg);
+            break;
+        case 'l':
+            log_level = tslog_parse_level(optarg);
+            if (log_level < 0) {
+                fprintf(stderr, "Nivel de log invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'F':
+            log_file = optarg;
+            break;
+        case 'B':
+            if (strcmp(optarg, "binary") == 0) {
+                log_format = TSLOG_FORMAT_BINARY;
+            } else if (strcmp(optarg, "text") == 0) {
+                log_format = TSLOG_FORMAT_TEXT;
+            } else {
+                fprintf(stderr, "Formato de log invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'R':
+            rotate_bytes = parse_size(optarg);
+            if (rotate_bytes < 0) {
+                fprintf(stderr, "Tamanho invalido: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'I':
+            rotate_seconds = atoi(optarg);
+            break;
+        case 'K':
+            rotate_keep = atoi(optarg);
+            break;
+        case 'Z':
+            rotate_gzip = 1;
+            break;
+        default:
+            print_usage(argv[0]);
+            return opt_c == 'h' ? 0 : 1;
+        }
+    }
+    // Compatibilidade: porta como argumento posicional
+    if (optind < argc) port = atoi(argv[optind]);
+    if (pool.max_workers < pool.min_workers) pool.max_workers = pool.min_workers;
+    if (pool.idle_timeout_ms <= 0) pool.idle_timeout_ms = -1; // nunca encolhe
+    router_init();
+    if (pack_file) return bundle_pack(server.root, pack_file) < 0;
+    
+    signal(SIGINT, handle_sigint);
+    signal(SIGPIPE, SIG_IGN); // cliente que fecha cedo não derruba o servidor
+
+    // Sem io_uring utilizável (kernel antigo ou bloqueado) os mesmos loops usam epoll
+    const char *uring_missing = NULL;
+    if (mode == MODE_URING && !uring_supported()) {
+        uring_missing = strerror(errno);
+        mode = MODE_EPOLL;
+    }
+    int event_mode = mode == MODE_EPOLL || mode == MODE_URING;
+    
+    printf("=== SERVIDOR WEB HTTP (em C) ===\n");
+    printf("Porta: %d\n", port);
+    if (bundle_file) printf("Bundle: %s\n", bundle_file);
+    else printf("Diretorio raiz: %s/\n", server.root);
+    static const char *mode_names[] = { "threads", "epoll", "reuseport", "uring" };
+    printf("Modo: %s%s\n", mode_names[mode], uring_missing ? " (io_uring indisponivel)" : "");
+    if (event_mode) printf("Event loops: %d\n", loops);
+    if (mode == MODE_REUSEPORT) {
+        printf("Listeners SO_REUSEPORT: %d%s\n", listeners, pin ? " (fixados por CPU)" : "");
+    } else {
+        if (pool.max_workers > pool.min_workers) {
+            printf("Pool de threads: %d a %d workers (cresce se a fila passar de %dms)\n",
+                   pool.min_workers, pool.max_workers, pool.wait_target_ms);
+        } else {
+            printf("Pool de threads: %d workers\n", pool.min_workers);
+        }
+        printf("Fila maxima: %d conexoes (%s)\n", queue_size, work_queue_kind_name(queue_kind));
+        if (admission.target_ms > 0) {
+            printf("Descarte: 503 para quem espera mais de %dms na fila em sobrecarga (%dms acima do alvo)\n",
+                   admission.target_ms, admission.interval_ms);
+        }
+    }
+    if (cache_size > 0 && !bundle_file) printf("Cache de arquivos: %lld bytes\n", cache_size);
+    if (server.compress && cache_size > 0 && !bundle_file) {
+        printf("Compressao: %s a partir de %zu bytes\n",
+               compress_available(ENC_BR) ? "gzip e br" : "gzip", server.compress_min);
+    }
+    if (admission.rate > 0) {
+        printf("Limite por IP: %g pedidos/s, rajada de %g\n", admission.rate,
+               admission.burst > 0 ? admission.burst : admission.rate);
+    }
+    if (server.keepalive_timeout > 0) {
+        printf("Keep-alive: %ds ocioso, %d requisicoes por conexao\n",
+               server.keepalive_timeout, server.max_requests);
+    } else {
+        printf("Keep-alive: desligado\n");
+    }
+    printf("================================\n\n");
+    
+    // Logger assíncrono: workers só copiam a mensagem para o ring
+    tslog_options_t log_opts;
+    tslog_options_default(&log_opts);
+    log_opts.async = 1;
+    log_opts.overflow = TSLOG_OVERFLOW_COUNT;
+    log_opts.min_level = log_level;
+    log_opts.format = log_format;
+    log_opts.rotate_bytes = (size_t)rotate_bytes;
+    log_opts.rotate_seconds = rotate_seconds;
+    log_opts.rotate_keep = rotate_keep;
+    log_opts.rotate_gzip = rotate_gzip;
+    server.logger = tslog_init_ex(log_file, &log_opts);
+    if (!server.logger) {
+        fprintf(stderr, "Erro ao abrir %s\n", log_file);
+        return 1;
+    }
+    signal(SIGHUP, handle_sighup);
+    stats_init();
+    admission_init(&admission);
+    register_routes();
+    slab_init();
+    server.request_slab = slab_create("request", sizeof(request_t));
+    server.buffer_slab = slab_create("buffer", BUFFER_SIZE);
+    atomic_init(&server.request_id, 0);
+    
+    // Inicializa fila de trabalho
+    server.work_queue = work_queue_init(queue_kind, queue_size);
+    if (!server.work_queue) {
+        fprintf(stderr, "Erro ao criar fila de trabalho\n");
+        return 1;
+    }
+    
+    render_error_responses();
+    tslog_info(server.logger, "=== Servidor iniciado ===");
+    if (uring_missing) tslog_warnf(server.logger, "io_uring indisponivel (%s): usando epoll", uring_missing);
+    if (bundle_file) {
+        // Tudo vem do arquivo mapeado: o cache e o inotify de --root ficam desligados
+        if (bundle_open(bundle_file) < 0) {
+            fprintf(stderr, "Erro ao abrir o bundle %s: %s\n", bundle_file, strerror(errno));
+            return 1;
+        }
+    } else {
+        file_cache_init((size_t)cache_size, server.root);
+    }
+    // Modos com sockets bloqueantes nos workers/listeners: prazos numa roda
+    // compartilhada (o modo epoll tem uma por loop)
+    if (!event_mode && socket_deadlines_start() < 0) {
+        fprintf(stderr, "Erro ao iniciar os prazos das conexoes\n");
+        return 1;
+    }
+    
+    // Cria pool de threads (o modo reuseport atende nas próprias threads)
+    if (mode != MODE_REUSEPORT) {
+        tslog_infof(server.logger, "Criando pool com %d threads (maximo %d)...",
+                    pool.min_workers, pool.max_workers);
+        if (worker_pool_start(&pool) < 0) {
+            fprintf(stderr, "Erro ao criar threads do pool\n");
+            return 1;
+        }
+    }
+    
+    int server_socket = -1;
+    if (mode == MODE_REUSEPORT) {
+        // Cada listener abre o próprio socket na porta
+        port = reuseport_start(port, listeners, pin);
+        if (port < 0) {
+            g_running = 0;
+        }
+    } else {
+        server_socket = socket(AF_INET, SOCK_STREAM, 0);
+        int opt = 1;
+        setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        
+        struct sockaddr_in server_addr = {0};
+        server_addr.sin_family = AF_INET;
+        server_addr.sin_addr.s_addr = INADDR_ANY;
+        server_addr.sin_port = htons(port);
+        
+        if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
+            tslog_errorf(server.logger, "Erro no bind porta %d: %s", port, strerror(errno));
+            return 1;
+        }
+        
+        if (listen(server_socket, event_mode ? SOMAXCONN : MAX_PENDING) < 0) {
+            tslog_errorf(server.logger, "Erro no listen: %s", strerror(errno));
+            return 1;
+        }
+        
+        // Porta 0: o kernel escolheu uma livre
+        socklen_t addr_len = sizeof(server_addr);
+        getsockname(server_socket, (struct sockaddr*)&server_addr, &addr_len);
+        port = ntohs(server_addr.sin_port);
+    }
+    
+    tslog_infof(server.logger, "Escutando em http://localhost:%d", port);
+    // Na saída padrão também: quem iniciou com porta 0 (make bench) lê daqui
+    printf("Escutando em http://localhost:%d\n", port);
+    printf("Pressione Ctrl+C para encerrar\n\n");
+    fflush(stdout);
+    
+    if (mode == MODE_REUSEPORT) {
+        reuseport_join();
+    } else if (event_mode) {
+        // Muitas conexões simultâneas: sobe o limite de descritores até o máximo
+        struct rlimit rl;
+        if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+            rl.rlim_cur = rl.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &rl);
+        }
+        if (event_loop_start(server_socket, loops, mode == MODE_URING) < 0) {
+            tslog_error(server.logger, "Erro ao iniciar os event loops");
+            g_running = 0;
+        }
+        event_loop_join();
+    }
+    
+    while (g_running) {
+        int client_socket = accept(server_socket, NULL, NULL);
+        if (client_socket < 0) {
+            if (errno == EINTR && !g_running) break;
+            continue;
+        }
+        
+        request_t *req = request_new(client_socket);
+        if (!req) {
+            close(client_socket);
+            continue;
+        }
+        
+        // Fila cheia: 503 na hora, sem parar o accept esperando vaga
+        if (work_queue_try_push(server.work_queue, req) < 0) {
+            stats_shed(SHED_QUEUE_FULL);
+            reject_overloaded(req);
+            tslog_warn(server.logger, "Fila de trabalho cheia - conexao rejeitada");
+        }
+    }
+    
+    tslog_info(server.logger, "=== Servidor finalizando... ===");
+    
+    // Sinaliza threads para parar
+    work_queue_shutdown(server.work_queue);
+    
+    // Aguarda threads terminarem
+    if (mode != MODE_REUSEPORT) worker_pool_stop();
+    
+    if (event_mode) event_loop_destroy();
+    if (mode == MODE_REUSEPORT) reuseport_destroy();
+    socket_deadlines_stop();
+    if (server_socket >= 0) close(server_socket);
+    file_cache_destroy();
+    bundle_close();
+    work_queue_destroy(server.work_queue, drop_queued);
+    slab_shutdown();
+    tslog_destroy(server.logger);
+    printf("\nServidor encerrado.\n");
+    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,462 @@
+#ifndef WEB_SERVER_H
+#define WEB_SERVER_H
+
+#include "libtslog.h"
+#include "http_parser.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#define BUFFER_SIZE 4096
+#define THREAD_POOL_SIZE 10        // workers mínimos (padrão de --workers-min)
+#define MAX_POOL_SIZE 64           // padrão de --workers-max
+#define MAX_QUEUE_SIZE 100         // padrão de --queue-size
+#define CACHE_LINE 64
+#define MAX_BODY_SIZE (1024 * 1024)   // Content-Length acima disso recebe 413
+#define MAX_CACHE_RULES 32         // --cache-control PREFIXO=VALOR
+#define ROUTE_MAX 24               // rotas registradas (router.c)
+#define EXTRA_HEADERS_MAX 384      // ETag + Last-Modified + Cache-Control + Content-Range
+#define RESPONSE_HEADER_MAX 640    // cabeçalho montado por response_prepare
+#define MAX_RANGES 16              // faixas por Range; acima disso o Range é ignorado
+#define RESPONSE_IOV_MAX 3         // cabeçalho + Connection + corpo em memória
+
+struct conn;
+struct cache_entry;
+struct bundle;
+
+// Content-Encoding das variantes de um arquivo (compress.c)
+typedef enum {
+    ENC_IDENTITY = 0,
+    ENC_GZIP,
+    ENC_BR,
+    ENC_COUNT
+} content_encoding_t;
+
+// Corpo multipart/byteranges: o cabeçalho de cada parte intercalado com a
+// faixa do arquivo (ou do corpo em memória) e o delimitador final
+typedef struct {
+    int count;
+    struct {
+        off_t start, len;
+        size_t head_len;    // cabeçalho da parte dentro de heads
+    } part[MAX_RANGES];
+    char *heads;            // cabeçalhos das partes em sequência, depois o fechamento
+    size_t tail_len;
+    char content_type[96];  // "multipart/byteranges; boundary=..."
+} multipart_t;
+
+// Slabs por thread e arena do pedido (slab.c)
+#define SLAB_MAX 8                 // slabs registrados
+#define ARENA_BLOCK 4096           // bloco da arena do pedido
+
+typedef struct slab slab_t;
+typedef struct arena_block arena_block_t;
+
+// Memória que vive até o fim do pedido: tudo volta de uma vez em arena_reset
+typedef struct {
+    arena_block_t *head;    // bloco em uso (NULL = vazia)
+    size_t used;            // bytes ocupados em head
+} arena_t;
+
+typedef struct {
+    const char *name;
+    size_t size;            // tamanho do objeto (arredondado)
+    unsigned long allocated; // objetos pedidos ao malloc
+    unsigned long released;  // devolvidos ao malloc
+} slab_info_t;
+
+void slab_init(void);
+slab_t *slab_create(const char *name, size_t size); // antes das threads; NULL se já há SLAB_MAX
+void *slab_alloc(slab_t *slab);     // não zera; NULL sem memória
+void slab_free(slab_t *slab, void *ptr); // pode ser de outra thread
+int slab_info(int id, slab_info_t *info); // -1 depois do último
+void slab_shutdown(void);           // com as outras threads encerradas
+void *arena_alloc(arena_t *arena, size_t size); // zerada, alinhada a 16
+void arena_reset(arena_t *arena);
+
+// Resposta pronta para envio; o corpo pode ser estático ou alocado (owned)
+typedef struct {
+    const char *status;     // ex. "200 OK"
+    const char *mime_type;
+    const char *body;
+    long body_len;
+    char *owned;            // liberado por response_free
+    const char *header;     // cabeçalho pronto sem a linha Connection (cache), ou NULL
+    size_t header_len;
+    struct cache_entry *cached; // referência ao cache, devolvida por response_free
+    struct bundle *bundle;  // referência ao bundle mapeado (corpo e cabeçalho), devolvida por response_free
+    int file_fd;            // corpo enviado com sendfile deste arquivo (-1 = usa body)
+    off_t file_offset;      // início da faixa no arquivo (206 com uma faixa)
+    multipart_t *multipart; // 206 com várias faixas de body/file_fd (na arena)
+    const char *encoding;   // Content-Encoding (NULL = identidade)
+    int vary;               // "Vary: Accept-Encoding": o corpo depende da negociação
+    char extra[EXTRA_HEADERS_MAX]; // ETag, Last-Modified, Cache-Control montados (vazio = nenhum)
+    int keep_alive;         // "Connection: keep-alive" em vez de "close"
+    arena_t *arena;         // do pedido, posta pelo dono; response_free a reinicia
+} response_t;
+
+typedef struct {
+    int socket;
+    int id;
+    struct conn *conn;      // modo epoll: conexão dona do pedido (NULL no modo threads)
+    const struct route *route; // rota que casou em begin_request (NULL = nenhuma)
+    uint32_t client;        // IPv4 do cliente para o limite de taxa (0 = sem limite)
+    http_parser_t http;     // método, caminho e cabeçalhos (fatias do buffer de recepção)
+    size_t length;          // bytes do pedido no buffer (cabeçalho + corpo)
+    int keep_alive;         // cliente aceita manter a conexão
+    int single;             // fecha após um pedido: o listener do modo reuseport não pode esperar o próximo
+    long long queued_us;    // quando entrou na fila de trabalho
+    long long wait_us;      // quanto esperou na fila até um worker pegar
+    long long parse_ns;     // tempo somado nas chamadas a http_parse
+    long long send_ns;      // tempo somado nas chamadas a response_send
+    response_t res;         // modo epoll: resposta montada pelo worker
+    arena_t arena;          // alocações que vivem até o fim do pedido
+} request_t;
+
+// Implementação da fila de trabalho (--queue)
+typedef enum {
+    QUEUE_MUTEX = 0,    // vetor circular + mutex + variáveis de condição
+    QUEUE_RING          // anel MPMC sem lock, workers giram e depois dormem num futex
+} queue_kind_t;
+
+typedef struct work_queue work_queue_t;
+
+typedef struct {
+    logger_t *logger;
+    atomic_int request_id;
+    work_queue_t *work_queue;
+    int keepalive_timeout;  // segundos ociosos antes de fechar (0 = sem keep-alive)
+    int max_requests;       // requisições por conexão (0 = sem limite)
+    long sendfile_threshold; // arquivos a partir deste tamanho vão por sendfile
+    const char *root;       // diretório servido (padrão www)
+    int compress;           // comprime ao colocar no cache (irmãos .gz/.br valem sempre)
+    size_t compress_min;    // arquivos menores não são comprimidos
+    int header_timeout;     // segundos para o pedido chegar inteiro desde o 1º byte (0 = sem limite)
+    int write_timeout;      // segundos sem o cliente aceitar nenhum byte da resposta (0 = sem limite)
+    slab_t *request_slab;   // request_t dos modos threads e reuseport
+    slab_t *buffer_slab;    // buffers de recepção (BUFFER_SIZE) dos modos threads e reuseport
+} server_t;
+
+extern server_t server;
+extern volatile sig_atomic_t g_running;
+
+// Fila de trabalho dos workers (work_queue.c)
+work_queue_t* work_queue_init(queue_kind_t kind, int capacity);
+void work_queue_destroy(work_queue_t *queue, void (*drop)(request_t *req)); // drop: pedidos que sobraram
+int work_queue_push(work_queue_t *queue, request_t *req);     // espera até 1s se cheia
+int work_queue_try_push(work_queue_t *queue, request_t *req); // -1 se cheia, sem esperar
+request_t* work_queue_pop(work_queue_t *queue, int timeout_ms); // NULL no encerramento ou timeout (-1 = sem)
+int work_queue_count(work_queue_t *queue);
+void work_queue_shutdown(work_queue_t *queue);                // acorda os workers parados
+const char *work_queue_kind_name(queue_kind_t kind);
+int get_next_request_id(void);
+request_t *request_new(int socket);  // do slab, zerado; NULL sem memória
+void request_free(request_t *req);
+void reject_overloaded(request_t *req); // 503 com Retry-After antes de ler o pedido, fecha e libera
+
+// Métricas por thread somadas na leitura (stats.c)
+typedef enum {
+    STAT_QUEUE_WAIT = 0,    // fila de trabalho até um worker pegar
+    STAT_PARSE,             // http_parse
+    STAT_FILE_READ,         // stat + leitura/abertura do arquivo (falta no cache)
+    STAT_SEND,              // response_send
+    STAT_HIST_COUNT
+} stat_hist_t;
+
+#define STAT_STATUS_COUNT 13    // códigos acompanhados + "outros"
+
+// Prazos de uma conexão; ao vencer ela é fechada e contada
+typedef enum {
+    DEADLINE_HEADER = 0,    // pedido incompleto (slowloris)
+    DEADLINE_IDLE,          // keep-alive sem próximo pedido
+    DEADLINE_WRITE,         // cliente parou de ler a resposta
+    DEADLINE_COUNT
+} deadline_kind_t;
+
+// Pedidos recusados pelo controle de admissão
+typedef enum {
+    SHED_QUEUE_FULL = 0,    // fila de trabalho cheia (503)
+    SHED_QUEUE_DELAY,       // esperou demais na fila durante a sobrecarga (503)
+    SHED_RATE_LIMIT,        // cliente acima da taxa (429)
+    SHED_COUNT
+} shed_reason_t;
+
+void stats_init(void);
+long long stats_now_ns(void);
+void stats_request(void);
+void stats_response(const char *status, size_t bytes);
+void stats_time(stat_hist_t which, long long ns);
+void stats_timeout(deadline_kind_t kind);
+void stats_shed(shed_reason_t reason);
+void stats_alloc(int slab, int freed); // alocação (0) ou liberação (1) num slab
+unsigned long stats_total_requests(void);
+void stats_serve(request_t *req, response_t *res, int prometheus); // handler de /stats e /metrics
+
+// Pool de workers adaptativo (worker_pool.c)
+typedef struct {
+    int min_workers;
+    int max_workers;
+    int wait_target_ms;     // cresce quando a espera na fila passa disso
+    int idle_timeout_ms;    // worker ocioso por mais tempo sai (acima do mínimo)
+} pool_config_t;
+
+int worker_pool_start(const pool_config_t *cfg);
+void worker_pool_stop(void);
+int worker_pool_size(void);
+void process_request(request_t *req); // executado pelos workers (web_server.c)
+
+// Respostas de erro pré-montadas na partida
+typedef enum {
+    HTTP_400 = 0,
+    HTTP_404,
+    HTTP_405,
+    HTTP_413,
+    HTTP_429,
+    HTTP_431,
+    HTTP_500,
+    HTTP_501,
+    HTTP_503,
+    HTTP_ERROR_COUNT
+} http_error_t;
+
+// HTTP (web_server.c)
+// Valida o pedido já analisado por http_parse (buffered = bytes no buffer).
+// Retorna 0 se há arquivo a servir (chamar build_response) ou 1 se res já
+// contém a resposta de erro. Preenche req->length e req->keep_alive.
+int begin_request(request_t *req, http_parse_result_t result, size_t buffered, response_t *res);
+void build_response(request_t *req, response_t *res); // pode bloquear em disco
+void response_free(response_t *res);
+void handle_client_request(request_t *req);
+int serve_cached(request_t *req, response_t *res); // 1 se o arquivo estava no cache
+void render_error_responses(void);
+void set_error_response(response_t *res, http_error_t error);
+char *read_file(const char *path, long *file_size); // malloc com '\0' no fim; NULL se falhou
+// Monta em buf o cabeçalho (sem a linha Connection) se ele não veio pronto
+void response_prepare(response_t *res, char *buf, size_t size);
+// Próximo trecho contíguo da resposta a partir de sent: iovecs em memória ou
+// uma faixa de arquivo (iov_count 0). Base de response_send e do envio pelo
+// io_uring
+typedef struct {
+    struct iovec iov[RESPONSE_IOV_MAX];
+    int iov_count;
+    int file_fd;
+    off_t file_offset;
+    size_t file_len;
+    int more;               // ainda há trecho depois deste (MSG_MORE)
+} response_chunk_t;
+
+int response_chunk(const response_t *res, size_t sent, response_chunk_t *chunk); // 0 = nada falta
+// Envia cabeçalho + Connection + corpo num único sendmsg (e o arquivo por
+// sendfile), continuando de *sent. Retorna 0 quando terminou, 1 se o socket
+// não bloqueante encheu (chamar de novo no EPOLLOUT), -1 em erro.
+int response_send(int sock, const response_t *res, size_t *sent);
+// Envia até count bytes do arquivo a partir de *offset; trata envios parciais e EINTR.
+// Retorna 0 quando tudo foi enviado, 1 se o socket (não bloqueante) encheu, -1 em erro.
+int send_file_body(int sock, int file_fd, off_t *offset, off_t end);
+
+// Tabela de rotas (router.c): registradas antes das threads, só lidas depois
+typedef enum {
+    ROUTE_EXACT = 0,        // o caminho inteiro (sem a query)
+    ROUTE_PREFIX            // caminhos que começam por path, terminado em '/'
+} route_match_t;
+
+typedef void (*route_handler_t)(request_t *req, response_t *res, int arg);
+
+typedef struct route {
+    const char *path;       // "/stats", ou "/static/" num prefixo
+    route_match_t match;
+    route_handler_t handler; // resposta gerada em memória (NULL = arquivo de server.root)
+    int arg;                // repassado ao handler
+    const char *file;       // arquivo fixo servido pela rota, ex. "/" -> "/index.html"
+    const char *suffix;     // acrescentado ao caminho sem extensão, ex. "/about" -> "/about.html"
+    const char *mime_type;  // de file ou suffix, resolvido por route_add
+    size_t len;             // preenchido por route_add
+} route_t;
+
+void router_init(void);    // tabela de extensões; antes de qualquer get_mime_type
+int route_add(const route_t *route); // -1 se a tabela encheu, o caminho é inválido ou repetido
+const route_t *route_find(http_slice_t path); // rota exata ou o prefixo mais longo
+int route_path_safe(http_slice_t path); // 0 se o caminho sairia da raiz (".."), tem '\\' ou segmento vazio
+// Caminho relativo a server.root que o pedido serve, em buf; retorna o MIME,
+// ou NULL se não coube ou não há tentativa attempt (a 1 é o caminho literal
+// quando a 0 acrescentou o sufixo da rota)
+const char *route_target(const request_t *req, int attempt, char *buf, size_t size);
+const char *get_mime_type(const char *path); // pela extensão; octet-stream se desconhecida
+
+// Modo epoll (event_loop.c); com use_uring as mesmas conexões são servidas
+// pelo io_uring em vez do epoll
+int event_loop_start(int listen_fd, int count, int use_uring);
+void event_loop_join(void);    // retorna quando g_running zera
+void event_loop_destroy(void); // depois que os workers terminaram
+void event_loop_complete(struct conn *conn); // chamado pelo worker ao terminar
+
+// io_uring por syscalls diretas, sem liburing (uring.c)
+typedef struct uring uring_t;
+struct msghdr;
+
+typedef struct {
+    unsigned long long data; // user_data da operação
+    int res;
+    int more;               // multishot: a operação continua armada
+    int buffer;             // buffer fornecido que recebeu os dados (-1 = nenhum)
+} uring_cqe_t;
+
+int uring_supported(void); // kernel com tudo que o loop usa (5.19+); errno diz o motivo
+uring_t *uring_create(unsigned entries, unsigned buffers, unsigned buffer_size);
+void uring_destroy(uring_t *ring);
+int uring_reserve(uring_t *ring, unsigned count); // garante count SQEs livres
+int uring_accept_multishot(uring_t *ring, int fd, unsigned long long data);
+int uring_recv(uring_t *ring, int fd, size_t len, unsigned long long data); // num buffer fornecido
+int uring_read(uring_t *ring, int fd, void *buf, size_t len, off_t offset, unsigned long long data);
+int uring_sendmsg(uring_t *ring, int fd, const struct msghdr *msg, int flags, unsigned long long data);
+// Leitura do arquivo encadeada (IOSQE_IO_LINK) ao envio do mesmo buffer
+int uring_read_send(uring_t *ring, int file_fd, off_t offset, int sock, void *buf, size_t len,
+                    int flags, unsigned long long read_data, unsigned long long send_data);
+int uring_wait(uring_t *ring, int timeout_ms); // submete o lote e espera uma conclusão
+int uring_next(uring_t *ring, uring_cqe_t *cqe); // 1 se tirou uma conclusão
+const char *uring_buffer(uring_t *ring, int id);
+void uring_buffer_recycle(uring_t *ring, int id);
+
+// Compressão e negociação de Content-Encoding (compress.c)
+int compress_accepted(http_slice_t accept_encoding); // máscara de 1 << ENC_*, identidade sempre
+const char *compress_name(content_encoding_t enc);  // "gzip", "br" (NULL = identidade)
+const char *compress_suffix(content_encoding_t enc); // ".gz", ".br"
+int compress_mime(const char *mime);                 // 1 se vale comprimir (texto)
+int compress_available(content_encoding_t enc);     // compilado com suporte a comprimir
+// Corpo comprimido (malloc) ou NULL se falhou ou não ficou menor
+char *compress_body(content_encoding_t enc, const char *data, size_t len, size_t *out_len);
+
+// Validadores de um arquivo, tirados do stat (web_server.c)
+typedef struct {
+    char etag[64];          // forte, sem aspas: inode-tamanho-mtime (+ "-gzip"/"-br" por variante)
+    time_t mtime;
+    char last_modified[32]; // mtime como data HTTP
+} file_meta_t;
+
+void file_meta_init(file_meta_t *meta, const struct stat *st);
+// 1 se If-None-Match (ou, na falta dele, If-Modified-Since) diz que o
+// cliente já tem a variante enc desta versão: responder 304
+int http_not_modified(const http_parser_t *http, const file_meta_t *meta, content_encoding_t enc);
+// Linhas ETag, Last-Modified e Cache-Control da variante enc; retorna o tamanho
+size_t file_meta_headers(char *buf, size_t size, const file_meta_t *meta, content_encoding_t enc,
+                         const char *cache_control);
+// Cache-Control configurado para o arquivo (maior prefixo de --cache-control), ou NULL
+const char *cache_control_for(const char *file_path);
+const char *cache_control_rule(const char *rel); // o mesmo para "/caminho" dentro da raiz
+// Cabeçalho pronto de um 200 (ou do 304 correspondente) sem a linha Connection
+size_t format_ready_header(char *buf, size_t size, int not_modified, const char *mime_type, size_t body_len,
+                           content_encoding_t enc, int vary, const file_meta_t *meta, const char *cache_control);
+void set_not_modified(response_t *res); // 304 sem corpo; res->extra já preenchido
+// Range sobre uma resposta 200 completa (corpo em memória ou file_fd, com os
+// validadores em res->extra): vira 206 (uma faixa ou multipart/byteranges) ou
+// 416. Sem Range, If-Range vencido ou Range inválido a resposta fica como está.
+void response_apply_range(const http_parser_t *http, const file_meta_t *meta, content_encoding_t enc,
+                          response_t *res);
+
+// Corpo de um arquivo em cada codificação (NULL = ausente; [ENC_IDENTITY] sempre)
+typedef struct {
+    char *body[ENC_COUNT];
+    size_t len[ENC_COUNT];
+    int vary;               // tipo comprimível ou com variante: responde com Vary
+    file_meta_t meta;
+    const char *cache_control;
+} file_variants_t;
+
+// Preenche as variantes comprimidas de v (body[ENC_IDENTITY] já lido): irmãos
+// .gz/.br ou, com compress, comprimindo agora
+void file_variants_load(const char *file_path, const char *mime_type, int compress, file_variants_t *v);
+
+// Cache de arquivos com invalidação por inotify (file_cache.c)
+int file_cache_init(size_t max_bytes, const char *root); // 0 bytes = desligado
+void file_cache_destroy(void);
+// 1 = acerto; entrega a menor variante que o pedido aceita, ou 304 se o
+// pedido condicional casar com ela
+int file_cache_get(const char *path, const http_parser_t *http, response_t *res);
+unsigned long file_cache_generation(void);
+int file_cache_accepts(const char *path, size_t size); // caberia no cache
+// Assume os corpos (alocados); guarda no cache se couber e nada mudou desde
+// generation. A resposta recebe a menor variante aceita (ou 304).
+void file_cache_put(const char *path, file_variants_t *variants, const char *mime_type,
+                    unsigned long generation, const http_parser_t *http, response_t *res);
+void file_cache_release(struct cache_entry *entry);
+void file_cache_stats(unsigned long *hits, unsigned long *misses, size_t *bytes, unsigned long *entries);
+
+// www/ empacotado num arquivo só, mapeado em memória e indexado por hash
+// perfeito (bundle.c)
+int bundle_pack(const char *root, const char *out_path); // --pack; troca out_path de uma vez
+int bundle_open(const char *path);  // --bundle: mapeia e valida; -1 com a causa em errno
+void bundle_close(void);
+void bundle_request_reload(void);   // SIGHUP: remapeia no próximo pedido
+int bundle_serve(request_t *req, response_t *res); // 0 se não há bundle; senão 200/206/304/404
+void bundle_release(struct bundle *bundle);
+
+// Controle de admissão (admission.c): descarte por espera na fila no
+// estilo CoDel e token bucket por IP do cliente
+typedef struct {
+    int target_ms;          // espera na fila que, mantida por interval_ms, é sobrecarga (0 = desliga)
+    int interval_ms;
+    double rate;            // pedidos por segundo por IP (0 = sem limite)
+    double burst;           // rajada permitida (0 = rate)
+} admission_config_t;
+
+void admission_init(const admission_config_t *cfg); // antes das threads
+// Worker tirou da fila um pedido que esperou wait_us: 1 = responder 503
+int admission_dequeue(long long wait_us);
+int admission_overloaded(void);
+uint32_t client_address(int fd); // getpeername só com limite de taxa; 0 sem ele
+int rate_limit_allow(uint32_t addr); // 0 = acima da taxa (429)
+const char *shed_name(shed_reason_t reason);
+
+// Roda de temporizadores hashed (timer_wheel.c): armar, rearmar e cancelar
+// em O(1); cada volta da roda só olha as listas dos ticks que passaram
+typedef struct timer_node {
+    struct timer_node *prev, *next; // prev NULL = desarmado
+    long long expires_ms;
+} timer_node_t;
+
+typedef struct {
+    timer_node_t *slots;    // listas circulares com sentinela
+    unsigned mask;          // slots - 1 (potência de 2)
+    int tick_ms;
+    long long tick;         // último tick processado
+} timer_wheel_t;
+
+long long timer_now_ms(void); // relógio monotônico
+int timer_wheel_init(timer_wheel_t *wheel, int slots, int tick_ms);
+void timer_wheel_destroy(timer_wheel_t *wheel);
+void timer_wheel_arm(timer_wheel_t *wheel, timer_node_t *timer, long long expires_ms); // rearma se armado
+void timer_wheel_cancel(timer_node_t *timer);
+int timer_armed(const timer_node_t *timer);
+// Desarma e devolve os vencidos até now_ms, encadeados por next
+timer_node_t *timer_wheel_expire(timer_wheel_t *wheel, long long now_ms);
+long deadline_ms(deadline_kind_t kind); // duração configurada (0 = sem prazo)
+const char *deadline_name(deadline_kind_t kind);
+
+// Prazos dos sockets bloqueantes (modos threads e reuseport): uma thread
+// gira a roda e, no vencimento, faz shutdown do socket, o que acorda o
+// poll/send parado do worker com erro
+typedef struct {
+    timer_node_t node;
+    int fd;
+    deadline_kind_t kind;
+} socket_deadline_t;
+
+int socket_deadlines_start(void);
+void socket_deadlines_stop(void);
+void socket_deadline_arm(socket_deadline_t *deadline, deadline_kind_t kind);
+void socket_deadline_cancel(socket_deadline_t *deadline); // antes de fechar o fd
+
+// Modo reuseport (reuseport.c)
+// Retorna a porta de escuta (a escolhida pelo kernel se port = 0) ou -1
+int reuseport_start(int port, int count, int pin);
+void reuseport_join(void);
+void reuseport_destroy(void);
+int reuseport_count(void);
+unsigned long reuseport_accepted(int index);
+
+#endif // WEB_SERVER_H
@@ -0,0 +1,418 @@
+#define _GNU_SOURCE
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+// Fila de trabalho entre quem aceita/lê as conexões e o pool de workers.
+// Duas implementações, escolhidas na partida com --queue:
+// - mutex: vetor circular com um mutex e duas variáveis de condição;
+// - ring: anel MPMC sem lock (algoritmo de Vyukov). Cada posição tem um
+//   número de sequência, então produtores e consumidores só disputam os
+//   contadores head/tail, cada um na sua linha de cache. Worker sem trabalho
+//   gira um pouco e depois dorme num futex; o produtor só faz a syscall de
+//   wake quando há alguém dormindo.
+
+#define SPIN_COUNT 256          // tentativas antes de dormir (0 com uma CPU só)
+#define PARK_TIMEOUT_MS 500     // para perceber o fim de g_running
+#define PUSH_WAIT_MS 1000       // push bloqueante desiste depois disso (503)
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cpu_relax() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define cpu_relax() __asm__ __volatile__("yield")
+#else
+#define cpu_relax() ((void)0)
+#endif
+
+typedef struct {
+    _Atomic size_t seq;
+    request_t *req;
+} ring_slot_t;
+
+struct work_queue {
+    queue_kind_t kind;
+    int capacity;
+    int spin;                   // voltas de espera ativa antes de dormir/ceder
+
+    // mutex
+    request_t **queue;
+    int front;
+    int rear;
+    int count;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+
+    // ring
+    ring_slot_t *slots;
+    _Alignas(CACHE_LINE) _Atomic size_t head;      // próxima posição de push
+    _Alignas(CACHE_LINE) _Atomic size_t tail;      // próxima posição de pop
+    _Alignas(CACHE_LINE) _Atomic uint32_t wake_seq; // palavra do futex
+    _Atomic int sleepers;
+    _Atomic int waking;         // um wake já em andamento
+    _Alignas(CACHE_LINE) _Atomic uint32_t space_seq; // futex de quem espera vaga
+    _Atomic int push_waiters;
+};
+
+const char *work_queue_kind_name(queue_kind_t kind) {
+    return kind == QUEUE_RING ? "ring" : "mutex";
+}
+
+static long futex(_Atomic uint32_t *addr, int op, uint32_t val, const struct timespec *ts) {
+    return syscall(SYS_futex, (uint32_t *)addr, op, val, ts, NULL, 0);
+}
+
+// ======================== MUTEX ========================
+
+static int mutex_push(work_queue_t *queue, request_t *req, int wait) {
+    pthread_mutex_lock(&queue->mutex);
+
+    // Aguarda espaço na fila (com timeout para não bloquear indefinidamente)
+    while (wait && queue->count >= queue->capacity && g_running) {
+        struct timespec timeout;
+        clock_gettime(CLOCK_REALTIME, &timeout);
+        timeout.tv_sec += PUSH_WAIT_MS / 1000;
+
+        int result = pthread_cond_timedwait(&queue->not_full, &queue->mutex, &timeout);
+        if (result == ETIMEDOUT) break;
+    }
+
+    if (queue->count >= queue->capacity || !g_running) {
+        pthread_mutex_unlock(&queue->mutex);
+        return -1; // Fila cheia, rejeita conexão
+    }
+
+    queue->queue[queue->rear] = req;
+    queue->rear = (queue->rear + 1) % queue->capacity;
+    queue->count++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return 0;
+}
+
+static request_t* mutex_pop(work_queue_t *queue, int timeout_ms) {
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+
+    // Aguarda trabalho na fila
+    while (queue->count == 0 && g_running) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&queue->not_empty, &queue->mutex);
+        } else if (pthread_cond_timedwait(&queue->not_empty, &queue->mutex, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+
+    if (queue->count == 0) {
+        pthread_mutex_unlock(&queue->mutex);
+        return NULL;
+    }
+
+    request_t *req = queue->queue[queue->front];
+    queue->front = (queue->front + 1) % queue->capacity;
+    queue->count--;
+
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->mutex);
+
+    return req;
+}
+
+// ======================== RING ========================
+
+// Posição livre tem seq == pos; ocupada tem seq == pos + 1; depois do pop
+// volta a ficar livre para a próxima volta (pos + capacity).
+static int ring_try_push(work_queue_t *queue, request_t *req) {
+    size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    for (;;) {
+        ring_slot_t *slot = &queue->slots[pos % queue->capacity];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                slot->req = req;
+                atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+                return 0;
+            }
+        } else if (diff < 0) {
+            return -1; // cheia
+        } else {
+            pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        }
+    }
+}
+
+static request_t* ring_try_pop(work_queue_t *queue) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    for (;;) {
+        ring_slot_t *slot = &queue->slots[pos % queue->capacity];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+                                                      memory_order_relaxed, memory_order_relaxed)) {
+                request_t *req = slot->req;
+                atomic_store_explicit(&slot->seq, pos + queue->capacity, memory_order_release);
+                return req;
+            }
+        } else if (diff < 0) {
+            return NULL; // vazia
+        } else {
+            pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        }
+    }
+}
+
+// Acorda um worker se algum estiver dormindo. O fence casa com o de
+// ring_pop: ou o worker vê o pedido ao reconferir, ou nós vemos o sleeper.
+// Só um wake fica em voo por vez (waking); quem acordou pega um pedido e,
+// se ainda houver outros, acorda o próximo. Assim uma rajada de pushes não
+// vira uma syscall e uma troca de contexto por pedido.
+static void ring_wake(work_queue_t *queue) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->sleepers, memory_order_relaxed) == 0) return;
+    if (atomic_exchange_explicit(&queue->waking, 1, memory_order_acq_rel)) return;
+    atomic_fetch_add_explicit(&queue->wake_seq, 1, memory_order_release);
+    futex(&queue->wake_seq, FUTEX_WAKE_PRIVATE, 1, NULL);
+}
+
+static int ring_empty(work_queue_t *queue) {
+    size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    ring_slot_t *slot = &queue->slots[pos % queue->capacity];
+    return atomic_load_explicit(&slot->seq, memory_order_acquire) != pos + 1;
+}
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+// Pop liberou uma vaga: acorda um produtor parado com a fila cheia
+static void ring_wake_producer(work_queue_t *queue) {
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&queue->push_waiters, memory_order_relaxed) == 0) return;
+    atomic_fetch_add_explicit(&queue->space_seq, 1, memory_order_release);
+    futex(&queue->space_seq, FUTEX_WAKE_PRIVATE, 1, NULL);
+}
+
+static int ring_push(work_queue_t *queue, request_t *req, int wait) {
+    long deadline = 0;
+    for (int tries = 0; ring_try_push(queue, req) < 0; tries++) {
+        // Cheia: o modo threads espera até PUSH_WAIT_MS antes de responder 503,
+        // primeiro girando, depois dormindo até um pop abrir vaga
+        if (!wait || !g_running) return -1;
+        if (tries < queue->spin) {
+            cpu_relax();
+            continue;
+        }
+        long now = now_ms();
+        if (!deadline) deadline = now + PUSH_WAIT_MS;
+        else if (now >= deadline) return -1;
+
+        uint32_t seq = atomic_load_explicit(&queue->space_seq, memory_order_acquire);
+        atomic_fetch_add_explicit(&queue->push_waiters, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (ring_try_push(queue, req) == 0) {
+            atomic_fetch_sub_explicit(&queue->push_waiters, 1, memory_order_relaxed);
+            break;
+        }
+        long left = deadline - now;
+        struct timespec ts = { left / 1000, (left % 1000) * 1000000L };
+        futex(&queue->space_seq, FUTEX_WAIT_PRIVATE, seq, &ts);
+        atomic_fetch_sub_explicit(&queue->push_waiters, 1, memory_order_relaxed);
+    }
+    ring_wake(queue);
+    return 0;
+}
+
+static request_t* ring_take(work_queue_t *queue) {
+    request_t *req = ring_try_pop(queue);
+    if (req) ring_wake_producer(queue);
+    return req;
+}
+
+static request_t* ring_pop(work_queue_t *queue, int timeout_ms) {
+    long deadline = timeout_ms >= 0 ? now_ms() + timeout_ms : 0;
+    while (g_running) {
+        request_t *req;
+        for (int i = 0; i < queue->spin; i++) {
+            if ((req = ring_take(queue))) return req;
+            cpu_relax();
+        }
+
+        // Anuncia que vai dormir e confere de novo antes de dormir de fato
+        uint32_t seq = atomic_load_explicit(&queue->wake_seq, memory_order_acquire);
+        atomic_fetch_add_explicit(&queue->sleepers, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if ((req = ring_take(queue))) {
+            // O wake em voo pode ter sido para nós: libera o próximo
+            atomic_fetch_sub_explicit(&queue->sleepers, 1, memory_order_relaxed);
+            atomic_store_explicit(&queue->waking, 0, memory_order_seq_cst);
+            return req;
+        }
+        long park_ms = PARK_TIMEOUT_MS;
+        if (timeout_ms >= 0) {
+            long left = deadline - now_ms();
+            if (left <= 0) {
+                atomic_fetch_sub_explicit(&queue->sleepers, 1, memory_order_relaxed);
+                return NULL; // ocioso por timeout_ms
+            }
+            if (left < park_ms) park_ms = left;
+        }
+        struct timespec ts = { park_ms / 1000, (park_ms % 1000) * 1000000L };
+        if (g_running) futex(&queue->wake_seq, FUTEX_WAIT_PRIVATE, seq, &ts);
+        atomic_fetch_sub_explicit(&queue->sleepers, 1, memory_order_relaxed);
+        atomic_store_explicit(&queue->waking, 0, memory_order_seq_cst);
+
+        // Acordado: passa o bastão adiante se a fila ainda tiver trabalho
+        if ((req = ring_take(queue))) {
+            if (!ring_empty(queue)) ring_wake(queue);
+            return req;
+        }
+    }
+    return ring_take(queue); // encerrando: ainda entrega o que sobrou
+}
+
+// ======================== API ========================
+
+work_queue_t* work_queue_init(queue_kind_t kind, int capacity) {
+    if (capacity <= 0) return NULL;
+    work_queue_t *queue = aligned_alloc(CACHE_LINE, sizeof(work_queue_t));
+    if (!queue) return NULL;
+    memset(queue, 0, sizeof(*queue));
+    queue->kind = kind;
+    queue->capacity = capacity;
+    // Girar só ajuda se o produtor roda em outra CPU ao mesmo tempo
+    queue->spin = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SPIN_COUNT : 0;
+
+    if (kind == QUEUE_RING) {
+        queue->slots = calloc(capacity, sizeof(ring_slot_t));
+        if (!queue->slots) {
+            free(queue);
+            return NULL;
+        }
+        for (int i = 0; i < capacity; i++) {
+            atomic_init(&queue->slots[i].seq, (size_t)i);
+        }
+    } else {
+        queue->queue = calloc(capacity, sizeof(request_t *));
+        if (!queue->queue) {
+            free(queue);
+            return NULL;
+        }
+        pthread_mutex_init(&queue->mutex, NULL);
+        pthread_cond_init(&queue->not_empty, NULL);
+        pthread_cond_init(&queue->not_full, NULL);
+    }
+
+    return queue;
+}
+
+// Pedidos que ficaram na fila vão para drop (NULL = só descarta): a fila
+// não sabe liberar um request_t
+void work_queue_destroy(work_queue_t *queue, void (*drop)(request_t *req)) {
+    if (!queue) return;
+
+    if (queue->kind == QUEUE_RING) {
+        request_t *req;
+        while ((req = ring_try_pop(queue))) {
+            if (drop) drop(req);
+        }
+        free(queue->slots);
+    } else {
+        pthread_mutex_lock(&queue->mutex);
+
+        // Libera requisições pendentes
+        while (queue->count > 0) {
+            if (drop) drop(queue->queue[queue->front]);
+            queue->front = (queue->front + 1) % queue->capacity;
+            queue->count--;
+        }
+
+        pthread_mutex_unlock(&queue->mutex);
+
+        pthread_cond_destroy(&queue->not_empty);
+        pthread_cond_destroy(&queue->not_full);
+        pthread_mutex_destroy(&queue->mutex);
+        free(queue->queue);
+    }
+    free(queue);
+}
+
+static long long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+int work_queue_push(work_queue_t *queue, request_t *req) {
+    req->queued_us = now_us();
+    if (queue->kind == QUEUE_RING) return ring_push(queue, req, 1);
+    return mutex_push(queue, req, 1);
+}
+
+// Versão sem espera para o event loop: nunca bloqueia a thread do loop
+int work_queue_try_push(work_queue_t *queue, request_t *req) {
+    req->queued_us = now_us();
+    if (queue->kind == QUEUE_RING) return ring_push(queue, req, 0);
+    return mutex_push(queue, req, 0);
+}
+
+request_t* work_queue_pop(work_queue_t *queue, int timeout_ms) {
+    request_t *req = queue->kind == QUEUE_RING ? ring_pop(queue, timeout_ms)
+                                               : mutex_pop(queue, timeout_ms);
+    if (req) req->wait_us = now_us() - req->queued_us;
+    return req;
+}
+
+// Pedidos na fila agora (aproximado no ring: só para decidir crescer o pool)
+int work_queue_count(work_queue_t *queue) {
+    if (queue->kind == QUEUE_RING) {
+        size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+        size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+        return head > tail ? (int)(head - tail) : 0;
+    }
+    pthread_mutex_lock(&queue->mutex);
+    int count = queue->count;
+    pthread_mutex_unlock(&queue->mutex);
+    return count;
+}
+
+// Acorda todos os workers parados (chamar depois de g_running = 0)
+void work_queue_shutdown(work_queue_t *queue) {
+    if (queue->kind == QUEUE_RING) {
+        atomic_fetch_add_explicit(&queue->wake_seq, 1, memory_order_release);
+        futex(&queue->wake_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL);
+        atomic_fetch_add_explicit(&queue->space_seq, 1, memory_order_release);
+        futex(&queue->space_seq, FUTEX_WAKE_PRIVATE, INT_MAX, NULL);
+    } else {
+        pthread_mutex_lock(&queue->mutex);
+        pthread_cond_broadcast(&queue->not_empty);
+        pthread_cond_broadcast(&queue->not_full);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+}
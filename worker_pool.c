@@ -0,0 +1,162 @@
+#include "web_server.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// Pool de workers que acompanha a carga. Começa com min_workers; um
+// supervisor olha a cada POOL_TICK_MS quanto os pedidos esperaram na fila
+// e acrescenta workers (até max_workers) quando a espera passa do alvo.
+// Worker que fica idle_timeout_ms sem trabalho sai, sem descer do mínimo.
+
+#define POOL_TICK_MS 100
+
+static pool_config_t config;
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_empty = PTHREAD_COND_INITIALIZER;
+static int live;                        // workers vivos (protegido por pool_mutex)
+static int next_id;
+static _Atomic int idle;                // workers esperando na fila
+static _Atomic long long max_wait_us;   // maior espera na fila desde o último tick
+static pthread_t supervisor;
+static int supervisor_started;
+
+static void note_wait(long long wait_us) {
+    long long cur = atomic_load_explicit(&max_wait_us, memory_order_relaxed);
+    while (wait_us > cur &&
+           !atomic_compare_exchange_weak_explicit(&max_wait_us, &cur, wait_us,
+                                                  memory_order_relaxed, memory_order_relaxed)) {}
+}
+
+// Sai do pool; o último a sair libera worker_pool_stop
+static void worker_exit(void) {
+    pthread_mutex_lock(&pool_mutex);
+    if (--live == 0) pthread_cond_broadcast(&pool_empty);
+    pthread_mutex_unlock(&pool_mutex);
+}
+
+static void* worker_thread(void *arg) {
+    int thread_id = (int)(intptr_t)arg;
+
+    tslog_debugf(server.logger, "Worker thread #%d iniciada", thread_id);
+
+    for (;;) {
+        atomic_fetch_add_explicit(&idle, 1, memory_order_relaxed);
+        request_t *req = work_queue_pop(server.work_queue, config.idle_timeout_ms);
+        atomic_fetch_sub_explicit(&idle, 1, memory_order_relaxed);
+        if (req) {
+            note_wait(req->wait_us);
+            stats_time(STAT_QUEUE_WAIT, req->wait_us * 1000);
+            process_request(req);
+            continue;
+        }
+        if (!g_running) break;
+
+        // Ocioso pelo tempo configurado: sai se o pool está acima do mínimo.
+        // O log fica sob o lock: depois dele a thread não toca mais no servidor
+        pthread_mutex_lock(&pool_mutex);
+        int retire = live > config.min_workers;
+        if (retire) {
+            live--;
+            tslog_infof(server.logger, "[POOL] Worker #%d ocioso encerrado (%d ativos)",
+                        thread_id, live);
+        }
+        pthread_mutex_unlock(&pool_mutex);
+        if (retire) return NULL;
+    }
+
+    tslog_debugf(server.logger, "Worker thread #%d finalizando", thread_id);
+    worker_exit();
+    return NULL;
+}
+
+// Cria até count workers; chamar com pool_mutex travado
+static int spawn_locked(int count) {
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    int created = 0;
+    for (; created < count; created++) {
+        pthread_t thread;
+        intptr_t id = ++next_id;
+        if (pthread_create(&thread, &attr, worker_thread, (void *)id) != 0) break;
+        live++;
+    }
+    pthread_attr_destroy(&attr);
+    return created;
+}
+
+static void* supervisor_thread(void *arg) {
+    int stalled_ms = 0;
+
+    while (g_running) {
+        usleep(POOL_TICK_MS * 1000);
+        long long wait_ms = atomic_exchange_explicit(&max_wait_us, 0, memory_order_relaxed) / 1000;
+        int queued = work_queue_count(server.work_queue);
+
+        // Fila parada sem worker livre: ninguém tira pedidos para medir a
+        // espera (ex.: todos presos em conexões keep-alive), então conta o tempo
+        if (queued > 0 && atomic_load_explicit(&idle, memory_order_relaxed) == 0) {
+            stalled_ms += POOL_TICK_MS;
+        } else {
+            stalled_ms = 0;
+        }
+        if (wait_ms <= config.wait_target_ms && stalled_ms <= config.wait_target_ms) continue;
+
+        // Cresce 25% por tick (ao menos 1); com muitos pedidos parados na fila,
+        // até dobrar: acompanha uma rajada em poucos ticks
+        pthread_mutex_lock(&pool_mutex);
+        int add = live / 4 > 1 ? live / 4 : 1;
+        if (queued > add) add = queued < live ? queued : live;
+        if (add > config.max_workers - live) add = config.max_workers - live;
+        int created = add > 0 ? spawn_locked(add) : 0;
+        int total = live;
+        pthread_mutex_unlock(&pool_mutex);
+
+        if (created > 0) {
+            tslog_infof(server.logger, "[POOL] +%d workers (%d ativos): espera %lldms, %d na fila",
+                        created, total, wait_ms > stalled_ms ? wait_ms : (long long)stalled_ms, queued);
+        }
+        stalled_ms = 0;
+    }
+    return NULL;
+}
+
+int worker_pool_start(const pool_config_t *cfg) {
+    config = *cfg;
+
+    pthread_mutex_lock(&pool_mutex);
+    int created = spawn_locked(config.min_workers);
+    pthread_mutex_unlock(&pool_mutex);
+    if (created < config.min_workers) return -1;
+
+    // Pool fixo (min == max) dispensa o supervisor
+    if (config.max_workers > config.min_workers) {
+        if (pthread_create(&supervisor, NULL, supervisor_thread, NULL) != 0) return -1;
+        supervisor_started = 1;
+    }
+    return 0;
+}
+
+int worker_pool_size(void) {
+    pthread_mutex_lock(&pool_mutex);
+    int size = live;
+    pthread_mutex_unlock(&pool_mutex);
+    return size;
+}
+
+// Espera todos os workers saírem (chamar após g_running = 0 e work_queue_shutdown)
+void worker_pool_stop(void) {
+    if (supervisor_started) {
+        pthread_join(supervisor, NULL);
+        supervisor_started = 0;
+    }
+    pthread_mutex_lock(&pool_mutex);
+    while (live > 0) {
+        pthread_cond_wait(&pool_empty, &pool_mutex);
+    }
+    pthread_mutex_unlock(&pool_mutex);
+}